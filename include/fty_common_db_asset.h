@@ -24,10 +24,16 @@
 
 // Note: Consumers MUST be built with C++11 or newer standard due to this:
 #include "fty_common_db_defs.h"
+#include "fty_common_db_row.h"
+#include "fty_common_db_asset_generation.h"
 
 #ifdef __cplusplus
 namespace DBAssets {
 
+// STREAM_FETCH_SIZE: default number of rows fetched from cursor at once by
+// *_stream functions
+    static const unsigned STREAM_FETCH_SIZE = 100;
+
 // id_to_name_ext_name: converts database id to internal name and extended (unicode) name
 // returns empty pair of names if error occurs
     std::pair <std::string, std::string>
@@ -48,6 +54,18 @@ namespace DBAssets {
     int64_t
     name_to_asset_id (std::string asset_name);
 
+// names_to_asset_ids: converts list of asset internal names to database ids
+// resolves the whole list with one query per 256 names, ids are keyed by
+// names as the database stores them, which may differ from the given ones
+// in case and trailing spaces (see DBSql::fold),
+// names not found in database are appended to missing, empty names are ignored
+// returns -1 if error occurs, 0 otherwise
+    int
+    names_to_asset_ids (tntdb::Connection &conn,
+                        const std::vector <std::string> &names,
+                        std::map <std::string, uint32_t> &ids,
+                        std::vector <std::string> &missing);
+
 // name_to_asset_id_check_type: converts asset internal name to database id if asset is of a specified type
 // returns value < 0 if error ocurrs
     int64_t
@@ -58,6 +76,24 @@ namespace DBAssets {
     int
     extname_to_asset_name (std::string asset_ext_name, std::string &asset_name);
 
+// current_generation: generation of asset tables (see DBAssetGeneration),
+// it changes whenever a write function of DBAssetsInsert, DBAssetsUpdate or
+// DBAssetsDelete changes something
+// returns value < 0 if generation table does not exist or error occurs
+    int64_t
+    current_generation (tntdb::Connection &conn);
+
+// changes_since: stream changes of elements, links, group relations and ext
+// attributes made after generation to cb (see DBAssetGeneration), so a cache
+// loaded at generation is refreshed at the cost of the changes
+// returns the generation the cache is at after the changes,
+// DBAssetGeneration::CHANGES_TRIMMED if the cache must be loaded again,
+// -1 if change log does not exist or error occurs
+    int64_t
+    changes_since (tntdb::Connection &conn,
+                   uint64_t generation,
+                   DBAssetGeneration::change_cb_f cb);
+
 // --------------------------------------------------------------------
 
 // select_asset_element_super_parent: selects parents of given device
@@ -77,6 +113,17 @@ namespace DBAssets {
     select_asset_element_all_with_warranty_end (tntdb::Connection& conn,
                                                 std::function<void(const tntdb::Row&)>& cb);
 
+// select_asset_element_all_with_warranty_end_stream: the same as
+// select_asset_element_all_with_warranty_end, rows are fetched from server
+// side cursor fetch_size rows at a time and passed to cb as they arrive,
+// cb returns false to stop the scan
+// returns 0 if succesful
+// returns -1 if error occurs
+    int
+    select_asset_element_all_with_warranty_end_stream (tntdb::Connection& conn,
+                                                       row_stream_cb_f cb,
+                                                       unsigned fetch_size = STREAM_FETCH_SIZE);
+
 // select_assets_by_container: selects assets from given container (DB, room, rack, ...)
 // without - accepted values: "location", "powerchain" or empty string
 // returns 0 if succesful
@@ -102,6 +149,76 @@ namespace DBAssets {
                                 uint32_t element_id,
                                 std::function<void(const tntdb::Row&)> cb);
 
+// asset_row_view_t: typed row of select_assets_without_container and
+// select_assets_all_container (columns name, asset_id, type_id, subtype_id)
+    struct asset_row_view_t {
+        std::string name;
+        uint32_t    asset_id;
+        uint16_t    type_id;
+        uint16_t    subtype_id;
+
+        typedef DBRow::fields <
+            DBROW_FIELD (0, asset_row_view_t, name),
+            DBROW_FIELD (1, asset_row_view_t, asset_id),
+            DBROW_FIELD (2, asset_row_view_t, type_id),
+            DBROW_FIELD (3, asset_row_view_t, subtype_id)> fields;
+    };
+
+// container_row_view_t: typed row of select_assets_by_container
+// (columns name, asset_id, subtype_id, subtype_name, type_id)
+    struct container_row_view_t {
+        std::string name;
+        uint32_t    asset_id;
+        uint16_t    subtype_id;
+        std::string subtype_name;
+        uint16_t    type_id;
+
+        typedef DBRow::fields <
+            DBROW_FIELD (0, container_row_view_t, name),
+            DBROW_FIELD (1, container_row_view_t, asset_id),
+            DBROW_FIELD (2, container_row_view_t, subtype_id),
+            DBROW_FIELD (3, container_row_view_t, subtype_name),
+            DBROW_FIELD (4, container_row_view_t, type_id)> fields;
+    };
+
+// select_assets_by_container_result: the same as select_assets_by_container,
+// cb is called once per result with columns
+// name, asset_id, subtype_id, subtype_name, type_id
+    int
+    select_assets_by_container_result (tntdb::Connection &conn,
+                                       uint32_t element_id,
+                                       std::vector<uint16_t> types,
+                                       std::vector<uint16_t> subtypes,
+                                       const std::string &without,
+                                       const std::string &status,
+                                       result_cb_f cb);
+
+// select_assets_by_container <View>: the same as select_assets_by_container,
+// every row is decoded into View and passed to f (const View&)
+    template <typename View, typename F>
+    int
+    select_assets_by_container (tntdb::Connection &conn,
+                                uint32_t element_id,
+                                std::vector<uint16_t> types,
+                                std::vector<uint16_t> subtypes,
+                                const std::string &without,
+                                const std::string &status,
+                                F f)
+    {
+        static_assert (View::fields::columns <= 5, "view binds column not selected by the query");
+        return select_assets_by_container_result (conn, element_id, types, subtypes,
+                                                  without, status, DBRow::each <View> (f));
+    }
+
+    template <typename View, typename F>
+    int
+    select_assets_by_container (tntdb::Connection &conn,
+                                uint32_t element_id,
+                                F f)
+    {
+        return select_assets_by_container <View> (conn, element_id, {}, {}, "", "", f);
+    }
+
 // select_assets_by_container_name_filter: select assets of given types/subtypes from container with a given name
 // return 0 on success (even if nothing was found)
 // returns -1 if error occurs
@@ -128,6 +245,27 @@ namespace DBAssets {
                                      std::vector<uint16_t> subtypes,
                                      std::function<void(const tntdb::Row&)> cb);
 
+// select_assets_without_container_result: the same as select_assets_without_container,
+// cb is called once per result with columns name, asset_id, type_id, subtype_id
+    int
+    select_assets_without_container_result (tntdb::Connection &conn,
+                                            std::vector<uint16_t> types,
+                                            std::vector<uint16_t> subtypes,
+                                            result_cb_f cb);
+
+// select_assets_without_container <View>: every row is decoded into View and
+// passed to f (const View&)
+    template <typename View, typename F>
+    int
+    select_assets_without_container (tntdb::Connection &conn,
+                                     std::vector<uint16_t> types,
+                                     std::vector<uint16_t> subtypes,
+                                     F f)
+    {
+        static_assert (View::fields::columns <= 4, "view binds column not selected by the query");
+        return select_assets_without_container_result (conn, types, subtypes, DBRow::each <View> (f));
+    }
+
 // select_assets_all_container: selects all assets (with and wihout container)
 // return 0 on success (even if nothing was found)
 // returns -1 if error occurs
@@ -139,6 +277,46 @@ namespace DBAssets {
                                  const std::string &status,
                                  std::function<void(const tntdb::Row&)> cb);
 
+// select_assets_all_container_result: the same as select_assets_all_container,
+// cb is called once per result with columns name, asset_id, type_id, subtype_id
+    int
+    select_assets_all_container_result (tntdb::Connection &conn,
+                                        std::vector<uint16_t> types,
+                                        std::vector<uint16_t> subtypes,
+                                        const std::string &without,
+                                        const std::string &status,
+                                        result_cb_f cb);
+
+// select_assets_all_container <View>: every row is decoded into View and
+// passed to f (const View&)
+    template <typename View, typename F>
+    int
+    select_assets_all_container (tntdb::Connection &conn,
+                                 std::vector<uint16_t> types,
+                                 std::vector<uint16_t> subtypes,
+                                 const std::string &without,
+                                 const std::string &status,
+                                 F f)
+    {
+        static_assert (View::fields::columns <= 4, "view binds column not selected by the query");
+        return select_assets_all_container_result (conn, types, subtypes, without, status,
+                                                   DBRow::each <View> (f));
+    }
+
+// select_assets_all_container_stream: the same as select_assets_all_container,
+// rows are fetched from server side cursor fetch_size rows at a time and
+// passed to cb as they arrive, cb returns false to stop the scan
+// return 0 on success (even if nothing was found or scan was stopped)
+// returns -1 if error occurs
+    int
+    select_assets_all_container_stream (tntdb::Connection &conn,
+                                        std::vector<uint16_t> types,
+                                        std::vector<uint16_t> subtypes,
+                                        const std::string &without,
+                                        const std::string &status,
+                                        row_stream_cb_f cb,
+                                        unsigned fetch_size = STREAM_FETCH_SIZE);
+
 // select_asset_element_by_dc: select everything under a specified DC from v_web_element
 // returns -1 in case of error or 0 for success
     int
@@ -152,6 +330,33 @@ namespace DBAssets {
     select_asset_element_all (tntdb::Connection& conn,
                               std::function<void(const tntdb::Row&)>& cb);
 
+// select_asset_element_all_result: the same as select_asset_element_all,
+// cb is called once with columns id, name, type_name, subtype_name,
+// id_parent, id_parent_type, status, priority, asset_tag
+    int
+    select_asset_element_all_result (tntdb::Connection& conn,
+                                     result_cb_f cb);
+
+// select_asset_element_all <View>: every row is decoded into View and
+// passed to f (const View&)
+    template <typename View, typename F>
+    int
+    select_asset_element_all (tntdb::Connection& conn,
+                              F f)
+    {
+        static_assert (View::fields::columns <= 9, "view binds column not selected by the query");
+        return select_asset_element_all_result (conn, DBRow::each <View> (f));
+    }
+
+// select_asset_element_all_stream: the same as select_asset_element_all,
+// rows are fetched from server side cursor fetch_size rows at a time and
+// passed to cb as they arrive, cb returns false to stop the scan
+// returns -1 in case of error or 0 for success
+    int
+    select_asset_element_all_stream (tntdb::Connection& conn,
+                                     row_stream_cb_f cb,
+                                     unsigned fetch_size = STREAM_FETCH_SIZE);
+
 // convert_asset_to_monitor: converts asset id to monitor id
 // return  0 on success (even if counterpart was not found)
 // returns -1 if error occurs
@@ -239,6 +444,69 @@ namespace DBAssets {
     select_ext_attributes_cb (tntdb::Connection &conn,
                            uint32_t asset_id,
                            std::function<void(const tntdb::Row&)> cb);
+
+// ext_attribute_t: typed row of select_ext_attributes_of and
+// select_ext_attributes_in_container (columns element_id, keytag, value, read_only)
+    struct ext_attribute_t {
+        uint32_t    element_id;
+        std::string keytag;
+        std::string value;
+        bool        read_only;
+
+        typedef DBRow::fields <
+            DBROW_FIELD (0, ext_attribute_t, element_id),
+            DBROW_FIELD (1, ext_attribute_t, keytag),
+            DBROW_FIELD (2, ext_attribute_t, value),
+            DBROW_FIELD (3, ext_attribute_t, read_only)> fields;
+    };
+
+// select_ext_attributes_of_result: select ext attributes of given assets,
+// ids are chunked by DBSql::MAX_IN_LIST, cb is called once per chunk with
+// columns element_id, keytag, value, read_only, rows come in element order
+// returns -1 in case of error or 0 for success
+    int
+    select_ext_attributes_of_result (tntdb::Connection &conn,
+                                     const std::vector <uint32_t> &ids,
+                                     result_cb_f cb);
+
+// select_ext_attributes_of <View>: the same as select_ext_attributes_of_result,
+// every row is decoded into View and passed to f (const View&)
+    template <typename View, typename F>
+    int
+    select_ext_attributes_of (tntdb::Connection &conn,
+                              const std::vector <uint32_t> &ids,
+                              F f)
+    {
+        static_assert (View::fields::columns <= 4, "view binds column not selected by the query");
+        return select_ext_attributes_of_result (conn, ids, DBRow::each <View> (f));
+    }
+
+// select_ext_attributes_of: ext attributes of given assets in one flat list,
+// in element order
+// returns -1 in case of error or 0 for success
+    int
+    select_ext_attributes_of (tntdb::Connection &conn,
+                              const std::vector <uint32_t> &ids,
+                              std::vector <ext_attribute_t> &out);
+
+// select_ext_attributes_in_container_result: the same as
+// select_ext_attributes_of_result for all assets in container (at any depth,
+// without the container itself)
+// returns -1 in case of error or 0 for success
+    int
+    select_ext_attributes_in_container_result (tntdb::Connection &conn,
+                                               uint32_t container_id,
+                                               result_cb_f cb);
+
+    template <typename View, typename F>
+    int
+    select_ext_attributes_in_container (tntdb::Connection &conn,
+                                        uint32_t container_id,
+                                        F f)
+    {
+        static_assert (View::fields::columns <= 4, "view binds column not selected by the query");
+        return select_ext_attributes_in_container_result (conn, container_id, DBRow::each <View> (f));
+    }
 // select_asset_element_basic_cb: select all data about asset from v_web_element, process with cb
 // return -1 in case of error or asset not found, 0 otherwise
 
@@ -252,6 +520,32 @@ namespace DBAssets {
     int
     select_assets_cb (tntdb::Connection &conn,
                       std::function<void(const tntdb::Row&)> cb);
+
+// select_assets_result: the same as select_assets_cb, cb is called once with
+// columns name, id, id_type, id_subtype, id_parent, parent_name, status,
+// priority, asset_tag
+    int
+    select_assets_result (tntdb::Connection &conn,
+                          result_cb_f cb);
+
+// select_assets <View>: every row is decoded into View and passed to f (const View&)
+    template <typename View, typename F>
+    int
+    select_assets (tntdb::Connection &conn,
+                   F f)
+    {
+        static_assert (View::fields::columns <= 9, "view binds column not selected by the query");
+        return select_assets_result (conn, DBRow::each <View> (f));
+    }
+
+// select_assets_stream: the same as select_assets_cb, rows are fetched from
+// server side cursor fetch_size rows at a time and passed to cb as they
+// arrive, cb returns false to stop the scan
+// return -1 in case of error, 0 otherwise
+    int
+    select_assets_stream (tntdb::Connection &conn,
+                          row_stream_cb_f cb,
+                          unsigned fetch_size = STREAM_FETCH_SIZE);
 // --------------------------------------------------------------------
 
 // select_monitor_device_type_id: select id based on name from v_bios_device_type
@@ -290,6 +584,41 @@ namespace DBAssets {
     select_asset_element_groups (tntdb::Connection &conn,
                                  uint32_t element_id);
 
+// WEB_ELEMENT_PARTS: parts of db_web_element_t loaded by select_web_element_full,
+// in order basic, groups, powers, ext and parents
+    static const unsigned WEB_ELEMENT_PARTS = 5;
+
+// web_element_timing_t: time spent by select_web_element_full, query_us in the
+// round trip to database, decode_us [part] in decoding rows of each part
+    struct web_element_timing_t {
+        uint64_t query_us;
+        uint64_t decode_us [WEB_ELEMENT_PARTS];
+    };
+
+// select_web_element_full: select everything about asset in one query, the
+// same data as select_asset_element_web_byId, select_asset_element_groups,
+// select_asset_device_links_to (INPUT_POWER_CHAIN), select_ext_attributes
+// and select_asset_element_super_parent together
+// parents are ordered from the nearest one and hold (id, name, type, subtype)
+// timing is filled if not nullptr
+// db_reply.status == 0 means error or not found, 1 means success
+
+    db_reply <db_web_element_t>
+    select_web_element_full (tntdb::Connection &conn,
+                             uint32_t element_id,
+                             web_element_timing_t *timing = nullptr);
+
+// select_web_elements_full: the same as select_web_element_full for many
+// assets, with one query per part for each MAX_IN_LIST assets
+// elements follow the order of ids, ids not found are left out
+// timing is filled if not nullptr, with totals of all queries
+// db_reply.status == 0 means error, 1 means success
+
+    db_reply <std::vector <db_web_element_t>>
+    select_web_elements_full (tntdb::Connection &conn,
+                              const std::vector <uint32_t> &ids,
+                              web_element_timing_t *timing = nullptr);
+
 // select_short_elements: select all devices of certain type/subtype
 // db_reply.status == 0 means error or not found, 1 means success
 
@@ -0,0 +1,73 @@
+/*  =========================================================================
+    fty_common_db_asset_closure - Closure table of asset containment
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef FTY_COMMON_DB_ASSET_CLOSURE_H_INCLUDED
+#define FTY_COMMON_DB_ASSET_CLOSURE_H_INCLUDED
+
+#ifdef __cplusplus
+#include <inttypes.h>
+#include <tntdb/connect.h>
+
+// Table t_bios_asset_element_closure has one row (ancestor, descendant, depth)
+// for every element and each of its containers, plus (element, element, 0).
+// Unlike v_bios_asset_element_super_parent it is indexed and has no limit
+// of depth. The table is optional: once it exists (see create), write
+// functions of DBAssetsInsert, DBAssetsUpdate and DBAssetsDelete maintain
+// it on the connection they are given, so in the transaction of the caller,
+// and the container queries of DBAssets join it instead of scanning the view.
+// All processes writing assets must use this version of the library.
+namespace DBAssetClosure {
+
+// available: returns true if the closure table exists and is complete
+// (create finished); "not available" is remembered for a few seconds only
+    bool
+    available (tntdb::Connection &conn);
+
+// create: create the closure table if it does not exist, wait for writers
+// which did not maintain it (a few seconds at least), fill it and make it
+// available; conn must not be in a transaction
+// returns 0 on success, -1 if error occurs
+    int
+    create (tntdb::Connection &conn);
+
+// rebuild: refill the closure table from t_bios_asset_element
+// returns 0 on success, -1 if error occurs
+    int
+    rebuild (tntdb::Connection &conn);
+
+// element_inserted: add rows of new element, throws on database error
+// element_* functions do nothing if the closure table does not exist
+    void
+    element_inserted (tntdb::Connection &conn, uint32_t id, uint32_t parent_id);
+
+// element_moved: move element with its subtree under new parent (0 = no
+// parent), does nothing if parent did not change, throws on database error
+    void
+    element_moved (tntdb::Connection &conn, uint32_t id, uint32_t parent_id);
+
+// element_deleted: remove rows of deleted element, throws on database error
+    void
+    element_deleted (tntdb::Connection &conn, uint32_t id);
+
+} // namespace
+
+#endif // __cplusplus
+#endif // FTY_COMMON_DB_ASSET_CLOSURE_H_INCLUDED
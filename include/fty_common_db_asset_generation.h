@@ -0,0 +1,113 @@
+/*  =========================================================================
+    fty_common_db_asset_generation - Generation counter of asset tables
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+
+#ifndef FTY_COMMON_DB_ASSET_GENERATION_H_INCLUDED
+#define FTY_COMMON_DB_ASSET_GENERATION_H_INCLUDED
+
+#ifdef __cplusplus
+#include <inttypes.h>
+#include <functional>
+#include <vector>
+#include <tntdb/connect.h>
+#include "fty_common_db_change_notify.h"
+
+// Table t_bios_asset_generation has a row with a counter increased by every
+// write function of DBAssetsInsert, DBAssetsUpdate and DBAssetsDelete which
+// changed something, on the connection it is given, so in the transaction
+// of the caller. A cache remembers the generation it was loaded at and is
+// valid as long as DBAssets::current_generation returns the same value.
+// Table t_bios_asset_change_log keeps the changes with the generation which
+// made them, so the cache can be refreshed by changes_since instead of
+// loading everything again. Both tables are optional (see create), like the
+// closure table. All processes writing assets must use this version of the
+// library.
+namespace DBAssetGeneration {
+
+// CHANGES_TRIMMED: returned by changes_since if changes after the given
+// generation were trimmed, cache must be loaded again
+static const int64_t CHANGES_TRIMMED = -2;
+
+// change_cb_f: receives change and generation which made it
+typedef std::function <void (const DBChangeNotify::change_t &change, uint64_t generation)> change_cb_f;
+
+// available: returns true if the generation table exists
+// "does not exist" is remembered for a few seconds only
+    bool
+    available (tntdb::Connection &conn);
+
+// log_available: returns true if the change log table exists
+// "does not exist" is remembered for a few seconds only
+    bool
+    log_available (tntdb::Connection &conn);
+
+// create: create the generation and change log tables if they do not exist,
+// wait for writers which did not bump the generation (a few seconds at
+// least) and start a new one;
+// caches validated before must be loaded again; conn must not be in
+// a transaction
+// returns 0 on success, -1 if error occurs
+    int
+    create (tntdb::Connection &conn);
+
+// current: returns the generation, or -1 if the table does not exist or
+// error occurs
+    int64_t
+    current (tntdb::Connection &conn);
+
+// bump: increase the generation, throws on database error
+// the row stays locked until the transaction of conn ends, so concurrent
+// writers are serialized
+    void
+    bump (tntdb::Connection &conn);
+
+// changed: record changes made by write function: append them to the change
+// log at the next generation, bump the generation and queue them for
+// publishing after commit (see DBChangeNotify), throws on database error
+    void
+    changed (tntdb::Connection &conn,
+             const std::vector <DBChangeNotify::change_t> &changes);
+
+    void
+    changed (tntdb::Connection &conn,
+             DBChangeNotify::table_t table,
+             DBChangeNotify::kind_t kind,
+             uint32_t id);
+
+// changes_since: pass changes made after generation to cb, in the order in
+// which they were made, the same row may be changed more times
+// returns the generation the changes lead to, CHANGES_TRIMMED if some of
+// them were trimmed, -1 if change log does not exist or error occurs
+    int64_t
+    changes_since (tntdb::Connection &conn,
+                   uint64_t generation,
+                   change_cb_f cb);
+
+// trim_changes: delete changes made up to generation
+// returns 0 on success, -1 if error occurs
+    int
+    trim_changes (tntdb::Connection &conn,
+                  uint64_t generation);
+
+} // namespace
+
+#endif // __cplusplus
+#endif // FTY_COMMON_DB_ASSET_GENERATION_H_INCLUDED
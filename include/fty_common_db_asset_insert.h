@@ -49,6 +49,19 @@ namespace DBAssetsInsert {
                                       bool read_only,
                                       std::string &err);
 
+// insert_into_asset_ext_attributes: multi value insert of (keytag, value) pairs,
+// in chunks of DBSql::insert_chunk rows (statements of a few sizes, which
+// are cached), all chunks in one transaction; existing attributes are kept
+// affected receives number of rows affected by each chunk
+// returns error if input params are unacceptable or any chunk failed, nothing
+// is inserted then
+    db_reply_t
+    insert_into_asset_ext_attributes (tntdb::Connection &conn,
+                                      uint32_t element_id,
+                                      const std::vector <std::pair <std::string, std::string>> &attributes,
+                                      bool read_only,
+                                      std::vector <size_t> &affected);
+
 //////////////////////////////////////////////////////////////////////////////
 // insert_asset_element_into_asset_group: insert group<->asset relation
 // returns error if input params are unacceptable or insert went wrong
@@ -80,6 +93,15 @@ namespace DBAssetsInsert {
     insert_into_asset_links (tntdb::Connection &conn,
                              std::vector <link_t> const &links);
 
+// insert_into_asset_links: insert info about more powerlinks by multi-row inserts
+// status of every link is stored at the same index in statuses
+// (rowid of single links is not filled)
+// returns error if input params are unacceptable or any insert went wrong
+    db_reply_t
+    insert_into_asset_links (tntdb::Connection &conn,
+                             std::vector <link_t> const &links,
+                             std::vector <db_reply_t> &statuses);
+
 // insert_into_asset_links: insert info about more powerlinks
 // returns error if input params are unacceptable or any insert went wrong
     db_reply_t
@@ -0,0 +1,111 @@
+/*  =========================================================================
+    fty_common_db_asset_names - In-process dictionary of asset names
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+
+#ifndef FTY_COMMON_DB_ASSET_NAMES_H_INCLUDED
+#define FTY_COMMON_DB_ASSET_NAMES_H_INCLUDED
+
+#ifdef __cplusplus
+#include <inttypes.h>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <tntdb/connection.h>
+
+// Process-wide dictionary internal name <-> id <-> extended name, used by
+// the DBAssets resolver functions (name_to_asset_id, id_to_name_ext_name, ...)
+// to answer from memory. Names are matched like the database does, without
+// case and trailing spaces, and returned as the database stores them.
+// Dictionary is disabled by default, resolvers then always ask the database;
+// when enabled, it is loaded in background (see DBAsync) together with the
+// generation of asset tables (see DBAssetGeneration), and answers only to
+// callers which see the same generation. Without the generation table the
+// dictionary is never used.
+namespace DBAssetNames {
+
+struct stats_t {
+    uint64_t hits;          // lookups answered from memory
+    uint64_t misses;        // lookups which had to ask the database
+    uint64_t loads;         // dictionary loaded from the database
+    size_t   entries;       // number of assets currently known
+};
+
+// enable: turn the dictionary on or off, turning it off drops all entries
+    void
+    enable (bool on);
+
+// enabled: returns true if dictionary is turned on
+    bool
+    enabled ();
+
+// load: (re)build the dictionary from t_bios_asset_element now, in a
+// transaction of conn, which must not be in another one
+// returns 0 on success, -1 if error occurs
+    int
+    load (tntdb::Connection &conn);
+
+// build: (re)build the dictionary from list of (id, name, extended name,
+// has extended name) as it was at generation
+    void
+    build (const std::vector <std::tuple <uint32_t, std::string, std::string, bool>> &assets,
+           int64_t generation);
+
+// invalidate: drop all entries, they are loaded again on next use
+    void
+    invalidate ();
+
+// find_id: find database id of asset by internal name, if dictionary was
+// loaded at generation; starts loading in background if it is older
+// returns false if not known (or dictionary is disabled)
+    bool
+    find_id (int64_t generation, const std::string &name, uint32_t &id);
+
+// find_id_by_extname: find database id of asset by extended name, which
+// only one asset has
+// returns false if not known (or dictionary is disabled)
+    bool
+    find_id_by_extname (int64_t generation, const std::string &ext_name, uint32_t &id);
+
+// find_name: find internal name of asset by database id
+// returns false if not known (or dictionary is disabled)
+    bool
+    find_name (int64_t generation, uint32_t id, std::string &name);
+
+// find_extname: find extended name of asset by database id
+// returns false if not known (or dictionary is disabled)
+    bool
+    find_extname (int64_t generation, uint32_t id, std::string &ext_name);
+
+// stats: returns hit/miss counters and size of the dictionary
+    stats_t
+    stats ();
+
+// reset_stats: set hit/miss/load counters to zero
+    void
+    reset_stats ();
+
+} // namespace
+
+void
+fty_common_db_asset_names_test (bool verbose);
+
+#endif // __cplusplus
+#endif // FTY_COMMON_DB_ASSET_NAMES_H_INCLUDED
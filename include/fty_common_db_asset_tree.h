@@ -0,0 +1,88 @@
+/*  =========================================================================
+    fty_common_db_asset_tree - In-memory index of asset containment
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef FTY_COMMON_DB_ASSET_TREE_H_INCLUDED
+#define FTY_COMMON_DB_ASSET_TREE_H_INCLUDED
+
+#ifdef __cplusplus
+#include <inttypes.h>
+#include <utility>
+#include <vector>
+#include <tntdb/connect.h>
+
+// Process-wide index of the id_parent relation of t_bios_asset_element.
+// Elements are numbered in depth-first order, so all descendants of a
+// container are one contiguous range of that order, without any limit
+// of depth. Index is disabled by default; when enabled, the container
+// queries of DBAssets use it instead of the id_parent1 .. id_parent10
+// columns of v_bios_asset_element_super_parent. It is loaded in background
+// (see DBAsync) together with the generation of asset tables (see
+// DBAssetGeneration), and answers only to callers which see the same
+// generation. Without the generation table the index is never used.
+namespace DBAssetTree {
+
+// enable: turn the index on or off, turning it off drops it
+    void
+    enable (bool on);
+
+// enabled: returns true if index is turned on
+    bool
+    enabled ();
+
+// load: (re)build the index from t_bios_asset_element now, in a
+// transaction of conn, which must not be in another one
+// returns 0 on success, -1 if error occurs
+    int
+    load (tntdb::Connection &conn);
+
+// build: (re)build the index from list of (id, parent id) pairs as it was
+// at generation, parent id 0 means element without parent
+    void
+    build (const std::vector <std::pair <uint32_t, uint32_t>> &elements,
+           int64_t generation);
+
+// invalidate: drop the index, it is loaded again on next use
+    void
+    invalidate ();
+
+// descendants: ids of all elements contained in given container, directly
+// or through any number of levels, in depth-first order, if index was
+// loaded at the generation conn sees; starts loading in background if it
+// is older
+// returns 0 on success, -1 if index is disabled or not loaded at the generation
+    int
+    descendants (tntdb::Connection &conn,
+                 uint32_t container_id,
+                 std::vector <uint32_t> &out);
+
+// descendants: the same as above for known generation
+    int
+    descendants (int64_t generation,
+                 uint32_t container_id,
+                 std::vector <uint32_t> &out);
+
+} // namespace
+
+void
+fty_common_db_asset_tree_test (bool verbose);
+
+#endif // __cplusplus
+#endif // FTY_COMMON_DB_ASSET_TREE_H_INCLUDED
@@ -0,0 +1,255 @@
+/*  =========================================================================
+    fty_common_db_async - Asynchronous execution of database requests
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef FTY_COMMON_DB_ASYNC_H_INCLUDED
+#define FTY_COMMON_DB_ASYNC_H_INCLUDED
+
+#ifdef __cplusplus
+#include <inttypes.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <tntdb/connection.h>
+#include "fty_common_db_defs.h"
+
+// Runs database functions in worker threads and hands results back in
+// std::future, so an agent with an event loop does not block on the
+// database. Every worker takes a connection of the pool (see DBConn) for
+// each request; pool returns a thread the connection it used last time, so
+// a worker keeps its connection and prepared statements.
+// The queue is bounded: submit waits while it is full, try_submit and the
+// _async functions fail the request with queue_full instead, so the caller
+// sees the database falling behind and never blocks.
+namespace DBAsync {
+
+static const size_t DEFAULT_WORKERS = 4;
+static const size_t DEFAULT_CAPACITY = 1024;
+
+// cancelled: set to future of request cancelled before it started
+class cancelled : public std::runtime_error {
+    public:
+        cancelled () : std::runtime_error ("database request cancelled") {}
+};
+
+// queue_full: set to future of request refused by try_submit or after
+// executor is stopped
+class queue_full : public std::runtime_error {
+    public:
+        queue_full () : std::runtime_error ("queue of database requests is full") {}
+};
+
+// cancel_t: token shared by caller and request; request cancelled before
+// a worker takes it is not run, request already running is finished
+class cancel_t {
+    public:
+        cancel_t () : m_flag (std::make_shared <std::atomic <bool>> (false)) {}
+
+        void cancel () { *m_flag = true; }
+        bool cancelled () const { return *m_flag; }
+
+    private:
+        std::shared_ptr <std::atomic <bool>> m_flag;
+};
+
+struct executor_stats_t {
+    uint64_t submitted;    // requests accepted to the queue
+    uint64_t rejected;     // requests refused because queue was full
+    uint64_t cancelled;    // requests not run because of cancel
+    uint64_t completed;    // requests taken by workers to run
+    size_t   pending;      // requests waiting in the queue
+    size_t   max_pending;  // the longest queue seen
+};
+
+// executor_t: pool of workers with bounded queue of requests
+// function f of request is called as f (tntdb::Connection&), its return
+// value or exception is set to the future
+// with no workers requests wait in the queue until destructor cancels them
+class executor_t {
+    public:
+        explicit executor_t (size_t workers = DEFAULT_WORKERS,
+                             size_t capacity = DEFAULT_CAPACITY);
+        // stop: requests in the queue are cancelled, running ones finished
+        ~executor_t ();
+
+        executor_t (const executor_t&) = delete;
+        executor_t& operator= (const executor_t&) = delete;
+
+        // submit: queue request, wait while the queue is full
+        template <typename F>
+        std::future <typename std::result_of <F (tntdb::Connection&)>::type>
+        submit (F f, cancel_t cancel = cancel_t ())
+        {
+            return enqueue (std::move (f), std::move (cancel), true);
+        }
+
+        // try_submit: queue request, if the queue is full the future
+        // holds queue_full exception
+        template <typename F>
+        std::future <typename std::result_of <F (tntdb::Connection&)>::type>
+        try_submit (F f, cancel_t cancel = cancel_t ())
+        {
+            return enqueue (std::move (f), std::move (cancel), false);
+        }
+
+        size_t
+        workers () const { return m_workers.size (); }
+
+        size_t
+        capacity () const { return m_capacity; }
+
+        size_t
+        pending () const;
+
+        executor_stats_t
+        stats () const;
+
+    private:
+        struct task_t {
+            std::function <void (tntdb::Connection&)> run;
+            std::function <void (std::exception_ptr)> fail;
+            cancel_t cancel;
+        };
+
+        template <typename R, typename F>
+        static void
+        fulfil (std::promise <R> &promise, F &f, tntdb::Connection &conn)
+        {
+            try {
+                promise.set_value (f (conn));
+            }
+            catch (...) {
+                promise.set_exception (std::current_exception ());
+            }
+        }
+
+        template <typename F>
+        static void
+        fulfil (std::promise <void> &promise, F &f, tntdb::Connection &conn)
+        {
+            try {
+                f (conn);
+                promise.set_value ();
+            }
+            catch (...) {
+                promise.set_exception (std::current_exception ());
+            }
+        }
+
+        template <typename F>
+        std::future <typename std::result_of <F (tntdb::Connection&)>::type>
+        enqueue (F f, cancel_t cancel, bool wait)
+        {
+            typedef typename std::result_of <F (tntdb::Connection&)>::type R;
+            auto promise = std::make_shared <std::promise <R>> ();
+            std::future <R> ret = promise->get_future ();
+            task_t task;
+            task.run = [promise, f] (tntdb::Connection &conn) mutable {
+                fulfil (*promise, f, conn);
+            };
+            task.fail = [promise] (std::exception_ptr e) {
+                promise->set_exception (e);
+            };
+            task.cancel = std::move (cancel);
+            if (!push (task, wait))
+                promise->set_exception (std::make_exception_ptr (queue_full ()));
+            return ret;
+        }
+
+        // push: returns false if task was not queued
+        bool
+        push (task_t &task, bool wait);
+
+        void
+        work ();
+
+        const size_t m_capacity;
+        mutable std::mutex m_mutex;
+        std::condition_variable m_not_empty;
+        std::condition_variable m_not_full;
+        std::deque <task_t> m_queue;
+        std::vector <std::thread> m_workers;
+        bool m_stopping;
+        executor_stats_t m_stats;
+};
+
+// executor: process-wide executor with DEFAULT_WORKERS workers, used by
+// the _async functions; created on first use
+    executor_t &
+    executor ();
+
+// the same as DBAssets, DBAssetsInsert and DBAssetsDelete functions of the
+// same name without _async, run by executor () with try_submit
+    std::future <db_reply <db_web_basic_element_t>>
+    select_asset_element_web_byId_async (uint32_t element_id,
+                                         cancel_t cancel = cancel_t ());
+
+    std::future <db_reply <db_web_basic_element_t>>
+    select_asset_element_web_byName_async (const std::string &element_name,
+                                           cancel_t cancel = cancel_t ());
+
+    std::future <db_reply <std::map <std::string, std::pair<std::string, bool>>>>
+    select_ext_attributes_async (uint32_t element_id,
+                                 cancel_t cancel = cancel_t ());
+
+    std::future <db_reply <std::vector <db_tmp_link_t>>>
+    select_asset_device_links_to_async (uint32_t element_id,
+                                        uint8_t link_type_id,
+                                        cancel_t cancel = cancel_t ());
+
+    std::future <db_reply <std::map <uint32_t, std::string> >>
+    select_asset_element_groups_async (uint32_t element_id,
+                                       cancel_t cancel = cancel_t ());
+
+    std::future <db_reply <db_web_element_t>>
+    select_web_element_full_async (uint32_t element_id,
+                                   cancel_t cancel = cancel_t ());
+
+    std::future <db_reply <std::vector <db_web_element_t>>>
+    select_web_elements_full_async (const std::vector <uint32_t> &ids,
+                                    cancel_t cancel = cancel_t ());
+
+    std::future <db_reply_t>
+    insert_into_asset_ext_attributes_async (uint32_t element_id,
+                                            const std::vector <std::pair <std::string, std::string>> &attributes,
+                                            bool read_only,
+                                            cancel_t cancel = cancel_t ());
+
+    std::future <db_reply_t>
+    delete_asset_element_async (uint32_t asset_element_id,
+                                cancel_t cancel = cancel_t ());
+
+} // namespace
+
+void
+fty_common_db_async_test (bool verbose);
+
+#endif // __cplusplus
+#endif // FTY_COMMON_DB_ASYNC_H_INCLUDED
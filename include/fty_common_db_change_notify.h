@@ -0,0 +1,178 @@
+/*  =========================================================================
+    fty_common_db_change_notify - Change notifications of asset tables
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef FTY_COMMON_DB_CHANGE_NOTIFY_H_INCLUDED
+#define FTY_COMMON_DB_CHANGE_NOTIFY_H_INCLUDED
+
+#ifdef __cplusplus
+#include <inttypes.h>
+#include <string>
+#include <vector>
+
+// Optional publisher of changes made by write functions of DBAssetsInsert,
+// DBAssetsUpdate and DBAssetsDelete, so other processes can drop what they
+// cached instead of polling the database. Every change is a record of
+// table, kind and id; id 0 means unknown rows of the table changed.
+// Write functions never publish, they may run in a transaction of the
+// caller which is not committed yet. Changes wait in the calling thread
+// until the caller commits batch_t it holds, or calls publish after its
+// transaction was committed (or after write functions without transaction
+// returned), so subscribers never see changes which are not visible to
+// them yet.
+// Publishing is best effort: a subscriber which misses messages of a
+// publisher gets a change of unknown elements, which drops everything.
+namespace DBChangeNotify {
+
+enum table_t {
+    ELEMENT       = 1,  // t_bios_asset_element, id of element
+    LINK          = 2,  // t_bios_asset_link, id of destination element
+    GROUP         = 3,  // t_bios_asset_group_relation, id of group
+    EXT_ATTRIBUTE = 4   // t_bios_asset_ext_attributes, id of element
+};
+
+enum kind_t {
+    INSERTED = 1,
+    UPDATED  = 2,
+    DELETED  = 3
+};
+
+struct change_t {
+    table_t  table;
+    kind_t   kind;
+    uint32_t id;
+
+    bool operator== (const change_t &other) const
+    {
+        return table == other.table && kind == other.kind && id == other.id;
+    }
+};
+
+// TOPIC: first frame of every message
+static const char TOPIC [] = "FTY-DB-CHANGES";
+
+// batch_t: collect changes of this thread until commit, which must be
+// called after the transaction is committed; changes not committed are
+// dropped by destructor; nested batch commits to outer one
+class batch_t {
+    public:
+        batch_t ();
+        ~batch_t ();
+
+        batch_t (const batch_t&) = delete;
+        batch_t& operator= (const batch_t&) = delete;
+
+        void
+        commit ();
+
+    private:
+        friend void changed (table_t, kind_t, uint32_t);
+
+        batch_t *m_outer;
+        std::vector <change_t> m_changes;
+};
+
+// start_publisher: publish changes on czmq endpoint, for example
+// "ipc://@/fty-db-changes-agent"; replaces previous publisher
+// returns 0 on success, -1 if socket can't be created
+    int
+    start_publisher (const std::string &endpoint);
+
+    void
+    stop_publisher ();
+
+// publishing: returns true if publisher is started
+    bool
+    publishing ();
+
+// changed: record change made by write function, no-op without publisher
+// the change is kept by batch_t of this thread, or waits for publish
+    void
+    changed (table_t table, kind_t kind, uint32_t id);
+
+// publish: publish changes of this thread recorded out of batch_t
+    void
+    publish ();
+
+// discard: drop changes of this thread recorded out of batch_t, after
+// the transaction was rolled back
+    void
+    discard ();
+
+// pending: number of changes of this thread waiting for publish
+    size_t
+    pending ();
+
+// encode: pack changes into frame of 6 bytes per change
+    std::string
+    encode (const std::vector <change_t> &changes);
+
+// decode: append changes packed by encode
+// returns false if frame is malformed
+    bool
+    decode (const void *data, size_t size, std::vector <change_t> &changes);
+
+// subscriber_t: receives changes from publishers of other processes
+// throws if socket can't be created
+class subscriber_t {
+    public:
+        // endpoints: comma separated list of publisher endpoints
+        subscriber_t (const std::string &endpoints);
+        ~subscriber_t ();
+
+        subscriber_t (const subscriber_t&) = delete;
+        subscriber_t& operator= (const subscriber_t&) = delete;
+
+        // socket: czmq socket, for zpoller of the caller
+        void *
+        socket () { return m_sock; }
+
+        // receive: wait at most timeout_ms (-1 forever) for one message
+        // and append its changes; a gap in messages of a publisher adds a
+        // change of unknown elements
+        // returns 0 on success, -1 on timeout or interrupt
+        int
+        receive (std::vector <change_t> &changes, int timeout_ms = -1);
+
+        // lost: number of gaps found so far
+        uint64_t
+        lost () const { return m_lost; }
+
+    private:
+        void *m_sock;
+        std::vector <std::pair <uint64_t, uint64_t>> m_sequences;
+        uint64_t m_lost;
+};
+
+// apply: drop what caches of this library hold for the change before
+// they find it out by generation of asset tables
+    void
+    apply (const change_t &change);
+
+    void
+    apply (const std::vector <change_t> &changes);
+
+} // namespace
+
+void
+fty_common_db_change_notify_test (bool verbose);
+
+#endif // __cplusplus
+#endif // FTY_COMMON_DB_CHANGE_NOTIFY_H_INCLUDED
@@ -0,0 +1,104 @@
+/*  =========================================================================
+    fty_common_db_connection_pool - Pool of database connections
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef FTY_COMMON_DB_CONNECTION_POOL_H_INCLUDED
+#define FTY_COMMON_DB_CONNECTION_POOL_H_INCLUDED
+
+#ifdef __cplusplus
+#include <inttypes.h>
+#include <tntdb/connection.h>
+
+// Process-wide pool of connections to DBConn::url, used by all functions
+// without connection argument. A thread holds at most one connection of the
+// pool: nested acquisitions in the same thread share it, and a thread gets
+// back the connection it used last time when it is idle. When all
+// connections are in use, threads wait in the order they came.
+// Connection idle for more than HEALTH_CHECK_IDLE_S seconds is pinged before
+// it is handed out, broken connection (or connection to old url) is replaced.
+namespace DBConn {
+
+static const size_t DEFAULT_POOL_SIZE = 8;
+static const unsigned HEALTH_CHECK_IDLE_S = 10;
+
+struct pool_stats_t {
+    uint64_t acquired;     // connections handed out (not counting nested)
+    uint64_t waits;        // acquisitions which had to wait
+    uint64_t wait_us;      // total time of waiting
+    uint64_t max_wait_us;  // the longest wait
+    uint64_t reconnects;   // connections replaced by health check
+    size_t   size;         // connections of the pool
+    size_t   busy;         // connections in use
+};
+
+// connection_t: connection of the pool, held until destroyed
+// throws if new connection can't be established
+class connection_t {
+    public:
+        connection_t ();
+        ~connection_t ();
+
+        connection_t (const connection_t&) = delete;
+        connection_t& operator= (const connection_t&) = delete;
+
+        tntdb::Connection &get ();
+
+    private:
+        void *m_slot;
+};
+
+// set_pool_size: maximal number of connections, extra connections are
+// closed when they are released
+    void
+    set_pool_size (size_t size);
+
+    size_t
+    pool_size ();
+
+// pool_stats: counters since start or last reset_pool_stats
+    pool_stats_t
+    pool_stats ();
+
+    void
+    reset_pool_stats ();
+
+// pool_clear: close idle connections, for example after url changed
+    void
+    pool_clear ();
+
+// warm_up: in background thread, open connections of the pool (pool size if
+// connections is 0) and add them as idle ones, so first calls of functions
+// do not pay for connecting; statements are still prepared on first use,
+// tntdb MySQL driver prepares them on the server when they are executed
+// previous warm-up is finished first
+    void
+    warm_up (size_t connections = 0);
+
+// warm_up_wait: wait until warm-up finishes
+    void
+    warm_up_wait ();
+
+} // namespace
+
+void
+fty_common_db_connection_pool_test (bool verbose);
+
+#endif // __cplusplus
+#endif // FTY_COMMON_DB_CONNECTION_POOL_H_INCLUDED
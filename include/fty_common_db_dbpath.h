@@ -37,6 +37,8 @@ namespace DBConn {
 //! Global string with url to the database
 extern std::string url;
 void dbpath ();
+//! Update url, then warm up connection pool in background if warm_up is true
+void dbpath (bool warm_up);
 bool dbreadcredentials();
 
 } // namespace
@@ -31,6 +31,9 @@
 #define INPUT_POWER_CHAIN     1
 
 typedef std::function<void(const tntdb::Row&)> row_cb_f ;
+typedef std::function<void(const tntdb::Result&)> result_cb_f ;
+// returns false to stop the scan
+typedef std::function<bool(const tntdb::Row&)> row_stream_cb_f ;
 
 template <typename T>
 struct db_reply{
@@ -0,0 +1,178 @@
+/*  =========================================================================
+    fty_common_db_ext_store - Columnar in-memory store of extended attributes
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef FTY_COMMON_DB_EXT_STORE_H_INCLUDED
+#define FTY_COMMON_DB_EXT_STORE_H_INCLUDED
+
+#ifdef __cplusplus
+#include <inttypes.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <tntdb/connection.h>
+
+// Process-wide store of all extended attributes, loaded in one scan of
+// v_bios_asset_ext_attributes. Keytags are interned to small ids, values are
+// kept in one arena and every element has a range in the attribute columns,
+// so a lookup neither allocates nor copies. Store is disabled by default;
+// when enabled, it is loaded in background (see DBAsync) together with the
+// generation of asset tables (see DBAssetGeneration), and answers only to
+// callers which see the same generation. Without the generation table the
+// store is never used.
+namespace DBExtStore {
+
+// NO_KEYTAG: id of keytag which no element has
+static const uint32_t NO_KEYTAG = UINT32_MAX;
+
+// value_t: value of attribute, data points into the store and is valid as
+// long as the store is held, it is not terminated by '\0'
+struct value_t {
+    const char *data;
+    uint32_t    size;
+    bool        read_only;
+
+    std::string str () const { return std::string (data, size); }
+};
+
+// store_t: immutable once finished, can be read from many threads
+class store_t {
+    public:
+        store_t () {}
+
+        store_t (const store_t&) = delete;
+        store_t& operator= (const store_t&) = delete;
+
+        // add: add attribute, element may have at most one value of keytag
+        void
+        add (uint32_t element_id,
+             const std::string &keytag,
+             const std::string &value,
+             bool read_only);
+
+        // finish: sort attributes added so far into columns, call once
+        // after the last add
+        void
+        finish ();
+
+        // keytag_id: returns id of keytag or NO_KEYTAG
+        uint32_t
+        keytag_id (const std::string &keytag) const;
+
+        const std::string &
+        keytag (uint32_t keytag_id) const { return m_keytags [keytag_id]; }
+
+        // get: find value of keytag of element
+        // returns false if element does not have the keytag
+        bool
+        get (uint32_t element_id,
+             uint32_t keytag_id,
+             value_t &out) const;
+
+        bool
+        get (uint32_t element_id,
+             const std::string &keytag,
+             value_t &out) const;
+
+        // each: call f (keytag_id, value) for every attribute of element,
+        // ordered by keytag id
+        template <typename F>
+        void
+        each (uint32_t element_id, F f) const
+        {
+            auto it = m_rows.find (element_id);
+            if (it == m_rows.end ())
+                return;
+            for (uint32_t a = m_first [it->second]; a != m_first [it->second + 1]; a++)
+                f (m_keys [a], value_at (a));
+        }
+
+        size_t elements () const { return m_rows.size (); }
+        size_t attributes () const { return m_keys.size (); }
+        size_t keytags () const { return m_keytags.size (); }
+        size_t arena_size () const { return m_arena.size (); }
+
+    private:
+        value_t
+        value_at (uint32_t a) const
+        {
+            return value_t {m_arena.data () + m_offsets [a], m_sizes [a], m_read_only [a] != 0};
+        }
+
+        std::unordered_map <std::string, uint32_t> m_keytag_ids;
+        std::vector <std::string> m_keytags;
+        // element id -> row, attributes of row r are [m_first [r], m_first [r + 1])
+        std::unordered_map <uint32_t, uint32_t> m_rows;
+        std::vector <uint32_t> m_first;
+        // columns of attributes
+        std::vector <uint32_t> m_keys;
+        std::vector <uint32_t> m_offsets;
+        std::vector <uint32_t> m_sizes;
+        std::vector <uint8_t>  m_read_only;
+        std::string m_arena;
+        // row of every added attribute, dropped by finish
+        std::vector <uint32_t> m_added;
+};
+
+typedef std::shared_ptr <const store_t> store_ptr;
+
+// enable: turn the store on or off, turning it off drops it
+    void
+    enable (bool on);
+
+// enabled: returns true if store is turned on
+    bool
+    enabled ();
+
+// load: (re)build the store from v_bios_asset_ext_attributes now, in
+// a transaction of conn, which must not be in another one
+// returns 0 on success, -1 if error occurs
+    int
+    load (tntdb::Connection &conn);
+
+// build: use given store as it was at generation, it must be finished
+    void
+    build (std::unique_ptr <store_t> store,
+           int64_t generation);
+
+// store: returns current store if it was loaded at the generation conn
+// sees, starts loading in background if there is no store or it is older
+// returns empty pointer if store is disabled or not loaded at the
+// generation, caller then asks the database
+    store_ptr
+    store (tntdb::Connection &conn);
+
+// store: the same as above for known generation
+    store_ptr
+    store (int64_t generation);
+
+// invalidate: drop the store, it is loaded again on next use
+// stores returned before stay valid for their holders
+    void
+    invalidate ();
+
+} // namespace
+
+void
+fty_common_db_ext_store_test (bool verbose);
+
+#endif // __cplusplus
+#endif // FTY_COMMON_DB_EXT_STORE_H_INCLUDED
@@ -0,0 +1,103 @@
+/*  =========================================================================
+    fty_common_db_keytag_index - In-memory inverted index of unique ext attributes
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef FTY_COMMON_DB_KEYTAG_INDEX_H_INCLUDED
+#define FTY_COMMON_DB_KEYTAG_INDEX_H_INCLUDED
+
+#ifdef __cplusplus
+#include <inttypes.h>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <tntdb/connection.h>
+
+// Process-wide index (keytag, value) -> elements of ext attributes which
+// must be unique (name, serial number, IP address, ...), used by
+// DBAssets::count_keytag and DBAssets::unique_keytag to answer from memory.
+// Values are matched like the database does, without case and trailing
+// spaces; the index does not answer for values with other than ASCII
+// characters, callers then ask the database. Index is disabled by default;
+// when enabled, it is loaded in background (see DBAsync) together with the
+// generation of asset tables (see DBAssetGeneration), and answers only to
+// callers which see the same generation. Without the generation table the
+// index is never used.
+namespace DBKeytagIndex {
+
+// default_keytags: keytags indexed unless set_keytags is called
+    std::set <std::string>
+    default_keytags ();
+
+// set_keytags: keytags to index, drops the index
+    void
+    set_keytags (const std::set <std::string> &keytags);
+
+    std::set <std::string>
+    keytags ();
+
+// enable: turn the index on or off, turning it off drops it
+    void
+    enable (bool on);
+
+// enabled: returns true if index is turned on
+    bool
+    enabled ();
+
+// load: (re)build the index from t_bios_asset_ext_attributes now, in a
+// transaction of conn, which must not be in another one
+// returns 0 on success, -1 if error occurs
+    int
+    load (tntdb::Connection &conn);
+
+// build: (re)build the index from list of (element id, keytag, value, read_only)
+// as it was at generation
+    void
+    build (const std::vector <std::tuple <uint32_t, std::string, std::string, bool>> &attributes,
+           int64_t generation);
+
+// invalidate: drop the index, it is loaded again on next use
+    void
+    invalidate ();
+
+// find: ids of elements having keytag with value, if index was loaded at
+// the generation conn sees; starts loading in background if it is older
+// returns 0 on success, -1 if index can't answer (it is disabled, keytag is
+// not indexed, value is not ASCII or index is not loaded at the generation)
+    int
+    find (tntdb::Connection &conn,
+          const std::string &keytag,
+          const std::string &value,
+          std::vector <uint32_t> &out);
+
+// find: the same as above for known generation
+    int
+    find (int64_t generation,
+          const std::string &keytag,
+          const std::string &value,
+          std::vector <uint32_t> &out);
+
+} // namespace
+
+void
+fty_common_db_keytag_index_test (bool verbose);
+
+#endif // __cplusplus
+#endif // FTY_COMMON_DB_KEYTAG_INDEX_H_INCLUDED
@@ -90,6 +90,34 @@ typedef struct _fty_common_db_asset_update_t fty_common_db_asset_update_t;
 #define FTY_COMMON_DB_ASSET_UPDATE_T_DEFINED
 typedef struct _fty_common_db_uptime_t fty_common_db_uptime_t;
 #define FTY_COMMON_DB_UPTIME_T_DEFINED
+typedef struct _fty_common_db_asset_names_t fty_common_db_asset_names_t;
+#define FTY_COMMON_DB_ASSET_NAMES_T_DEFINED
+typedef struct _fty_common_db_asset_tree_t fty_common_db_asset_tree_t;
+#define FTY_COMMON_DB_ASSET_TREE_T_DEFINED
+typedef struct _fty_common_db_asset_closure_t fty_common_db_asset_closure_t;
+#define FTY_COMMON_DB_ASSET_CLOSURE_T_DEFINED
+typedef struct _fty_common_db_power_graph_t fty_common_db_power_graph_t;
+#define FTY_COMMON_DB_POWER_GRAPH_T_DEFINED
+typedef struct _fty_common_db_metrics_t fty_common_db_metrics_t;
+#define FTY_COMMON_DB_METRICS_T_DEFINED
+typedef struct _fty_common_db_row_t fty_common_db_row_t;
+#define FTY_COMMON_DB_ROW_T_DEFINED
+typedef struct _fty_common_db_statement_cache_t fty_common_db_statement_cache_t;
+#define FTY_COMMON_DB_STATEMENT_CACHE_T_DEFINED
+typedef struct _fty_common_db_connection_pool_t fty_common_db_connection_pool_t;
+#define FTY_COMMON_DB_CONNECTION_POOL_T_DEFINED
+typedef struct _fty_common_db_ext_store_t fty_common_db_ext_store_t;
+#define FTY_COMMON_DB_EXT_STORE_T_DEFINED
+typedef struct _fty_common_db_keytag_index_t fty_common_db_keytag_index_t;
+#define FTY_COMMON_DB_KEYTAG_INDEX_T_DEFINED
+typedef struct _fty_common_db_asset_generation_t fty_common_db_asset_generation_t;
+#define FTY_COMMON_DB_ASSET_GENERATION_T_DEFINED
+typedef struct _fty_common_db_change_notify_t fty_common_db_change_notify_t;
+#define FTY_COMMON_DB_CHANGE_NOTIFY_T_DEFINED
+typedef struct _fty_common_db_snapshot_t fty_common_db_snapshot_t;
+#define FTY_COMMON_DB_SNAPSHOT_T_DEFINED
+typedef struct _fty_common_db_async_t fty_common_db_async_t;
+#define FTY_COMMON_DB_ASYNC_T_DEFINED
 
 
 //  Public classes, each with its own header file
@@ -101,6 +129,20 @@ typedef struct _fty_common_db_uptime_t fty_common_db_uptime_t;
 #include "fty_common_db_asset_insert.h"
 #include "fty_common_db_asset_update.h"
 #include "fty_common_db_uptime.h"
+#include "fty_common_db_asset_names.h"
+#include "fty_common_db_asset_tree.h"
+#include "fty_common_db_asset_closure.h"
+#include "fty_common_db_power_graph.h"
+#include "fty_common_db_metrics.h"
+#include "fty_common_db_row.h"
+#include "fty_common_db_statement_cache.h"
+#include "fty_common_db_connection_pool.h"
+#include "fty_common_db_ext_store.h"
+#include "fty_common_db_keytag_index.h"
+#include "fty_common_db_asset_generation.h"
+#include "fty_common_db_change_notify.h"
+#include "fty_common_db_snapshot.h"
+#include "fty_common_db_async.h"
 
 #ifdef FTY_COMMON_DB_BUILD_DRAFT_API
 
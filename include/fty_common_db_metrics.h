@@ -0,0 +1,125 @@
+/*  =========================================================================
+    fty_common_db_metrics - Per-function call metrics
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef FTY_COMMON_DB_METRICS_H_INCLUDED
+#define FTY_COMMON_DB_METRICS_H_INCLUDED
+
+#ifdef __cplusplus
+#include <inttypes.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Call count, error count, rows and latency histogram of every function of
+// DBAssets, DBAssetsInsert, DBAssetsUpdate and DBAssetsDelete. Recording only
+// touches atomic counters of the function, so it is on by default.
+// Errors are database errors (exceptions), rejected input is not counted.
+namespace DBMetrics {
+
+// latency [0] counts calls faster than 1 us, latency [i] calls taking
+// [2^(i-1), 2^i) us, the last bucket also counts all slower calls
+static const size_t BUCKETS = 32;
+
+struct function_stats_t {
+    std::string name;
+    uint64_t    calls;
+    uint64_t    errors;
+    uint64_t    rows;      // rows selected, inserted, updated or deleted
+    uint64_t    total_us;  // sum of latencies
+    uint64_t    latency [BUCKETS];
+};
+
+// counters of one function, registered on construction, never destroyed
+// before the end of the process
+struct counters_t {
+    explicit counters_t (const char *name);
+
+    const char              *name;
+    counters_t              *next;
+    std::atomic <uint64_t>  calls;
+    std::atomic <uint64_t>  errors;
+    std::atomic <uint64_t>  rows;
+    std::atomic <uint64_t>  total_us;
+    std::atomic <uint64_t>  latency [BUCKETS];
+};
+
+// probe_t: records one call when it goes out of scope
+class probe_t {
+    public:
+        explicit probe_t (counters_t &counters);
+        ~probe_t ();
+
+        // rows: add number of rows processed by the call
+        void rows (uint64_t n) { m_rows += n; }
+        // error: mark the call as failed
+        void error () { m_error = true; }
+
+    private:
+        counters_t &m_counters;
+        bool m_on;
+        bool m_error;
+        uint64_t m_rows;
+        std::chrono::steady_clock::time_point m_start;
+};
+
+// enable: turn recording on or off
+    void
+    enable (bool on);
+
+// enabled: returns true if recording is turned on
+    bool
+    enabled ();
+
+// bucket: index of latency bucket for given duration
+    size_t
+    bucket (uint64_t us);
+
+// snapshot: current values of all functions called at least once, sorted by
+// name, overloaded functions are summed up
+    std::vector <function_stats_t>
+    snapshot ();
+
+// snapshot_json: the same as snapshot, as JSON array
+    std::string
+    snapshot_json ();
+
+// reset: set all counters to zero
+    void
+    reset ();
+
+} // namespace
+
+// DBMETRICS_PROBE: declare probe recording the enclosing function
+#define DBMETRICS_PROBE(probe) \
+    DBMETRICS_PROBE_AS (probe, __func__)
+
+// DBMETRICS_PROBE_AS: declare probe recording the enclosing function under
+// given name, for implementations shared by several public functions
+#define DBMETRICS_PROBE_AS(probe, name) \
+    static DBMetrics::counters_t probe##_counters (name); \
+    DBMetrics::probe_t probe (probe##_counters)
+
+void
+fty_common_db_metrics_test (bool verbose);
+
+#endif // __cplusplus
+#endif // FTY_COMMON_DB_METRICS_H_INCLUDED
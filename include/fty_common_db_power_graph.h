@@ -0,0 +1,143 @@
+/*  =========================================================================
+    fty_common_db_power_graph - In-memory graph of power links
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef FTY_COMMON_DB_POWER_GRAPH_H_INCLUDED
+#define FTY_COMMON_DB_POWER_GRAPH_H_INCLUDED
+
+#ifdef __cplusplus
+#include <inttypes.h>
+#include <vector>
+#include <tntdb/connect.h>
+#include "fty_common_db_defs.h"
+
+// Process-wide graph of power chain links (t_bios_asset_link with link type
+// INPUT_POWER_CHAIN), in compressed sparse row form with forward (src -> dest)
+// and reverse (dest -> src) edges. It answers multi-hop questions in memory,
+// instead of one select_asset_device_links_to round trip per device per hop.
+// Graph is disabled by default; when enabled, it is loaded in background
+// (see DBAsync) together with the generation of asset tables (see
+// DBAssetGeneration), and answers only to callers which see the same
+// generation. Without the generation table the graph is never used.
+// Functions taking generation instead of conn are the same as those below
+// them, for known generation.
+namespace DBPowerGraph {
+
+// enable: turn the graph on or off, turning it off drops it
+    void
+    enable (bool on);
+
+// enabled: returns true if graph is turned on
+    bool
+    enabled ();
+
+// load: (re)build the graph from t_bios_asset_link now, in a transaction
+// of conn, which must not be in another one
+// returns 0 on success, -1 if error occurs
+    int
+    load (tntdb::Connection &conn);
+
+// build: (re)build the graph from list of links as it was at generation
+    void
+    build (const std::vector <db_tmp_link_t> &links,
+           int64_t generation);
+
+// invalidate: drop the graph, it is loaded again on next use
+    void
+    invalidate ();
+
+// upstream: ids of devices feeding given device, nearest first
+// depth limits the number of hops, 0 means no limit (transitive closure)
+// graph answers if it was loaded at the generation conn sees, it starts
+// loading in background if it is older
+// returns 0 on success, -1 if graph is disabled or not loaded at the generation
+    int
+    upstream (tntdb::Connection &conn,
+              uint32_t device_id,
+              uint32_t depth,
+              std::vector <uint32_t> &out);
+
+    int
+    upstream (int64_t generation,
+              uint32_t device_id,
+              uint32_t depth,
+              std::vector <uint32_t> &out);
+
+// downstream: ids of devices fed by given device, nearest first
+// depth limits the number of hops, 0 means no limit (transitive closure)
+// returns 0 on success, -1 if graph is disabled or not loaded at the generation
+    int
+    downstream (tntdb::Connection &conn,
+                uint32_t device_id,
+                uint32_t depth,
+                std::vector <uint32_t> &out);
+
+    int
+    downstream (int64_t generation,
+                uint32_t device_id,
+                uint32_t depth,
+                std::vector <uint32_t> &out);
+
+// feeds: sets result to true if src_id feeds dest_id through any number of hops
+// returns 0 on success, -1 if graph is disabled or not loaded at the generation
+    int
+    feeds (tntdb::Connection &conn,
+           uint32_t src_id,
+           uint32_t dest_id,
+           bool &result);
+
+    int
+    feeds (int64_t generation,
+           uint32_t src_id,
+           uint32_t dest_id,
+           bool &result);
+
+// links_to: links with given device as dest, the same as
+// select_asset_device_links_to
+// returns 0 on success, -1 if graph is disabled or not loaded at the generation
+    int
+    links_to (tntdb::Connection &conn,
+              uint32_t device_id,
+              std::vector <db_tmp_link_t> &out);
+
+    int
+    links_to (int64_t generation,
+              uint32_t device_id,
+              std::vector <db_tmp_link_t> &out);
+
+// links_from: links with given device as src
+// returns 0 on success, -1 if graph is disabled or not loaded at the generation
+    int
+    links_from (tntdb::Connection &conn,
+                uint32_t device_id,
+                std::vector <db_tmp_link_t> &out);
+
+    int
+    links_from (int64_t generation,
+                uint32_t device_id,
+                std::vector <db_tmp_link_t> &out);
+
+} // namespace
+
+void
+fty_common_db_power_graph_test (bool verbose);
+
+#endif // __cplusplus
+#endif // FTY_COMMON_DB_POWER_GRAPH_H_INCLUDED
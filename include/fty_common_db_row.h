@@ -0,0 +1,123 @@
+/*  =========================================================================
+    fty_common_db_row - Typed decoding of result rows
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef FTY_COMMON_DB_ROW_H_INCLUDED
+#define FTY_COMMON_DB_ROW_H_INCLUDED
+
+#ifdef __cplusplus
+#include <stddef.h>
+#include <functional>
+#include <tntdb/result.h>
+#include <tntdb/row.h>
+
+// Decoding of result rows into plain structs ("views"), with columns bound to
+// members by index at compile time. A view lists its bindings in a member
+// typedef named fields:
+//
+//  struct my_view_t {
+//      std::string name;
+//      uint32_t    id;
+//      typedef DBRow::fields <
+//          DBROW_FIELD (0, my_view_t, name),
+//          DBROW_FIELD (1, my_view_t, id)> fields;
+//  };
+//
+// Indexes follow the order of columns in SELECT of the query, columns not
+// bound are skipped. NULL leaves the member value-initialized.
+namespace DBRow {
+
+// field: binds column Index to member of View
+template <size_t Index, typename View, typename Type, Type View::*Member>
+struct field {
+    static const size_t columns = Index + 1;
+
+    template <typename Row>
+    static void
+    decode (const Row &row, View &view)
+    {
+        row [Index].get (view.*Member);
+    }
+};
+
+// fields: list of bindings of a view, columns is the number of columns
+// the query must select at least
+template <typename... Fields>
+struct fields;
+
+template <>
+struct fields <> {
+    static const size_t columns = 0;
+
+    template <typename Row, typename View>
+    static void
+    decode (const Row &, View &)
+    {
+    }
+};
+
+template <typename Field, typename... Rest>
+struct fields <Field, Rest...> {
+    static const size_t columns = Field::columns > fields <Rest...>::columns
+        ? Field::columns : fields <Rest...>::columns;
+
+    template <typename Row, typename View>
+    static void
+    decode (const Row &row, View &view)
+    {
+        Field::decode (row, view);
+        fields <Rest...>::decode (row, view);
+    }
+};
+
+// decode: fill view from row
+template <typename View, typename Row>
+void
+decode (const Row &row, View &view)
+{
+    View::fields::decode (row, view);
+}
+
+// each: result callback decoding every row into View and calling f (view)
+// std::function is called once per result, f is called directly
+template <typename View, typename F>
+std::function <void (const tntdb::Result&)>
+each (F &f)
+{
+    return [&f] (const tntdb::Result &result) {
+        for (const auto &row : result) {
+            View view = View ();
+            decode (row, view);
+            f (view);
+        }
+    };
+}
+
+} // namespace
+
+// DBROW_FIELD: binds column index to member of View
+#define DBROW_FIELD(index, View, member) \
+    DBRow::field <index, View, decltype (View::member), &View::member>
+
+void
+fty_common_db_row_test (bool verbose);
+
+#endif // __cplusplus
+#endif // FTY_COMMON_DB_ROW_H_INCLUDED
@@ -0,0 +1,198 @@
+/*  =========================================================================
+    fty_common_db_snapshot - Memory mapped snapshot of asset tables
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef FTY_COMMON_DB_SNAPSHOT_H_INCLUDED
+#define FTY_COMMON_DB_SNAPSHOT_H_INCLUDED
+
+#ifdef __cplusplus
+#include <inttypes.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <tntdb/connection.h>
+#include "fty_common_db_defs.h"
+
+// Binary file with elements, parent pointers, links, group relations and
+// ext attributes, written by save in one consistent read of the database.
+// Records have fixed width, strings are interned and referenced by their
+// offset, so a reader maps the file and answers the common DBAssets read
+// calls without deserializing it. The file carries the asset generation it
+// was saved at (see DBAssetGeneration), so an agent can start from the
+// snapshot and reload only if DBAssets::current_generation differs.
+// Layout is native byte order, a file of other byte order is refused.
+namespace DBSnapshot {
+
+static const char MAGIC [8] = {'F', 'T', 'Y', 'D', 'B', 'S', 'N', 'P'};
+static const uint32_t FORMAT_VERSION = 2;
+
+enum section_id_t {
+    STRINGS = 0,    // '\0' terminated strings, reference 0 is ""
+    ELEMENTS,       // element_t sorted by id
+    ATTRIBUTES,     // attribute_t, ranges of elements
+    LINKS,          // link_t, ranges of destination elements
+    GROUPS,         // id of group, ranges of elements
+    NAMES,          // index of element, sorted by folded name
+    SECTIONS
+};
+
+struct section_t {
+    uint64_t offset;    // from the start of file, 8 bytes aligned
+    uint64_t count;     // bytes of STRINGS, records of other sections
+};
+
+struct header_t {
+    char      magic [8];
+    uint32_t  version;
+    uint32_t  byte_order;   // 0x01020304 written natively
+    int64_t   generation;   // -1 if not known
+    uint64_t  created;      // unix time of save
+    section_t sections [SECTIONS];
+};
+
+struct element_t {
+    uint32_t id;
+    uint32_t name;          // string references
+    uint32_t type_name;
+    uint32_t subtype_name;
+    uint32_t status;
+    uint32_t asset_tag;
+    uint32_t parent_id;     // 0 if none
+    uint16_t type_id;
+    uint16_t subtype_id;
+    uint16_t priority;
+    uint16_t reserved;
+    uint32_t first_attribute;
+    uint32_t attributes;
+    uint32_t first_link;
+    uint32_t links;
+    uint32_t first_group;
+    uint32_t groups;
+};
+
+struct attribute_t {
+    uint32_t keytag;
+    uint32_t value;
+    uint32_t read_only;
+};
+
+struct link_t {
+    uint32_t src;
+    uint32_t src_out;
+    uint32_t dest_in;
+    uint32_t type;
+};
+
+// save: write snapshot of the database to path, the file is replaced
+// atomically, readers which mapped the old one keep it
+// returns 0 on success, -1 if error occurs
+    int
+    save (tntdb::Connection &conn,
+          const std::string &path);
+
+// snapshot_t: read only mapping of snapshot file, can be read from many
+// threads; returned pointers are valid until close
+class snapshot_t {
+    public:
+        snapshot_t ();
+        ~snapshot_t ();
+
+        snapshot_t (const snapshot_t&) = delete;
+        snapshot_t& operator= (const snapshot_t&) = delete;
+
+        // open: map the file and check its header and all references
+        // returns 0 on success, -1 if file can't be mapped or is not valid
+        int
+        open (const std::string &path);
+
+        void
+        close ();
+
+        bool is_open () const { return m_header != nullptr; }
+        int64_t generation () const { return m_header->generation; }
+        uint64_t created () const { return m_header->created; }
+        size_t elements () const { return m_header->sections [ELEMENTS].count; }
+
+        // element: returns element of id or nullptr
+        const element_t *
+        element (uint32_t id) const;
+
+        // element_by_name: returns element of internal name or nullptr
+        // names are folded like the database collation does: ASCII
+        // letters match in any case, trailing spaces are ignored; other
+        // than ASCII characters match only exactly, the database also
+        // matches accented letters with plain ones
+        const element_t *
+        element_by_name (const std::string &name) const;
+
+        const char *
+        str (uint32_t ref) const { return m_strings + ref; }
+
+        // each_element: call f (const element_t&) for all elements
+        template <typename F>
+        void
+        each_element (F f) const
+        {
+            for (size_t i = 0; i != elements (); i++)
+                f (m_elements [i]);
+        }
+
+        // the same as DBAssets functions of the same name
+        int64_t
+        name_to_asset_id (const std::string &asset_name) const;
+
+        std::pair <std::string, std::string>
+        id_to_name_ext_name (uint32_t asset_id) const;
+
+        db_reply <db_web_basic_element_t>
+        select_asset_element_web_byId (uint32_t element_id) const;
+
+        db_reply <std::map <std::string, std::pair<std::string, bool>>>
+        select_ext_attributes (uint32_t element_id) const;
+
+        db_reply <std::vector <db_tmp_link_t>>
+        select_asset_device_links_to (uint32_t element_id,
+                                      uint8_t link_type_id) const;
+
+        db_reply <std::map <uint32_t, std::string> >
+        select_asset_element_groups (uint32_t element_id) const;
+
+    private:
+        int
+        check (size_t size);
+
+        void              *m_map;
+        size_t             m_size;
+        const header_t    *m_header;
+        const char        *m_strings;
+        const element_t   *m_elements;
+        const attribute_t *m_attributes;
+        const link_t      *m_links;
+        const uint32_t    *m_groups;
+        const uint32_t    *m_names;
+};
+
+} // namespace
+
+void
+fty_common_db_snapshot_test (bool verbose);
+
+#endif // __cplusplus
+#endif // FTY_COMMON_DB_SNAPSHOT_H_INCLUDED
@@ -0,0 +1,124 @@
+/*  =========================================================================
+    fty_common_db_statement_cache - Bounded cache of prepared statements
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef FTY_COMMON_DB_STATEMENT_CACHE_H_INCLUDED
+#define FTY_COMMON_DB_STATEMENT_CACHE_H_INCLUDED
+
+#ifdef __cplusplus
+#include <inttypes.h>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <tntdb/connection.h>
+#include <tntdb/statement.h>
+
+// Prepared statements of the library, cached in tntdb connection under short
+// keys. Every connection keeps at most capacity () statements, the least
+// recently used one is removed from tntdb cache (and closed on server) when
+// a new one is prepared. Bookkeeping of connections owned by callers is kept
+// for at most MAX_CALLER_CONNECTIONS recently used ones.
+namespace DBStatementCache {
+
+static const size_t DEFAULT_CAPACITY = 128;
+static const size_t MAX_CALLER_CONNECTIONS = 64;
+
+// query_t: query with constant text and id assigned once, meant to be
+// a function-static object, so a cache lookup does not touch the text
+class query_t {
+    public:
+        explicit query_t (const char *sql);
+
+        const char *sql () const { return m_sql; }
+        uint32_t id () const { return m_id; }
+        const std::string &key () const { return m_key; }
+
+    private:
+        const char *m_sql;
+        uint32_t m_id;
+        std::string m_key;
+};
+
+struct stats_t {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    size_t   statements;  // statements cached in all connections
+    size_t   connections; // connections with bookkeeping
+    uint64_t dropped;     // caller connections whose bookkeeping was dropped
+};
+
+// lru_t: keys ordered by last use
+class lru_t {
+    public:
+        // touch: mark key as used, keys over capacity are moved to evicted
+        // returns true if key was known
+        bool
+        touch (const std::string &key,
+               size_t capacity,
+               std::vector <std::string> &evicted);
+
+        size_t size () const { return m_keys.size (); }
+
+    private:
+        std::list <std::string> m_keys;  // most recently used first
+        std::unordered_map <std::string, std::list <std::string>::iterator> m_index;
+};
+
+// set_capacity: maximal number of statements cached per connection
+    void
+    set_capacity (size_t capacity);
+
+    size_t
+    capacity ();
+
+// prepare: returns cached statement of query, prepares it if needed
+    tntdb::Statement
+    prepare (tntdb::Connection &conn, const query_t &query);
+
+// prepare: returns cached statement for sql text, for queries built at runtime
+    tntdb::Statement
+    prepare (tntdb::Connection &conn, const std::string &sql);
+
+// track: start bookkeeping of connection owned by the pool, call after it
+// is opened; other connections get bookkeeping on first prepare
+    void
+    track (const tntdb::Connection &conn);
+
+// forget: drop bookkeeping of connection, call before it is closed; callers
+// which close their connections should call it too
+    void
+    forget (const tntdb::Connection &conn);
+
+// stats: counters since start or last reset_stats
+    stats_t
+    stats ();
+
+    void
+    reset_stats ();
+
+} // namespace
+
+void
+fty_common_db_statement_cache_test (bool verbose);
+
+#endif // __cplusplus
+#endif // FTY_COMMON_DB_STATEMENT_CACHE_H_INCLUDED
@@ -28,19 +28,36 @@
 
 #include "fty_common_db_classes.h"
 #include <fty_common_macros.h>
+#include <algorithm>
 #include <assert.h>
+#include <chrono>
+#include <unordered_map>
 
 namespace DBAssets {
 
+// s_names_generation: generation for DBAssetNames lookups, asked only if
+// the dictionary is enabled
+static int64_t
+s_names_generation (tntdb::Connection &conn)
+{
+    return DBAssetNames::enabled () ? DBAssetGeneration::current (conn) : -1;
+}
+
 std::pair <std::string, std::string>
 id_to_name_ext_name (uint32_t asset_id)
 {
+    DBMETRICS_PROBE (probe);
     std::string name;
     std::string ext_name;
     try
     {
-        tntdb::Connection conn = tntdb::connectCached(DBConn::url);
-        tntdb::Statement st = conn.prepareCached(
+        DBConn::connection_t pooled;
+        tntdb::Connection &conn = pooled.get ();
+        int64_t generation = s_names_generation (conn);
+        if (DBAssetNames::find_name (generation, asset_id, name) && DBAssetNames::find_extname (generation, asset_id, ext_name))
+            return make_pair (name, ext_name);
+
+        static const DBStatementCache::query_t st_query (
             " SELECT asset.name, ext.value "
             " FROM "
             "   t_bios_asset_element AS asset "
@@ -50,6 +67,7 @@ id_to_name_ext_name (uint32_t asset_id)
             "   ext.id_asset_element = asset.id_asset_element "
             " WHERE "
             "   ext.keytag = \"name\" AND asset.id_asset_element = :asset_id ");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         tntdb::Row row = st.set("asset_id", asset_id).selectRow();
         log_debug("[t_bios_asset_element]: were selected %" PRIu32 " rows", 1);
@@ -59,6 +77,7 @@ id_to_name_ext_name (uint32_t asset_id)
     }
     catch (const std::exception &e)
     {
+        probe.error ();
         if (asset_id != 0)
             log_error ("exception caught %s - %" PRIu32, e.what (), asset_id);
         name = "";
@@ -70,19 +89,25 @@ id_to_name_ext_name (uint32_t asset_id)
 int64_t
 name_to_asset_id (std::string asset_name)
 {
+    DBMETRICS_PROBE (probe);
     if(asset_name.empty()) return 0;
 
     try
     {
         int64_t id = 0;
 
-        tntdb::Connection conn = tntdb::connectCached(DBConn::url);
-        tntdb::Statement st = conn.prepareCached(
+        DBConn::connection_t pooled;
+        tntdb::Connection &conn = pooled.get ();
+        uint32_t known_id = 0;
+        if (DBAssetNames::find_id (s_names_generation (conn), asset_name, known_id))
+            return known_id;
+
+        static const DBStatementCache::query_t st_query (
                 " SELECT id_asset_element"
                 " FROM"
                 "   t_bios_asset_element"
-                " WHERE name = :asset_name"
-                );
+                " WHERE name = :asset_name");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         tntdb::Row row = st.set("asset_name", asset_name).selectRow();
         log_debug("[t_bios_asset_element]: were selected %" PRIu32 " rows", 1);
@@ -96,25 +121,99 @@ name_to_asset_id (std::string asset_name)
     }
     catch (const std::exception &e)
     {
+        probe.error ();
         log_error ("exception caught %s for element %s", e.what (), asset_name.c_str ());
         return -2;
     }
 }
 
+int
+names_to_asset_ids (tntdb::Connection &conn,
+                    const std::vector <std::string> &names,
+                    std::map <std::string, uint32_t> &ids,
+                    std::vector <std::string> &missing)
+{
+    DBMETRICS_PROBE (probe);
+    LOG_START;
+
+    // unique names not known by the dictionary, names differing only in
+    // case and trailing spaces are the same for the database
+    std::vector <std::string> unknown;
+    std::set <std::string> seen;
+    std::set <std::string> found;
+    try {
+        int64_t generation = s_names_generation (conn);
+        for (const auto &name : names) {
+            std::string key;
+            DBSql::fold (name, key);
+            if (name.empty () || !seen.insert (key).second)
+                continue;
+            uint32_t id = 0;
+            std::string stored;
+            if (DBAssetNames::find_id (generation, name, id) && DBAssetNames::find_name (generation, id, stored)) {
+                ids [stored] = id;
+                found.insert (key);
+            }
+            else
+                unknown.push_back (name);
+        }
+
+        for (size_t first = 0; first < unknown.size (); first += DBSql::MAX_IN_LIST) {
+            size_t bucket = DBSql::in_list_bucket (unknown.size () - first);
+            tntdb::Statement st = DBStatementCache::prepare (conn,
+                " SELECT id_asset_element, name"
+                " FROM"
+                "   t_bios_asset_element"
+                " WHERE name IN (" + DBSql::in_list ("name", bucket) + ")");
+            DBSql::bind_in_list (st, "name", unknown, first, bucket);
+
+            tntdb::Result result = st.select ();
+            log_debug("[t_bios_asset_element]: were selected %" PRIu32 " rows", result.size ());
+            probe.rows (result.size ());
+            for (const auto &row : result) {
+                uint32_t id = 0;
+                std::string name;
+                row [0].get (id);
+                row [1].get (name);
+                ids [name] = id;
+                std::string key;
+                DBSql::fold (name, key);
+                found.insert (key);
+            }
+        }
+    }
+    catch (const std::exception &e) {
+        probe.error ();
+        LOG_END_ABNORMAL(e);
+        return -1;
+    }
+
+    for (const auto &name : unknown) {
+        std::string key;
+        DBSql::fold (name, key);
+        if (found.count (key) == 0)
+            missing.push_back (name);
+    }
+    LOG_END;
+    return 0;
+}
+
 int64_t
 name_to_asset_id_check_type (const std::string& asset_name, uint16_t asset_type)
 {
+    DBMETRICS_PROBE (probe);
     try
     {
         int64_t id = 0;
 
-        tntdb::Connection conn = tntdb::connectCached(DBConn::url);
-        tntdb::Statement st = conn.prepareCached(
+        DBConn::connection_t pooled;
+        tntdb::Connection &conn = pooled.get ();
+        static const DBStatementCache::query_t st_query (
                 " SELECT id_asset_element"
                 " FROM"
                 "   t_bios_asset_element"
-                " WHERE name = :asset_name AND id_type = :asset_type"
-                );
+                " WHERE name = :asset_name AND id_type = :asset_type");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         tntdb::Row row = st.set("asset_name", asset_name).set("asset_type", asset_type).selectRow();
         log_debug("[t_bios_asset_element]: were selected %" PRIu32 " rows", 1);
@@ -128,6 +227,7 @@ name_to_asset_id_check_type (const std::string& asset_name, uint16_t asset_type)
     }
     catch (const std::exception &e)
     {
+        probe.error ();
         log_error ("exception caught %s for element %s", e.what (), asset_name.c_str ());
         return -2;
     }
@@ -136,17 +236,23 @@ name_to_asset_id_check_type (const std::string& asset_name, uint16_t asset_type)
 int64_t
 extname_to_asset_id (std::string asset_ext_name)
 {
+    DBMETRICS_PROBE (probe);
     try
     {
         int64_t id = 0;
 
-        tntdb::Connection conn = tntdb::connectCached(DBConn::url);
-        tntdb::Statement st = conn.prepareCached(
+        DBConn::connection_t pooled;
+        tntdb::Connection &conn = pooled.get ();
+        uint32_t known_id = 0;
+        if (DBAssetNames::find_id_by_extname (s_names_generation (conn), asset_ext_name, known_id))
+            return known_id;
+
+        static const DBStatementCache::query_t st_query (
                 " SELECT a.id_asset_element FROM t_bios_asset_element AS a "
                 " INNER JOIN t_bios_asset_ext_attributes AS e "
                 " ON a.id_asset_element = e.id_asset_element "
-                " WHERE keytag = 'name' and value = :extname "
-                );
+                " WHERE keytag = 'name' and value = :extname ");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         tntdb::Row row = st.set("extname", asset_ext_name).selectRow();
         log_debug("[t_bios_asset_element]: were selected %" PRIu32 " rows", 1);
@@ -160,6 +266,7 @@ extname_to_asset_id (std::string asset_ext_name)
     }
     catch (const std::exception &e)
     {
+        probe.error ();
         log_error ("exception caught %s for element '%s'", e.what (), asset_ext_name.c_str ());
         return -2;
     }
@@ -168,15 +275,22 @@ extname_to_asset_id (std::string asset_ext_name)
 int
 name_to_extname (std::string asset_name, std::string &ext_name)
 {
+    DBMETRICS_PROBE (probe);
     try
     {
-        tntdb::Connection conn = tntdb::connectCached(DBConn::url);
-        tntdb::Statement st = conn.prepareCached(
+        DBConn::connection_t pooled;
+        tntdb::Connection &conn = pooled.get ();
+        int64_t generation = s_names_generation (conn);
+        uint32_t known_id = 0;
+        if (DBAssetNames::find_id (generation, asset_name, known_id) && DBAssetNames::find_extname (generation, known_id, ext_name))
+            return 0;
+
+        static const DBStatementCache::query_t st_query (
                 " SELECT e.value FROM t_bios_asset_ext_attributes AS e  "
                 " INNER JOIN t_bios_asset_element AS a "
                 " ON a.id_asset_element = e.id_asset_element "
-                " WHERE keytag = 'name' AND a.name = :asset_name"
-                );
+                " WHERE keytag = 'name' AND a.name = :asset_name");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         tntdb::Row row = st.set("asset_name", asset_name).selectRow();
         log_debug("[t_bios_asset_element]: were selected %" PRIu32 " rows", 1);
@@ -190,6 +304,7 @@ name_to_extname (std::string asset_name, std::string &ext_name)
     }
     catch (const std::exception &e)
     {
+        probe.error ();
         log_error ("exception caught %s for element '%s'", e.what (), asset_name.c_str ());
         return -2;
     }
@@ -198,15 +313,22 @@ name_to_extname (std::string asset_name, std::string &ext_name)
 int
 extname_to_asset_name (std::string asset_ext_name, std::string &asset_name)
 {
+    DBMETRICS_PROBE (probe);
     try
     {
-        tntdb::Connection conn = tntdb::connectCached(DBConn::url);
-        tntdb::Statement st = conn.prepareCached(
+        DBConn::connection_t pooled;
+        tntdb::Connection &conn = pooled.get ();
+        int64_t generation = s_names_generation (conn);
+        uint32_t known_id = 0;
+        if (DBAssetNames::find_id_by_extname (generation, asset_ext_name, known_id) && DBAssetNames::find_name (generation, known_id, asset_name))
+            return 0;
+
+        static const DBStatementCache::query_t st_query (
                 " SELECT a.name FROM t_bios_asset_element AS a "
                 " INNER JOIN t_bios_asset_ext_attributes AS e "
                 " ON a.id_asset_element = e.id_asset_element "
-                " WHERE keytag = 'name' and value = :extname "
-                );
+                " WHERE keytag = 'name' and value = :extname ");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         tntdb::Row row = st.set("extname", asset_ext_name).selectRow();
         log_debug("[t_bios_asset_element]: were selected %" PRIu32 " rows", 1);
@@ -220,11 +342,40 @@ extname_to_asset_name (std::string asset_ext_name, std::string &asset_name)
     }
     catch (const std::exception &e)
     {
+        probe.error ();
         log_error ("exception caught %s for element '%s'", e.what (), asset_ext_name.c_str ());
         return -2;
     }
 }
 
+int64_t
+current_generation (tntdb::Connection &conn)
+{
+    DBMETRICS_PROBE (probe);
+    int64_t generation = DBAssetGeneration::current (conn);
+    if (generation < 0)
+        probe.error ();
+    return generation;
+}
+
+int64_t
+changes_since (tntdb::Connection &conn,
+               uint64_t generation,
+               DBAssetGeneration::change_cb_f cb)
+{
+    DBMETRICS_PROBE (probe);
+    size_t rows = 0;
+    int64_t ret = DBAssetGeneration::changes_since (conn, generation,
+        [&] (const DBChangeNotify::change_t &change, uint64_t made) {
+            rows++;
+            cb (change, made);
+        });
+    probe.rows (rows);
+    if (ret == -1)
+        probe.error ();
+    return ret;
+}
+
 // --------------------------------------------------------------------------
 
 int
@@ -233,10 +384,11 @@ select_asset_element_super_parent (
     uint32_t id,
     std::function<void(const tntdb::Row&)>& cb)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
 
     try{
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " SELECT "
             "   v.id_asset_element as id, "
             "   v.id_parent1 as id_parent1, "
@@ -288,8 +440,8 @@ select_asset_element_super_parent (
             "   v.id_type as id_type "
             " FROM v_bios_asset_element_super_parent AS v "
             " WHERE "
-            "   v.id_asset_element = :id "
-            );
+            "   v.id_asset_element = :id ");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         tntdb::Result res = st.set ("id", id).select ();
 
@@ -300,29 +452,51 @@ select_asset_element_super_parent (
         return 0;
     }
     catch (const std::exception &e) {
+        probe.error ();
         LOG_END_ABNORMAL(e);
         return -1;
     }
 }
 
+// s_stream: pass rows of st to cb as they are fetched from server side
+// cursor, until cb returns false
+// streamed statements are not cached, cursor must not share the statement
+// with the same query run from cb
+// returns number of rows passed to cb
+static size_t
+s_stream (tntdb::Statement &st,
+          row_stream_cb_f &cb,
+          unsigned fetch_size)
+{
+    size_t rows = 0;
+    for (auto it = st.begin (fetch_size); it != st.end (); ++it) {
+        rows++;
+        if (!cb (*it))
+            break;
+    }
+    return rows;
+}
+
+static const DBStatementCache::query_t s_warranty_end_query (
+    " SELECT "
+    "   v.name as name, t.keytag as keytag, t.value as date "
+    " FROM v_web_element v "
+    " JOIN t_bios_asset_ext_attributes t "
+    " ON "
+    "   v.id = t.id_asset_element "
+    " WHERE "
+    "   t.keytag='end_warranty_date' ");
+
 int
 select_asset_element_all_with_warranty_end(
     tntdb::Connection& conn,
     std::function<void(const tntdb::Row&)>& cb)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
 
     try{
-        tntdb::Statement st = conn.prepareCached(
-            " SELECT "
-            "   v.name as name, t.keytag as keytag, t.value as date "
-            " FROM v_web_element v "
-            " JOIN t_bios_asset_ext_attributes t "
-            " ON "
-            "   v.id = t.id_asset_element "
-            " WHERE "
-            "   t.keytag='end_warranty_date' "
-            );
+        tntdb::Statement st = DBStatementCache::prepare (conn, s_warranty_end_query);
 
         tntdb::Result res = st.select();
 
@@ -333,51 +507,129 @@ select_asset_element_all_with_warranty_end(
         return 0;
     }
     catch (const std::exception &e) {
+        probe.error ();
         LOG_END_ABNORMAL(e);
         return -1;
     }
 }
 
+int
+select_asset_element_all_with_warranty_end_stream (tntdb::Connection& conn,
+                                                   row_stream_cb_f cb,
+                                                   unsigned fetch_size)
+{
+    DBMETRICS_PROBE (probe);
+    LOG_START;
+
+    try {
+        tntdb::Statement st = conn.prepare (s_warranty_end_query.sql ());
+        probe.rows (s_stream (st, cb, fetch_size));
+        LOG_END;
+        return 0;
+    }
+    catch (const std::exception &e) {
+        probe.error ();
+        LOG_END_ABNORMAL(e);
+        return -1;
+    }
+}
+
+
+// s_container_ids: ids of all elements contained in container according to
+// DBAssetTree, container itself is the first one if with_container is true
+// returns false if the index is not available and id_parentN columns must be used
+static bool
+s_container_ids (tntdb::Connection &conn,
+                 uint32_t container_id,
+                 bool with_container,
+                 std::vector <uint32_t> &ids)
+{
+    if (DBAssetTree::descendants (conn, container_id, ids) != 0)
+        return false;
+    if (with_container)
+        ids.insert (ids.begin (), container_id);
+    log_debug ("container %" PRIu32 " has %zu elements in the asset tree index", container_id, ids.size ());
+    return true;
+}
+
+// s_in_container: condition selecting elements of the container, either by
+// IN-list of ids from s_container_ids (bucket > 0, binds :id0 ...), or by
+// t_bios_asset_element_closure (closure == true, binds :containerid) or by
+// id_parentN columns of v_bios_asset_element_super_parent (binds :containerid)
+static std::string
+s_in_container (const std::string &alias, size_t bucket, bool closure = false)
+{
+    if (bucket == 0 && closure)
+        return
+            " " + alias + ".id_asset_element IN ("
+            "   SELECT " + alias + "_c.id_descendant"
+            "   FROM t_bios_asset_element_closure AS " + alias + "_c"
+            "   WHERE " + alias + "_c.id_ancestor = :containerid AND " + alias + "_c.depth > 0) ";
+    if (bucket == 0)
+        return
+            " :containerid in (" + alias + ".id_parent1, " + alias + ".id_parent2, " + alias + ".id_parent3, "
+            "                  " + alias + ".id_parent4, " + alias + ".id_parent5, " + alias + ".id_parent6, "
+            "                  " + alias + ".id_parent7, " + alias + ".id_parent8, " + alias + ".id_parent9, "
+            "                  " + alias + ".id_parent10) ";
+    return " " + alias + ".id_asset_element IN (" + DBSql::in_list ("id", bucket) + ") ";
+}
+
+// s_bind_container: bind placeholders of s_in_container
+static void
+s_bind_container (tntdb::Statement &st,
+                  uint32_t container_id,
+                  const std::vector <uint32_t> &ids,
+                  size_t first,
+                  size_t bucket)
+{
+    if (bucket == 0)
+        st.set ("containerid", container_id);
+    else
+        DBSql::bind_in_list (st, "id", ids, first, bucket);
+}
+
+// s_each_row: result callback passing every row to cb
+static result_cb_f
+s_each_row (std::function<void(const tntdb::Row&)> &cb)
+{
+    return [&cb] (const tntdb::Result &result) {
+        for (const auto &row : result)
+            cb (row);
+    };
+}
 
 int
-select_assets_by_container (tntdb::Connection &conn,
-                            uint32_t element_id,
-                            std::vector<uint16_t> types,
-                            std::vector<uint16_t> subtypes,
-                            const std::string &without,
-                            const std::string &status,
-                            std::function<void(const tntdb::Row&)> cb)
+select_assets_by_container_result (tntdb::Connection &conn,
+                                   uint32_t element_id,
+                                   std::vector<uint16_t> types,
+                                   std::vector<uint16_t> subtypes,
+                                   const std::string &without,
+                                   const std::string &status,
+                                   result_cb_f cb)
 {
+    DBMETRICS_PROBE_AS (probe, "select_assets_by_container");
     LOG_START;
     log_debug ("container element_id = %" PRIu32, element_id);
 
+    std::vector <uint32_t> ids;
+    bool indexed = s_container_ids (conn, element_id, false, ids);
+    if (indexed && ids.empty ()) {
+        LOG_END;
+        return 0;
+    }
+    bool closure = !indexed && DBAssetClosure::available (conn);
+
     try {
-        std::string select =
-            " SELECT "
-            "   v.name, "
-            "   v.id_asset_element as asset_id, "
-            "   v.id_asset_device_type as subtype_id, "
-            "   v.type_name as subtype_name, "
-            "   v.id_type as type_id "
-            " FROM "
-            "   v_bios_asset_element_super_parent AS v"
-            " WHERE "
-            "   :containerid in (v.id_parent1, v.id_parent2, v.id_parent3, "
-            "                    v.id_parent4, v.id_parent5, v.id_parent6, "
-            "                    v.id_parent7, v.id_parent8, v.id_parent9, "
-            "                    v.id_parent10)";
+        DBSql::filter_t filter;
+        std::string select;
         if (!subtypes.empty()) {
-            std::string list;
-            for( auto &id: subtypes) list += std::to_string(id) + ",";
-            select += " AND v.id_asset_device_type in (" + list.substr(0,list.size()-1) + ")";
+            select += " AND " + filter.in ("v.id_asset_device_type", subtypes);
         }
         if (!types.empty()) {
-            std::string list;
-            for( auto &id: types) list += std::to_string(id) + ",";
-            select += " AND v.id_type in (" + list.substr(0,list.size()-1) + ")";
+            select += " AND " + filter.in ("v.id_type", types);
         }
         if (status != "") {
-            select += " AND v.status = \"" + status + "\"";
+            select += " AND v.status = " + filter.value (status);
         }
 
         std::string end_select = "" ;
@@ -398,32 +650,60 @@ select_assets_by_container (tntdb::Connection &conn,
                         "  FROM "
                         "     t_bios_asset_ext_attributes as a "
                         "  WHERE "
-                        "     a.keytag=\"" + without + "\""
+                        "     a.keytag=" + filter.value (without) +
                         "     AND v.id_asset_element = a.id_asset_element)";
             }
         }
 
         select += end_select;
 
-        // Can return more than one row.
-        tntdb::Statement st = conn.prepareCached (select);
-
-        tntdb::Result result = st.set("containerid", element_id).
-                                  select();
-        log_debug("[v_bios_asset_element_super_parent]: were selected %" PRIu32 " rows",
-                                                            result.size());
-        for ( auto &row: result ) {
-            cb(row);
-        }
+        size_t first = 0;
+        do {
+            size_t bucket = indexed ? DBSql::in_list_bucket (ids.size () - first) : 0;
+            // Can return more than one row.
+            tntdb::Statement st = DBStatementCache::prepare (conn,
+                " SELECT "
+                "   v.name, "
+                "   v.id_asset_element as asset_id, "
+                "   v.id_asset_device_type as subtype_id, "
+                "   v.type_name as subtype_name, "
+                "   v.id_type as type_id "
+                " FROM "
+                "   v_bios_asset_element_super_parent AS v"
+                " WHERE " + s_in_container ("v", bucket, closure) + select);
+            s_bind_container (st, element_id, ids, first, bucket);
+            filter.bind (st);
+
+            tntdb::Result result = st.select();
+            log_debug("[v_bios_asset_element_super_parent]: were selected %" PRIu32 " rows",
+                                                                result.size());
+            probe.rows (result.size ());
+            cb (result);
+            first += DBSql::MAX_IN_LIST;
+        } while (indexed && first < ids.size ());
         LOG_END;
         return 0;
     }
     catch (const std::exception& e) {
+        probe.error ();
         LOG_END_ABNORMAL(e);
         return -1;
     }
 }
 
+int
+select_assets_by_container (tntdb::Connection &conn,
+                            uint32_t element_id,
+                            std::vector<uint16_t> types,
+                            std::vector<uint16_t> subtypes,
+                            const std::string &without,
+                            const std::string &status,
+                            std::function<void(const tntdb::Row&)> cb)
+{
+    return select_assets_by_container_result (conn, element_id, types, subtypes,
+                                              without, status, s_each_row (cb));
+}
+
 // TODO: is this function used anywhere? I can't find it
 int
 select_assets_by_container (tntdb::Connection &conn,
@@ -431,38 +711,47 @@ select_assets_by_container (tntdb::Connection &conn,
                             std::function<void(const tntdb::Row&)> cb,
                             std::string status)
 {
+    DBMETRICS_PROBE (probe);
     log_debug ("container element_id = %" PRIu32, element_id);
 
+    std::vector <uint32_t> ids;
+    bool indexed = s_container_ids (conn, element_id, false, ids);
+    if (indexed && ids.empty ())
+        return 0;
+    bool closure = !indexed && DBAssetClosure::available (conn);
+
     try {
-        // Can return more than one row.
-        tntdb::Statement st = conn.prepareCached(
-            " SELECT "
-            "   v.name, "
-            "   v.id_asset_element as asset_id, "
-            "   v.id_asset_device_type as subtype_id, "
-            "   v.type_name as subtype_name, "
-            "   v.id_type as type_id "
-            " FROM "
-            "   v_bios_asset_element_super_parent v "
-            " WHERE "
-            "   :containerid in (v.id_parent1, v.id_parent2, v.id_parent3, "
-            "                    v.id_parent4, v.id_parent5, v.id_parent6, "
-            "                    v.id_parent7, v.id_parent8, v.id_parent9, "
-            "                    v.id_parent10)   AND                      "
-            "                    v.status = :vstatus                       "
-        );
-
-        tntdb::Result result = st.set("containerid", element_id).
-                                  set("vstatus", status).
-                                  select();
-        log_debug ("[v_bios_asset_element_super_parent]: were selected %" PRIu32 " rows",
-                                                            result.size());
-        for ( auto &row: result ) {
-            cb(row);
-        }
+        size_t first = 0;
+        do {
+            size_t bucket = indexed ? DBSql::in_list_bucket (ids.size () - first) : 0;
+            // Can return more than one row.
+            tntdb::Statement st = DBStatementCache::prepare (conn,
+                " SELECT "
+                "   v.name, "
+                "   v.id_asset_element as asset_id, "
+                "   v.id_asset_device_type as subtype_id, "
+                "   v.type_name as subtype_name, "
+                "   v.id_type as type_id "
+                " FROM "
+                "   v_bios_asset_element_super_parent v "
+                " WHERE " + s_in_container ("v", bucket, closure) +
+                "   AND v.status = :vstatus ");
+            s_bind_container (st, element_id, ids, first, bucket);
+
+            tntdb::Result result = st.set("vstatus", status).
+                                      select();
+            log_debug ("[v_bios_asset_element_super_parent]: were selected %" PRIu32 " rows",
+                                                                result.size());
+            probe.rows (result.size ());
+            for ( auto &row: result ) {
+                cb(row);
+            }
+            first += DBSql::MAX_IN_LIST;
+        } while (indexed && first < ids.size ());
         return 0;
     }
     catch (const std::exception& e) {
+        probe.error ();
         log_error ("Error: ",e.what());
         return -1;
     }
@@ -483,32 +772,32 @@ select_assets_by_container (tntdb::Connection &conn,
  */
 static std::string
 select_assets_by_container_filter (
-    const std::set<std::string> &types_and_subtypes
+    const std::set<std::string> &types_and_subtypes,
+    DBSql::filter_t &values
 )
 {
-    std::string types, subtypes, filter;
+    std::vector <uint16_t> types, subtypes;
+    std::string filter;
 
     for (const auto &i: types_and_subtypes) {
         uint16_t t = persist::subtype_to_subtypeid (i);
         if (t != persist::asset_subtype::SUNKNOWN) {
-            subtypes +=  "," + std::to_string (t);
+            subtypes.push_back (t);
         } else {
             t = persist::type_to_typeid (i);
             if (t == persist::asset_type::TUNKNOWN) {
                 throw std::invalid_argument ("'" + i + "' is not known type or subtype ");
             }
-            types += "," + std::to_string (t);
+            types.push_back (t);
         }
     }
-    if (!types.empty ()) types = types.substr(1);
-    if (!subtypes.empty ()) subtypes = subtypes.substr(1);
     if (!types.empty () || !subtypes.empty () ) {
         if (!types.empty ()) {
-            filter += " id_type in (" + types + ") ";
+            filter += values.in ("id_type", types);
             if (!subtypes.empty () ) filter += " OR ";
         }
         if (!subtypes.empty ()) {
-            filter += " id_asset_device_type in (" + subtypes + ") ";
+            filter += values.in ("id_asset_device_type", subtypes);
         }
     }
     log_debug ("filter: '%s'", filter.c_str ());
@@ -521,59 +810,77 @@ select_assets_by_container_name_filter (tntdb::Connection &conn,
                                         const std::set <std::string>& filter,
                                         std::vector <std::string>& assets)
 {
+    DBMETRICS_PROBE (probe);
     uint32_t id = 0;
 
     try {
         if (! container_name.empty ()) {
             // get container asset id
-            tntdb::Statement select_id = conn.prepareCached(
+            static const DBStatementCache::query_t select_id_query (
                 " SELECT "
                 "   v.id "
                 " FROM "
                 "   v_bios_asset_element v "
                 " WHERE "
-                "   v.name = :name "
-            );
+                "   v.name = :name ");
+            tntdb::Statement select_id = DBStatementCache::prepare (conn, select_id_query);
 
             tntdb::Row row = select_id.set("name", container_name).
                                 selectRow();
             row["id"].get(id);
         }
-        //Selects assets in a given container
-        std::string request =
-            " SELECT "
-            "   v.name, "
-            "   v.id_asset_element as asset_id, "
-            "   v.id_asset_device_type as subtype_id, "
-            "   v.type_name as subtype_name, "
-            "   v.id_type as type_id "
-            " FROM "
-            "   v_bios_asset_element_super_parent v "
-            " WHERE "
-            "   (:containerid in (v.id_parent1, v.id_parent2, v.id_parent3, "
-            "                     v.id_parent4, v.id_parent5, v.id_parent6, "
-            "                     v.id_parent7, v.id_parent8, v.id_parent9, "
-            "                     v.id_parent10) OR :containerid = 0 ) ";
-
+        std::vector <uint32_t> ids;
+        bool indexed = id != 0 && s_container_ids (conn, id, false, ids);
+        if (indexed && ids.empty ())
+            return 0;
+        bool closure = id != 0 && !indexed && DBAssetClosure::available (conn);
+
+        DBSql::filter_t values;
+        std::string filter_sql;
         if(!filter.empty())
-            request += " AND ( " + select_assets_by_container_filter (filter) +")";
-        log_debug("[v_bios_asset_element_super_parent]: %s", request.c_str());
-
-        // Can return more than one row.
-        tntdb::Statement select_data = conn.prepareCached(request);
+            filter_sql = " AND ( " + select_assets_by_container_filter (filter, values) +")";
 
-        tntdb::Result result = select_data.set("containerid", id).
-                                  select();
-        log_debug("[v_bios_asset_element_super_parent]: were selected %" PRIu32 " rows",
-                                                            result.size());
-        for ( auto &row: result ) {
-            std::string name;
-            row["name"].get (name);
-            assets.push_back (name);
-        }
+        size_t first = 0;
+        do {
+            size_t bucket = indexed ? DBSql::in_list_bucket (ids.size () - first) : 0;
+            //Selects assets in a given container
+            std::string request =
+                " SELECT "
+                "   v.name, "
+                "   v.id_asset_element as asset_id, "
+                "   v.id_asset_device_type as subtype_id, "
+                "   v.type_name as subtype_name, "
+                "   v.id_type as type_id "
+                " FROM "
+                "   v_bios_asset_element_super_parent v "
+                " WHERE ";
+            if (indexed || closure)
+                request += s_in_container ("v", bucket, closure);
+            else
+                request += " (" + s_in_container ("v", 0) + " OR :containerid = 0 ) ";
+            request += filter_sql;
+            log_debug("[v_bios_asset_element_super_parent]: %s", request.c_str());
+
+            // Can return more than one row.
+            tntdb::Statement select_data = DBStatementCache::prepare (conn, request);
+            s_bind_container (select_data, id, ids, first, bucket);
+            values.bind (select_data);
+
+            tntdb::Result result = select_data.select();
+            log_debug("[v_bios_asset_element_super_parent]: were selected %" PRIu32 " rows",
+                                                                result.size());
+            probe.rows (result.size ());
+            for ( auto &row: result ) {
+                std::string name;
+                row["name"].get (name);
+                assets.push_back (name);
+            }
+            first += DBSql::MAX_IN_LIST;
+        } while (indexed && first < ids.size ());
         return 0;
     }
     catch (const std::exception& e) {
+        probe.error ();
         log_error ("Error: ", e.what());
         return -1;
     }
@@ -584,6 +891,7 @@ select_assets_by_filter (tntdb::Connection &conn,
                          const std::set<std::string> &types_and_subtypes,
                          std::vector <std::string>& assets)
 {
+    DBMETRICS_PROBE (probe);
     try {
         std::string request =
             " SELECT "
@@ -595,14 +903,17 @@ select_assets_by_filter (tntdb::Connection &conn,
             " FROM "
             "   v_bios_asset_element_super_parent v ";
 
+        DBSql::filter_t values;
         if(!types_and_subtypes.empty())
-            request += " WHERE " + select_assets_by_container_filter (types_and_subtypes);
+            request += " WHERE " + select_assets_by_container_filter (types_and_subtypes, values);
         log_debug("[v_bios_asset_element_super_parent]: %s", request.c_str());
         // Can return more than one row.
-        tntdb::Statement st = conn.prepareCached(request);
+        tntdb::Statement st = DBStatementCache::prepare (conn, request);
+        values.bind (st);
         tntdb::Result result = st.select();
         log_debug("[v_bios_asset_element_super_parent]: were selected %" PRIu32 " rows",
                                                             result.size());
+        probe.rows (result.size ());
         for ( auto &row: result ) {
             std::string name;
             row["name"].get (name);
@@ -611,17 +922,19 @@ select_assets_by_filter (tntdb::Connection &conn,
         return 0;
     }
     catch (const std::exception& e) {
+        probe.error ();
         log_error ("Error: ",e.what());
         return -1;
     }
 }
 
 int
-select_assets_without_container (tntdb::Connection &conn,
-                                 std::vector<uint16_t> types,
-                                 std::vector<uint16_t> subtypes,
-                                 std::function<void(const tntdb::Row&)> cb)
+select_assets_without_container_result (tntdb::Connection &conn,
+                                        std::vector<uint16_t> types,
+                                        std::vector<uint16_t> subtypes,
+                                        result_cb_f cb)
 {
+    DBMETRICS_PROBE_AS (probe, "select_assets_without_container");
     LOG_START;
 
     try {
@@ -635,118 +948,175 @@ select_assets_without_container (tntdb::Connection &conn,
             "   t_bios_asset_element AS t "
             " WHERE "
             "   t.id_parent is NULL";
+        DBSql::filter_t filter;
         if (!subtypes.empty()) {
-            std::string list;
-            for( auto &id: subtypes) list += std::to_string(id) + ",";
-            select += " and t.id_subtype in (" + list.substr(0,list.size()-1) + ")";
+            select += " and " + filter.in ("t.id_subtype", subtypes);
         }
         if (!types.empty()) {
-            std::string list;
-            for( auto &id: types) list += std::to_string(id) + ",";
-            select += " and t.id_type in (" + list.substr(0,list.size()-1) + ")";
+            select += " and " + filter.in ("t.id_type", types);
         }
         // Can return more than one row.
-        tntdb::Statement st = conn.prepareCached (select);
+        tntdb::Statement st = DBStatementCache::prepare (conn, select);
+        filter.bind (st);
 
         tntdb::Result result = st.select();
         log_debug ("[t_bios_asset_element]: were selected %" PRIu32 " rows",
                                                             result.size());
-        for ( auto &row: result ) {
-            cb(row);
-        }
+        probe.rows (result.size ());
+        cb (result);
         LOG_END;
         return 0;
     }
     catch (const std::exception& e) {
+        probe.error ();
         LOG_END_ABNORMAL(e);
         return -1;
     }
 }
 
 int
-select_assets_all_container (tntdb::Connection &conn,
-                             std::vector<uint16_t> types,
-                             std::vector<uint16_t> subtypes,
-                             const std::string &without,
-                             const std::string &status,
-                             std::function<void(const tntdb::Row&)> cb)
+select_assets_without_container (tntdb::Connection &conn,
+                                 std::vector<uint16_t> types,
+                                 std::vector<uint16_t> subtypes,
+                                 std::function<void(const tntdb::Row&)> cb)
 {
-    LOG_START;
-
-    try {
-        std::string select =
-            " SELECT "
-            "   t.name, "
-            "   t.id_asset_element as asset_id, "
-            "   t.id_type as type_id, "
-            "   t.id_subtype as subtype_id "
-            " FROM "
-            "   t_bios_asset_element as t";
+    return select_assets_without_container_result (conn, types, subtypes, s_each_row (cb));
+}
 
-        if(!subtypes.empty() || !types.empty() || status != "" || without != "") {
-          select += " WHERE ";
+// s_all_container_sql: query of select_assets_all_container
+// values are added to filter
+static std::string
+s_all_container_sql (const std::vector<uint16_t> &types,
+                     const std::vector<uint16_t> &subtypes,
+                     const std::string &without,
+                     const std::string &status,
+                     DBSql::filter_t &filter)
+{
+    std::string select =
+        " SELECT "
+        "   t.name, "
+        "   t.id_asset_element as asset_id, "
+        "   t.id_type as type_id, "
+        "   t.id_subtype as subtype_id "
+        " FROM "
+        "   t_bios_asset_element as t";
+
+    if(!subtypes.empty() || !types.empty() || status != "" || without != "") {
+      select += " WHERE ";
+    }
+    if (!subtypes.empty()) {
+        select += filter.in ("t.id_subtype", subtypes);
+    }
+    if (!types.empty()) {
+        if(!subtypes.empty() ) {
+          select += " AND ";
         }
-        if (!subtypes.empty()) {
-            std::string list;
-            for( auto &id: subtypes) list += std::to_string(id) + ",";
-            select += " t.id_subtype in (" + list.substr(0,list.size()-1) + ")";
+        select += filter.in ("t.id_type", types);
+    }
+    if (status != "") {
+        if(!subtypes.empty() || !types.empty()) {
+          select += " AND ";
         }
-        if (!types.empty()) {
-            if(!subtypes.empty() ) {
-              select += " AND ";
-            }
-            std::string list;
-            for( auto &id: types) list += std::to_string(id) + ",";
-            select += " t.id_type in (" + list.substr(0,list.size()-1) + ")";
+        select += " t.status = " + filter.value (status);
+    }
+
+    std::string end_select = "" ;
+    if (without != "") {
+        if(!subtypes.empty() || !types.empty() || status != "" ) {
+          select += " AND ";
         }
-        if (status != "") {
-            if(!subtypes.empty() || !types.empty()) {
-              select += " AND ";
-            }
-            select += " t.status = \"" + status + "\"";
+        if(without == "location") {
+            select += " t.id_parent is NULL ";
+        } else if (without == "powerchain") {
+            end_select += " NOT EXISTS "
+                    " (SELECT id_asset_device_dest "
+                    "  FROM t_bios_asset_link_type as l JOIN t_bios_asset_link as a"
+                    "  ON a.id_asset_link_type=l.id_asset_link_type "
+                    "  WHERE "
+                    "     name=\"power chain\" "
+                    "     AND t.id_asset_element=a.id_asset_device_dest)";
+        } else {
+            end_select += " NOT EXISTS "
+                    " (SELECT a.id_asset_element "
+                    "  FROM "
+                    "     t_bios_asset_ext_attributes as a "
+                    "  WHERE "
+                    "     a.keytag=" + filter.value (without) +
+                    "     AND t.id_asset_element = a.id_asset_element)";
         }
+    }
 
-        std::string end_select = "" ;
-        if (without != "") {
-            if(!subtypes.empty() || !types.empty() || status != "" ) {
-              select += " AND ";
-            }
-            if(without == "location") {
-                select += " t.id_parent is NULL ";
-            } else if (without == "powerchain") {
-                end_select += " NOT EXISTS "
-                        " (SELECT id_asset_device_dest "
-                        "  FROM t_bios_asset_link_type as l JOIN t_bios_asset_link as a"
-                        "  ON a.id_asset_link_type=l.id_asset_link_type "
-                        "  WHERE "
-                        "     name=\"power chain\" "
-                        "     AND t.id_asset_element=a.id_asset_device_dest)";
-            } else {
-                end_select += " NOT EXISTS "
-                        " (SELECT a.id_asset_element "
-                        "  FROM "
-                        "     t_bios_asset_ext_attributes as a "
-                        "  WHERE "
-                        "     a.keytag=\"" + without + "\""
-                        "     AND t.id_asset_element = a.id_asset_element)";
-            }
-        }
+    select += end_select;
+    return select;
+}
 
-        select += end_select;
+int
+select_assets_all_container_result (tntdb::Connection &conn,
+                                    std::vector<uint16_t> types,
+                                    std::vector<uint16_t> subtypes,
+                                    const std::string &without,
+                                    const std::string &status,
+                                    result_cb_f cb)
+{
+    DBMETRICS_PROBE_AS (probe, "select_assets_all_container");
+    LOG_START;
+
+    try {
+        DBSql::filter_t filter;
+        std::string select = s_all_container_sql (types, subtypes, without, status, filter);
 
         // Can return more than one row.
-        tntdb::Statement st = conn.prepareCached (select);
+        tntdb::Statement st = DBStatementCache::prepare (conn, select);
+        filter.bind (st);
 
         tntdb::Result result = st.select();
         log_debug("[t_bios_asset_element]: were selected %" PRIu32 " rows",
                                                             result.size());
-        for ( auto &row: result ) {
-            cb(row);
-        }
+        probe.rows (result.size ());
+        cb (result);
         LOG_END;
         return 0;
     }
     catch (const std::exception& e) {
+        probe.error ();
+        LOG_END_ABNORMAL(e);
+        return -1;
+    }
+}
+
+int
+select_assets_all_container (tntdb::Connection &conn,
+                             std::vector<uint16_t> types,
+                             std::vector<uint16_t> subtypes,
+                             const std::string &without,
+                             const std::string &status,
+                             std::function<void(const tntdb::Row&)> cb)
+{
+    return select_assets_all_container_result (conn, types, subtypes, without, status, s_each_row (cb));
+}
+
+int
+select_assets_all_container_stream (tntdb::Connection &conn,
+                                    std::vector<uint16_t> types,
+                                    std::vector<uint16_t> subtypes,
+                                    const std::string &without,
+                                    const std::string &status,
+                                    row_stream_cb_f cb,
+                                    unsigned fetch_size)
+{
+    DBMETRICS_PROBE (probe);
+    LOG_START;
+
+    try {
+        DBSql::filter_t filter;
+        tntdb::Statement st = conn.prepare (s_all_container_sql (types, subtypes, without, status, filter));
+        filter.bind (st);
+        probe.rows (s_stream (st, cb, fetch_size));
+        LOG_END;
+        return 0;
+    }
+    catch (const std::exception& e) {
+        probe.error ();
         LOG_END_ABNORMAL(e);
         return -1;
     }
@@ -758,8 +1128,42 @@ select_asset_element_by_dc
      int64_t dc_id,
      std::function<void(const tntdb::Row&)> cb)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
 
+    // the index only tells that DC has no descendants, its own row is then
+    // selected by id; IN-lists of all descendants would cost a round trip
+    // per MAX_IN_LIST ids, the nested SELECT below is one
+    std::vector <uint32_t> ids;
+    if (dc_id >= 0 && s_container_ids (conn, static_cast <uint32_t> (dc_id), false, ids) && ids.empty ()) {
+        try {
+            static const DBStatementCache::query_t st_query (
+                "SELECT "
+                "   v.id, v.name, v.type_name, "
+                "   v.subtype_name, v.id_parent, "
+                "   v.status, v.priority, "
+                "   v.asset_tag "
+                " FROM "
+                "   v_web_element v "
+                "WHERE "
+                "   v.id = :containerid");
+            tntdb::Statement select_data = DBStatementCache::prepare (conn, st_query);
+
+            tntdb::Result result = select_data.set("containerid", dc_id).select();
+
+            for (const auto& r: result) {
+                cb(r);
+            }
+            LOG_END;
+            return 0;
+        }
+        catch (const std::exception &e) {
+            probe.error ();
+            LOG_END_ABNORMAL(e);
+            return -1;
+        }
+    }
+
     try{
         // use nested SELECT instead of three-table JOIN
         std::string st =
@@ -772,15 +1176,23 @@ select_asset_element_by_dc
             "   v_web_element v "
             "WHERE "
             "   v.id in "
-            "   ( "
+            "   ( ";
+        if (DBAssetClosure::available (conn))
+            st +=
+                " SELECT c.id_descendant "
+                " FROM t_bios_asset_element_closure c "
+                " WHERE "
+                "   c.id_ancestor = :containerid ";
+        else
+            st +=
                 " SELECT p.id_asset_element "
                 " FROM v_bios_asset_element_super_parent p "
                 " WHERE "
                 "   :containerid in ( p.id_asset_element, p.id_parent1, p.id_parent2, "
                 "                     p.id_parent3, p.id_parent4, p.id_parent5, "
                 "                     p.id_parent6, p.id_parent7, p.id_parent8, "
-                "                     p.id_parent9, p.id_parent10) "
-            "   ) ";
+                "                     p.id_parent9, p.id_parent10) ";
+        st += "   ) ";
 
         //DO NOT CACHE THIS! It will crash MySQL
         tntdb::Statement select_data = conn.prepare(st);
@@ -794,37 +1206,67 @@ select_asset_element_by_dc
         return 0;
     }
     catch (const std::exception &e) {
+        probe.error ();
         LOG_END_ABNORMAL(e);
         return -1;
     }
 }
 
+static const DBStatementCache::query_t s_element_all_query (
+    " SELECT"
+    "   v.id, v.name, v.type_name,"
+    "   v.subtype_name, v.id_parent, v.id_parent_type,"
+    "   v.status, v.priority,"
+    "   v.asset_tag"
+    " FROM"
+    "   v_web_element v");
+
 int
-select_asset_element_all (tntdb::Connection& conn,
-                          std::function<void(const tntdb::Row&)>& cb)
+select_asset_element_all_result (tntdb::Connection& conn,
+                                 result_cb_f cb)
 {
+    DBMETRICS_PROBE_AS (probe, "select_asset_element_all");
     LOG_START;
 
     try{
-        tntdb::Statement st = conn.prepareCached(
-            " SELECT"
-            "   v.id, v.name, v.type_name,"
-            "   v.subtype_name, v.id_parent, v.id_parent_type,"
-            "   v.status, v.priority,"
-            "   v.asset_tag"
-            " FROM"
-            "   v_web_element v"
-        );
+        tntdb::Statement st = DBStatementCache::prepare (conn, s_element_all_query);
 
         tntdb::Result res = st.select();
 
-        for (const auto& r: res) {
-            cb(r);
-        }
+        cb (res);
         LOG_END;
         return 0;
     }
     catch (const std::exception &e) {
+        probe.error ();
+        LOG_END_ABNORMAL(e);
+        return -1;
+    }
+}
+
+int
+select_asset_element_all (tntdb::Connection& conn,
+                          std::function<void(const tntdb::Row&)>& cb)
+{
+    return select_asset_element_all_result (conn, s_each_row (cb));
+}
+
+int
+select_asset_element_all_stream (tntdb::Connection& conn,
+                                 row_stream_cb_f cb,
+                                 unsigned fetch_size)
+{
+    DBMETRICS_PROBE (probe);
+    LOG_START;
+
+    try {
+        tntdb::Statement st = conn.prepare (s_element_all_query.sql ());
+        probe.rows (s_stream (st, cb, fetch_size));
+        LOG_END;
+        return 0;
+    }
+    catch (const std::exception &e) {
+        probe.error ();
         LOG_END_ABNORMAL(e);
         return -1;
     }
@@ -836,15 +1278,16 @@ convert_asset_to_monitor (tntdb::Connection &conn,
                           uint32_t asset_element_id,
                           uint16_t &monitor_element_id)
 {
+    DBMETRICS_PROBE (probe);
     try{
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " SELECT "
             "   v.id_discovered_device "
             " FROM "
             "   v_bios_monitor_asset_relation v "
             " WHERE "
-            "   v.id_asset_element = :id "
-        );
+            "   v.id_asset_element = :id ");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         tntdb::Value value = st.set("id", asset_element_id).
                                 selectValue();
@@ -859,6 +1302,7 @@ convert_asset_to_monitor (tntdb::Connection &conn,
         return 0;
     }
     catch (const std::exception &e) {
+        probe.error ();
         LOG_END_ABNORMAL(e);
         return -1;
     }
@@ -870,14 +1314,20 @@ count_keytag(
         const std::string &keytag,
         const std::string &value)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
+    std::vector <uint32_t> ids;
+    if (DBKeytagIndex::find (conn, keytag, value, ids) == 0) {
+        LOG_END;
+        return static_cast <int> (ids.size ());
+    }
     try{
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " SELECT COUNT( * ) "
             " FROM t_bios_asset_ext_attributes "
             " WHERE keytag = :keytag AND"
-            "       value = :value"
-        );
+            "       value = :value");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         tntdb::Row row = st.set("keytag", keytag)
                            .set("value", value)
@@ -889,6 +1339,7 @@ count_keytag(
         return r;
     }
     catch (const std::exception &e) {
+        probe.error ();
         LOG_END_ABNORMAL(e);
         return -1;
     }
@@ -900,17 +1351,27 @@ unique_keytag (tntdb::Connection &conn,
                const std::string &value,
                uint32_t       element_id)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
 
+    std::vector <uint32_t> ids;
+    if (DBKeytagIndex::find (conn, keytag, value, ids) == 0) {
+        LOG_END;
+        for (auto id : ids) {
+            if (id != element_id)
+                return 1; // is not ok
+        }
+        return 0; // is ok
+    }
     try{
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " SELECT "
             "   id_asset_element "
             " FROM "
             "   t_bios_asset_ext_attributes "
             " WHERE keytag = :keytag AND"
-            "       value = :value"
-        );
+            "       value = :value");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         tntdb::Row row = st.set("keytag", keytag)
                            .set("value", value)
@@ -930,6 +1391,7 @@ unique_keytag (tntdb::Connection &conn,
         return 0; // ok
     }
     catch (const std::exception &e) {
+        probe.error ();
         LOG_END_ABNORMAL(e);
         return -1;
     }
@@ -938,16 +1400,17 @@ unique_keytag (tntdb::Connection &conn,
 int
 max_number_of_power_links (tntdb::Connection& conn)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
 
     try{
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " SELECT "
             "   MAX(power_src_count) "
             " FROM "
             "   ( SELECT COUNT(*) power_src_count FROM t_bios_asset_link "
-            "            GROUP BY id_asset_device_dest) pwr "
-        );
+            "            GROUP BY id_asset_device_dest) pwr ");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         tntdb::Row row = st.selectRow();
 
@@ -957,6 +1420,7 @@ max_number_of_power_links (tntdb::Connection& conn)
         return r;
     }
     catch (const std::exception &e) {
+        probe.error ();
         LOG_END_ABNORMAL(e);
         return -1;
     }
@@ -966,15 +1430,16 @@ int
 count_of_link_src (tntdb::Connection& conn,
                    uint32_t id)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
     static const int id_asset_link_type = 1;
     try{
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " SELECT COUNT( * ) "
             " FROM v_bios_asset_link "
             " WHERE id_asset_element_src = :id AND"
-            "       id_asset_link_type = :lt "
-        );
+            "       id_asset_link_type = :lt ");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         tntdb::Row row = st.\
             set("id", id).\
@@ -987,6 +1452,7 @@ count_of_link_src (tntdb::Connection& conn,
         return r;
     }
     catch (const std::exception &e) {
+        probe.error ();
         LOG_END_ABNORMAL(e);
         return -1;
     }
@@ -996,16 +1462,17 @@ count_of_link_src (tntdb::Connection& conn,
 int
 max_number_of_asset_groups (tntdb::Connection& conn)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
 
     try{
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " SELECT "
             "   MAX(grp_count) "
             " FROM "
             "   ( SELECT COUNT(*) grp_count FROM t_bios_asset_group_relation "
-            "            GROUP BY id_asset_element) elmnt_grp "
-        );
+            "            GROUP BY id_asset_element) elmnt_grp ");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         tntdb::Row row = st.selectRow();
 
@@ -1015,6 +1482,7 @@ max_number_of_asset_groups (tntdb::Connection& conn)
         return r;
     }
     catch (const std::exception &e) {
+        probe.error ();
         LOG_END_ABNORMAL(e);
         return -1;
     }
@@ -1025,17 +1493,18 @@ select_group_names (tntdb::Connection& conn,
                     uint32_t id,
                     std::function<void(const tntdb::Row&)> cb)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
     log_debug("id: %" PRIu32, id);
     try{
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " SELECT "
             "   v2.name "
             " FROM v_bios_asset_group_relation v1 "
             " JOIN v_bios_asset_element v2 "
             "   ON v1.id_asset_group=v2.id "
-            " WHERE v1.id_asset_element=:id "
-        );
+            " WHERE v1.id_asset_element=:id ");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         tntdb::Result res = st.set("id", id).select();
 
@@ -1046,6 +1515,7 @@ select_group_names (tntdb::Connection& conn,
         return 0;
     }
     catch (const std::exception &e) {
+        probe.error ();
         LOG_END_ABNORMAL(e);
         return -1;
     }
@@ -1071,10 +1541,11 @@ select_v_web_asset_power_link_src_byId (tntdb::Connection& conn,
                                         uint32_t id,
                                         row_cb_f& cb)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
     log_debug("id: %" PRIu32, id);
     try{
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " SELECT "
             "   v.id_link, "
             "   v.id_asset_element_src, "
@@ -1085,8 +1556,8 @@ select_v_web_asset_power_link_src_byId (tntdb::Connection& conn,
             "   v.dest_in "
             " FROM v_web_asset_link v "
             " WHERE v.id_asset_element_dest=:id "
-            " AND v.link_name = 'power chain' "
-        );
+            " AND v.link_name = 'power chain' ");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         tntdb::Result res = st.set("id", id).select();
 
@@ -1097,6 +1568,7 @@ select_v_web_asset_power_link_src_byId (tntdb::Connection& conn,
         return 0;
     }
     catch (const std::exception &e) {
+        probe.error ();
         LOG_END_ABNORMAL(e);
         return -1;
     }
@@ -1108,28 +1580,33 @@ select_asset_ext_attribute_by_keytag (tntdb::Connection &conn,
                                       const std::set<uint32_t> &element_ids,
                                       std::function< void( const tntdb::Row& ) > &cb)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
     try{
-        std::string inlist;
-        for( const auto &id : element_ids ) {
-            inlist += ",";
-            inlist += std::to_string(id);
-        }
-        tntdb::Statement st = conn.prepareCached(
-            " SELECT "
-            "   id_asset_ext_attribute, keytag, value, "
-            "   id_asset_element, read_only "
-            " FROM "
-            "   v_bios_asset_ext_attributes "
-            " WHERE keytag = :keytag" +
-            ( element_ids.empty() ? "" : " AND id_asset_element in (" + inlist.substr(1) + ")" )
-        );
-        tntdb::Result rows = st.set("keytag", keytag ).select();
-        for( const auto &row: rows ) cb( row );
+        std::vector <uint32_t> ids (element_ids.begin (), element_ids.end ());
+        size_t first = 0;
+        do {
+            size_t bucket = ids.empty () ? 0 : DBSql::in_list_bucket (ids.size () - first);
+            tntdb::Statement st = DBStatementCache::prepare (conn,
+                " SELECT "
+                "   id_asset_ext_attribute, keytag, value, "
+                "   id_asset_element, read_only "
+                " FROM "
+                "   v_bios_asset_ext_attributes "
+                " WHERE keytag = :keytag" +
+                ( bucket == 0 ? "" : " AND id_asset_element in (" + DBSql::in_list ("id", bucket) + ")" ));
+            if (bucket != 0)
+                DBSql::bind_in_list (st, "id", ids, first, bucket);
+            tntdb::Result rows = st.set("keytag", keytag ).select();
+            probe.rows (rows.size ());
+            for( const auto &row: rows ) cb( row );
+            first += DBSql::MAX_IN_LIST;
+        } while (first < ids.size ());
         LOG_END;
         return 0;
     }
     catch (const std::exception &e) {
+        probe.error ();
         LOG_END_ABNORMAL(e);
         return -1;
     }
@@ -1139,17 +1616,18 @@ int
 select_ext_rw_attributes_keytags (tntdb::Connection& conn,
                                   std::function<void(const tntdb::Row&)>& cb)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
     try{
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " SELECT"
             "   DISTINCT(keytag)"
             " FROM"
             "   v_bios_asset_ext_attributes"
             " WHERE "
             "   read_only = 0"
-            " ORDER BY keytag "
-        );
+            " ORDER BY keytag ");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         tntdb::Result res = st.select();
 
@@ -1160,6 +1638,7 @@ select_ext_rw_attributes_keytags (tntdb::Connection& conn,
         return 0;
     }
     catch (const std::exception &e) {
+        probe.error ();
         LOG_END_ABNORMAL(e);
         return -1;
     }
@@ -1170,19 +1649,21 @@ select_ext_attributes_cb (tntdb::Connection &conn,
                        uint32_t asset_id,
                        std::function<void(const tntdb::Row&)> cb)
 {
+    DBMETRICS_PROBE (probe);
     try {
         // Can return more than one row
-        tntdb::Statement st_extattr = conn.prepareCached(
+        static const DBStatementCache::query_t st_extattr_query (
             " SELECT"
             "   v.keytag, v.value, v.read_only"
             " FROM"
             "   v_bios_asset_ext_attributes v"
-            " WHERE v.id_asset_element = :asset_id"
-        );
+            " WHERE v.id_asset_element = :asset_id");
+        tntdb::Statement st_extattr = DBStatementCache::prepare (conn, st_extattr_query);
 
         tntdb::Result result = st_extattr.set("asset_id", asset_id).
                                           select();
         log_debug("[v_bios_asset_ext_attributes]: were selected %" PRIu32 " rows", result.size());
+        probe.rows (result.size ());
 
         // Go through the selected extra attributes
         for ( const auto &row: result ) {
@@ -1191,19 +1672,129 @@ select_ext_attributes_cb (tntdb::Connection &conn,
         return 0;
     }
     catch (const std::exception &e) {
+        probe.error ();
         log_error ("select_ext: %s", e.what());
         return -1;
     }
 }
 
+static const char *s_ext_attributes_of_columns =
+    " SELECT"
+    "   a.id_asset_element, a.keytag, a.value, a.read_only"
+    " FROM"
+    "   v_bios_asset_ext_attributes a";
+
+// s_ext_attributes_of_ids: attributes of ids, chunked by MAX_IN_LIST,
+// ids must be sorted, so rows of all chunks come in element order
+// returns number of rows
+static size_t
+s_ext_attributes_of_ids (tntdb::Connection &conn,
+                         const std::vector <uint32_t> &ids,
+                         result_cb_f &cb)
+{
+    size_t rows = 0;
+    for (size_t first = 0; first < ids.size (); first += DBSql::MAX_IN_LIST) {
+        size_t bucket = DBSql::in_list_bucket (ids.size () - first);
+        tntdb::Statement st = DBStatementCache::prepare (conn,
+            std::string (s_ext_attributes_of_columns) +
+            " WHERE a.id_asset_element IN (" + DBSql::in_list ("id", bucket) + ")"
+            " ORDER BY a.id_asset_element");
+        DBSql::bind_in_list (st, "id", ids, first, bucket);
+
+        tntdb::Result result = st.select ();
+        log_debug ("[v_bios_asset_ext_attributes]: were selected %" PRIu32 " rows", result.size ());
+        rows += result.size ();
+        cb (result);
+    }
+    return rows;
+}
+
+int
+select_ext_attributes_of_result (tntdb::Connection &conn,
+                                 const std::vector <uint32_t> &ids,
+                                 result_cb_f cb)
+{
+    DBMETRICS_PROBE_AS (probe, "select_ext_attributes_of");
+    LOG_START;
+    log_debug ("%zu elements", ids.size ());
+
+    std::vector <uint32_t> sorted (ids);
+    std::sort (sorted.begin (), sorted.end ());
+    sorted.erase (std::unique (sorted.begin (), sorted.end ()), sorted.end ());
+    try {
+        probe.rows (s_ext_attributes_of_ids (conn, sorted, cb));
+        LOG_END;
+        return 0;
+    }
+    catch (const std::exception &e) {
+        probe.error ();
+        LOG_END_ABNORMAL(e);
+        return -1;
+    }
+}
+
+int
+select_ext_attributes_of (tntdb::Connection &conn,
+                          const std::vector <uint32_t> &ids,
+                          std::vector <ext_attribute_t> &out)
+{
+    out.clear ();
+    return select_ext_attributes_of <ext_attribute_t> (conn, ids,
+        [&out] (const ext_attribute_t &a) { out.push_back (a); });
+}
+
+int
+select_ext_attributes_in_container_result (tntdb::Connection &conn,
+                                           uint32_t container_id,
+                                           result_cb_f cb)
+{
+    DBMETRICS_PROBE_AS (probe, "select_ext_attributes_in_container");
+    LOG_START;
+    log_debug ("container element_id = %" PRIu32, container_id);
+
+    try {
+        std::vector <uint32_t> ids;
+        if (s_container_ids (conn, container_id, false, ids)) {
+            std::sort (ids.begin (), ids.end ());
+            probe.rows (s_ext_attributes_of_ids (conn, ids, cb));
+            LOG_END;
+            return 0;
+        }
+
+        std::string sql (s_ext_attributes_of_columns);
+        if (DBAssetClosure::available (conn))
+            sql += " WHERE " + s_in_container ("a", 0, true);
+        else
+            sql +=
+                " JOIN v_bios_asset_element_super_parent p"
+                "   ON p.id_asset_element = a.id_asset_element"
+                " WHERE " + s_in_container ("p", 0);
+        tntdb::Statement st = DBStatementCache::prepare (conn, sql + " ORDER BY a.id_asset_element");
+        s_bind_container (st, container_id, ids, 0, 0);
+
+        tntdb::Result result = st.select ();
+        log_debug ("[v_bios_asset_ext_attributes]: were selected %" PRIu32 " rows", result.size ());
+        probe.rows (result.size ());
+        cb (result);
+        LOG_END;
+        return 0;
+    }
+    catch (const std::exception &e) {
+        probe.error ();
+        LOG_END_ABNORMAL(e);
+        return -1;
+    }
+}
+
 int
 select_asset_element_basic_cb (tntdb::Connection &conn,
                              const std::string &asset_name,
                              std::function<void(const tntdb::Row&)> cb)
 {
+    DBMETRICS_PROBE (probe);
     log_debug ("asset_name = %s", asset_name.c_str());
     try{
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " SELECT"
             "   v.id, v.name, v.id_type, v.type_name,"
             "   v.subtype_id, v.id_parent,"
@@ -1211,8 +1802,8 @@ select_asset_element_basic_cb (tntdb::Connection &conn,
             "   v.priority, v.asset_tag, v.parent_name "
             " FROM"
             "   v_web_element v"
-            " WHERE :name = v.name"
-        );
+            " WHERE :name = v.name");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         tntdb::Row row = st.set("name", asset_name).
                             selectRow();
@@ -1225,36 +1816,38 @@ select_asset_element_basic_cb (tntdb::Connection &conn,
         return -1;
     }
     catch (const std::exception &e) {
+        probe.error ();
         log_error ("Cannot select basic asset info: %s", e.what());
         return -1;
     }
 }
 
+static const DBStatementCache::query_t s_assets_query (
+    " SELECT "
+    "   v.name, "
+    "   v.id,  "
+    "   v.id_type,  "
+    "   v.id_subtype,  "
+    "   v.id_parent,  "
+    "   v.parent_name,  "
+    "   v.status,  "
+    "   v.priority,  "
+    "   v.asset_tag  "
+    " FROM v_bios_asset_element v ");
+
 int
-select_assets_cb (tntdb::Connection &conn,
-                  std::function<void(const tntdb::Row&)> cb)
+select_assets_result (tntdb::Connection &conn,
+                      result_cb_f cb)
 {
+    DBMETRICS_PROBE_AS (probe, "select_assets_cb");
     try{
-        tntdb::Statement st = conn.prepareCached(
-            " SELECT "
-            "   v.name, "
-            "   v.id,  "
-            "   v.id_type,  "
-            "   v.id_subtype,  "
-            "   v.id_parent,  "
-            "   v.parent_name,  "
-            "   v.status,  "
-            "   v.priority,  "
-            "   v.asset_tag  "
-            " FROM v_bios_asset_element v "
-            );
+        tntdb::Statement st = DBStatementCache::prepare (conn, s_assets_query);
 
         tntdb::Result res = st.select ();
         log_debug("[v_bios_asset_element]: were selected %zu rows", res.size());
+        probe.rows (res.size ());
 
-        for (const auto& r: res) {
-            cb(r);
-        }
+        cb (res);
         return 0;
     }
     catch (const tntdb::NotFound &e) {
@@ -1262,6 +1855,34 @@ select_assets_cb (tntdb::Connection &conn,
         return -1;
     }
     catch (const std::exception &e) {
+        probe.error ();
+        log_error ("[v_bios_asset_element]: error '%s'", e.what());
+        return -1;
+    }
+}
+
+int
+select_assets_cb (tntdb::Connection &conn,
+                  std::function<void(const tntdb::Row&)> cb)
+{
+    return select_assets_result (conn, s_each_row (cb));
+}
+
+int
+select_assets_stream (tntdb::Connection &conn,
+                      row_stream_cb_f cb,
+                      unsigned fetch_size)
+{
+    DBMETRICS_PROBE (probe);
+    try {
+        tntdb::Statement st = conn.prepare (s_assets_query.sql ());
+        size_t rows = s_stream (st, cb, fetch_size);
+        log_debug("[v_bios_asset_element]: were streamed %zu rows", rows);
+        probe.rows (rows);
+        return 0;
+    }
+    catch (const std::exception &e) {
+        probe.error ();
         log_error ("[v_bios_asset_element]: error '%s'", e.what());
         return -1;
     }
@@ -1272,6 +1893,7 @@ db_reply_t
 select_monitor_device_type_id (tntdb::Connection &conn,
                                const char *device_type_name)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
 
     log_debug ("  device_type_name = %s", device_type_name);
@@ -1279,13 +1901,13 @@ select_monitor_device_type_id (tntdb::Connection &conn,
     db_reply_t ret = db_reply_new();
 
     try{
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " SELECT"
             "   v.id"
             " FROM"
             "   v_bios_device_type v"
-            " WHERE v.name = :name"
-        );
+            " WHERE v.name = :name");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         tntdb::Value val = st.set("name", device_type_name).
                               selectValue();
@@ -1305,6 +1927,7 @@ select_monitor_device_type_id (tntdb::Connection &conn,
         return ret;
     }
     catch (const std::exception &e) {
+        probe.error ();
         ret.status     = 0;
         ret.errtype    = DB_ERR;
         ret.errsubtype = DB_ERROR_INTERNAL;
@@ -1318,6 +1941,7 @@ db_reply <db_web_basic_element_t>
 select_asset_element_web_byId (tntdb::Connection &conn,
                                uint32_t element_id)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
     log_debug ("element_id = %" PRIi32, element_id);
 
@@ -1327,7 +1951,7 @@ select_asset_element_web_byId (tntdb::Connection &conn,
 
     try{
         // Can return more than one row.
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " SELECT"
             "   v.id, v.name, v.id_type, v.type_name,"
             "   v.subtype_id, v.subtype_name, v.id_parent,"
@@ -1335,8 +1959,8 @@ select_asset_element_web_byId (tntdb::Connection &conn,
             "   v.priority, v.asset_tag, v.parent_name "
             " FROM"
             "   v_web_element v"
-            " WHERE :id = v.id"
-        );
+            " WHERE :id = v.id");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         tntdb::Row row = st.set("id", element_id).
                             selectRow();
@@ -1368,6 +1992,7 @@ select_asset_element_web_byId (tntdb::Connection &conn,
         return ret;
     }
     catch (const std::exception &e) {
+        probe.error ();
         ret.status        = 0;
         ret.errtype       = DB_ERR;
         ret.errsubtype    = DB_ERROR_INTERNAL;
@@ -1382,12 +2007,13 @@ db_reply <db_web_basic_element_t>
 select_asset_element_web_byName (tntdb::Connection &conn,
                                  const char *element_name)
 {
+    DBMETRICS_PROBE (probe);
     // TODO write function new
     db_web_basic_element_t item {0, "", "", 0, 0, "", 0, 0, 0, "","",""};
     db_reply <db_web_basic_element_t> ret = db_reply_new(item);
 
     try {
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " SELECT"
             "   v.id, v.name, v.id_type, v.type_name,"
             "   v.subtype_id, v.subtype_name, v.id_parent,"
@@ -1395,8 +2021,8 @@ select_asset_element_web_byName (tntdb::Connection &conn,
             "   v.priority, v.asset_tag, v.parent_name "
             " FROM"
             "   v_web_element v"
-            " WHERE :name = v.name"
-        );
+            " WHERE :name = v.name");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         tntdb::Row row = st.set ("name", element_name).selectRow ();
 
@@ -1424,6 +2050,7 @@ select_asset_element_web_byName (tntdb::Connection &conn,
         return ret;
     }
     catch (const std::exception &e) {
+        probe.error ();
         ret.status        = 0;
         ret.errtype       = DB_ERR;
         ret.errsubtype    = DB_ERROR_INTERNAL;
@@ -1436,6 +2063,7 @@ db_reply <std::map <std::string, std::pair<std::string, bool> >>
 select_ext_attributes (tntdb::Connection &conn,
                        uint32_t element_id)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
     log_debug ("element_id = %" PRIi32, element_id);
 
@@ -1443,18 +2071,29 @@ select_ext_attributes (tntdb::Connection &conn,
     db_reply <std::map <std::string, std::pair<std::string, bool> > > ret =
                                                     db_reply_new(item);
     try {
+        DBExtStore::store_ptr store = DBExtStore::store (conn);
+        if (store) {
+            store->each (element_id, [&] (uint32_t keytag_id, const DBExtStore::value_t &v) {
+                ret.item.emplace (store->keytag (keytag_id), std::make_pair (v.str (), v.read_only));
+            });
+            ret.status = 1;
+            LOG_END;
+            return ret;
+        }
+
         // Can return more than one row
-        tntdb::Statement st_extattr = conn.prepareCached(
+        static const DBStatementCache::query_t st_extattr_query (
             " SELECT"
             "   v.keytag, v.value, v.read_only"
             " FROM"
             "   v_bios_asset_ext_attributes v"
-            " WHERE v.id_asset_element = :idelement"
-        );
+            " WHERE v.id_asset_element = :idelement");
+        tntdb::Statement st_extattr = DBStatementCache::prepare (conn, st_extattr_query);
 
         tntdb::Result result = st_extattr.set("idelement", element_id).
                                           select();
         log_debug("[v_bios_asset_ext_attributes]: were selected %" PRIu32 " rows", result.size());
+        probe.rows (result.size ());
 
         // Go through the selected extra attributes
         for ( auto &row: result )
@@ -1474,6 +2113,7 @@ select_ext_attributes (tntdb::Connection &conn,
         return ret;
     }
     catch (const std::exception &e) {
+        probe.error ();
         ret.status        = 0;
         ret.errtype       = DB_ERR;
         ret.errsubtype    = DB_ERROR_INTERNAL;
@@ -1501,6 +2141,7 @@ select_asset_device_links_to (tntdb::Connection &conn,
                               uint32_t element_id,
                               uint8_t link_type_id)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
     log_debug ("element_id = %" PRIi32, element_id);
 
@@ -1511,20 +2152,21 @@ select_asset_device_links_to (tntdb::Connection &conn,
         // Get information about the links the specified device
         // belongs to
         // Can return more than one row
-        tntdb::Statement st_pow = conn.prepareCached(
+        static const DBStatementCache::query_t st_pow_query (
             " SELECT"
             "   v.id_asset_element_src, v.src_out, v.dest_in, v.src_name"
             " FROM"
             "   v_web_asset_link v"
             " WHERE"
             "   v.id_asset_element_dest = :iddevice AND"
-            "   v.id_asset_link_type = :idlinktype"
-        );
+            "   v.id_asset_link_type = :idlinktype");
+        tntdb::Statement st_pow = DBStatementCache::prepare (conn, st_pow_query);
 
         tntdb::Result result = st_pow.set("iddevice", element_id).
                                       set("idlinktype", link_type_id).
                                       select();
         log_debug("[v_bios_asset_link]: were selected %" PRIu32 " rows", result.size());
+        probe.rows (result.size ());
 
         // Go through the selected links
         for ( auto &row: result )
@@ -1542,6 +2184,7 @@ select_asset_device_links_to (tntdb::Connection &conn,
         return ret;
     }
     catch (const std::exception &e) {
+        probe.error ();
         ret.status        = 0;
         ret.errtype       = DB_ERR;
         ret.errsubtype    = DB_ERROR_INTERNAL;
@@ -1556,6 +2199,7 @@ db_reply <std::map <uint32_t, std::string> >
 select_asset_element_groups (tntdb::Connection &conn,
                              uint32_t element_id)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
     log_debug ("element_id = %" PRIi32, element_id);
 
@@ -1565,7 +2209,7 @@ select_asset_element_groups (tntdb::Connection &conn,
     try {
         // Get information about the groups element belongs to
         // Can return more than one row
-        tntdb::Statement st_gr = conn.prepareCached(
+        static const DBStatementCache::query_t st_gr_query (
             " SELECT "
             "   v1.id_asset_group, v.name "
             " FROM "
@@ -1573,13 +2217,14 @@ select_asset_element_groups (tntdb::Connection &conn,
             "   v_bios_asset_element v "
             " WHERE "
             "   v1.id_asset_element = :idelement AND "
-            "   v.id = v1.id_asset_group "
-        );
+            "   v.id = v1.id_asset_group ");
+        tntdb::Statement st_gr = DBStatementCache::prepare (conn, st_gr_query);
 
         tntdb::Result result = st_gr.set("idelement", element_id).
                                      select();
 
         log_debug("[v_bios_asset_group_relation]: were selected %" PRIu32 " rows", result.size());
+        probe.rows (result.size ());
         // Go through the selected groups
         for ( auto &row: result )
         {
@@ -1596,6 +2241,7 @@ select_asset_element_groups (tntdb::Connection &conn,
         return ret;
     }
     catch (const std::exception &e) {
+        probe.error ();
         ret.status        = 0;
         ret.errtype       = DB_ERR;
         ret.errsubtype    = DB_ERROR_INTERNAL;
@@ -1606,11 +2252,333 @@ select_asset_element_groups (tntdb::Connection &conn,
     }
 }
 
+// parts of db_web_element_t, columns after seq are decoded by
+// s_decode_web_element_row from the third column on, parents of the element
+// are unpivoted from the ten columns of v_bios_asset_element_super_parent,
+// seq keeps them ordered from the nearest one
+struct s_web_element_part_t {
+    const char *owner;    // column with id of element the row belongs to
+    const char *columns;  // seq and decoded columns
+    size_t      count;    // number of decoded columns
+    const char *from;
+    const char *where;    // additional condition, may be empty
+};
+
+#define S_ELT_PARENT(column) \
+    " ELT (n.n, p." column "1, p." column "2, p." column "3, p." column "4, p." column "5," \
+    "      p." column "6, p." column "7, p." column "8, p." column "9, p." column "10)"
+
+static const s_web_element_part_t s_web_element_parts [WEB_ELEMENT_PARTS] = {
+    {"v.id",
+     " 0, v.id, v.name, v.id_type, v.type_name,"
+     " v.subtype_id, v.subtype_name, v.id_parent,"
+     " v.id_parent_type, v.status,"
+     " v.priority, v.asset_tag, v.parent_name",
+     12,
+     " v_web_element v",
+     ""},
+    {"g.id_asset_element",
+     " 0, g.id_asset_group, e.name",
+     2,
+     " v_bios_asset_group_relation g"
+     " JOIN v_bios_asset_element e ON e.id = g.id_asset_group",
+     ""},
+    {"l.id_asset_element_dest",
+     " 0, l.id_asset_element_src, l.src_out, l.dest_in, l.src_name",
+     4,
+     " v_web_asset_link l",
+     " l.id_asset_link_type = :idlinktype"},
+    {"a.id_asset_element",
+     " 0, a.keytag, a.value, a.read_only",
+     3,
+     " v_bios_asset_ext_attributes a",
+     ""},
+    {"p.id_asset_element",
+     " n.n," S_ELT_PARENT ("id_parent") "," S_ELT_PARENT ("name_parent") ","
+     S_ELT_PARENT ("id_type_parent") "," S_ELT_PARENT ("id_subtype_parent"),
+     4,
+     " v_bios_asset_element_super_parent p"
+     " JOIN (SELECT 1 AS n UNION ALL SELECT 2 UNION ALL SELECT 3 UNION ALL SELECT 4"
+     "       UNION ALL SELECT 5 UNION ALL SELECT 6 UNION ALL SELECT 7 UNION ALL SELECT 8"
+     "       UNION ALL SELECT 9 UNION ALL SELECT 10) n",
+     S_ELT_PARENT ("id_parent") " IS NOT NULL"}
+};
+
+#undef S_ELT_PARENT
+
+// s_web_element_part_sql: SELECT of part for elements matching cond, head is
+// the first column, pad adds NULL columns up to the widest part
+static std::string
+s_web_element_part_sql (unsigned part,
+                        const std::string &head,
+                        const std::string &cond,
+                        bool pad)
+{
+    const s_web_element_part_t &p = s_web_element_parts [part];
+    std::string sql = " SELECT " + head + "," + p.columns;
+    for (size_t i = p.count; pad && i != s_web_element_parts [0].count; i++)
+        sql += ", NULL";
+    sql += std::string (" FROM") + p.from + " WHERE " + cond;
+    if (*p.where)
+        sql += std::string (" AND") + p.where;
+    return sql;
+}
+
+// s_web_element_full_sql: all parts of one element, first column is the part
+static std::string
+s_web_element_full_sql ()
+{
+    std::string sql;
+    for (unsigned part = 0; part != WEB_ELEMENT_PARTS; part++) {
+        if (part != 0)
+            sql += " UNION ALL";
+        sql += s_web_element_part_sql (part,
+                                       std::to_string (part),
+                                       std::string (s_web_element_parts [part].owner) + " = :id",
+                                       true);
+    }
+    return sql + " ORDER BY 1, 2";
+}
+
+// s_decode_web_element_row: decode row of part into item, first row of the
+// element wins if v_web_element returns more of them
+static void
+s_decode_web_element_row (const tntdb::Row &row,
+                          unsigned part,
+                          db_web_element_t &item,
+                          bool &found)
+{
+    switch (part) {
+        case 0:
+            if (found)
+                return;
+            found = true;
+            row[2].get (item.basic.id);
+            row[3].get (item.basic.name);
+            row[4].get (item.basic.type_id);
+            row[5].get (item.basic.type_name);
+            row[6].get (item.basic.subtype_id);
+            row[7].get (item.basic.subtype_name);
+            row[8].get (item.basic.parent_id);
+            row[9].get (item.basic.parent_type_id);
+            row[10].get (item.basic.status);
+            row[11].get (item.basic.priority);
+            row[12].get (item.basic.asset_tag);
+            row[13].get (item.basic.parent_name);
+            break;
+        case 1: {
+            uint32_t group_id = 0;
+            std::string group_name;
+            row[2].get (group_id);
+            row[3].get (group_name);
+            item.groups.emplace (group_id, group_name);
+            break;
+        }
+        case 2: {
+            db_tmp_link_t m {0, item.basic.id, "", "", ""};
+            row[2].get (m.src_id);
+            row[3].get (m.src_socket);
+            row[4].get (m.dest_socket);
+            row[5].get (m.src_name);
+            item.powers.push_back (m);
+            break;
+        }
+        case 3: {
+            std::string keytag;
+            std::string value;
+            int read_only = 0;
+            row[2].get (keytag);
+            row[3].get (value);
+            row[4].get (read_only);
+            item.ext.emplace (keytag, std::make_pair (value, read_only != 0));
+            break;
+        }
+        case 4: {
+            uint32_t parent_id = 0;
+            std::string parent_name;
+            uint16_t type_id = 0;
+            uint16_t subtype_id = 0;
+            row[2].get (parent_id);
+            row[3].get (parent_name);
+            row[4].get (type_id);
+            row[5].get (subtype_id);
+            item.parents.emplace_back (parent_id,
+                                       parent_name,
+                                       persist::typeid_to_type (type_id),
+                                       persist::subtypeid_to_subtype (subtype_id));
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+db_reply <db_web_element_t>
+select_web_element_full (tntdb::Connection &conn,
+                         uint32_t element_id,
+                         web_element_timing_t *timing)
+{
+    typedef std::chrono::steady_clock steady_t;
+
+    DBMETRICS_PROBE (probe);
+    LOG_START;
+    log_debug ("element_id = %" PRIi32, element_id);
+
+    db_web_element_t item {};
+    item.basic = db_web_basic_element_t {0, "", "", 0, 0, "", 0, 0, 0, "", "", ""};
+    db_reply <db_web_element_t> ret = db_reply_new (item);
+    web_element_timing_t spent {0, {0, 0, 0, 0, 0}};
+
+    try {
+        auto start = steady_t::now ();
+        static const std::string st_sql = s_web_element_full_sql ();
+        static const DBStatementCache::query_t st_query (st_sql.c_str ());
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
+
+        tntdb::Result result = st.set ("id", element_id).
+                                  set ("idlinktype", INPUT_POWER_CHAIN).
+                                  select ();
+        auto now = steady_t::now ();
+        spent.query_us = std::chrono::duration_cast <std::chrono::microseconds> (now - start).count ();
+        log_debug ("[v_web_element]: were selected %" PRIu32 " rows", result.size ());
+        probe.rows (result.size ());
+
+        bool found = false;
+        for (auto &row : result) {
+            unsigned part = 0;
+            row[0].get (part);
+            s_decode_web_element_row (row, part, ret.item, found);
+            auto decoded = steady_t::now ();
+            if (part < WEB_ELEMENT_PARTS)
+                spent.decode_us [part] += std::chrono::duration_cast <std::chrono::microseconds> (decoded - now).count ();
+            now = decoded;
+        }
+        if (timing)
+            *timing = spent;
+
+        if (!found) {
+            ret.item = item;
+            ret.status        = 0;
+            ret.errtype       = DB_ERR;
+            ret.errsubtype    = DB_ERROR_NOTFOUND;
+            ret.msg           = TRANSLATE_ME ("element with specified id was not found");
+            log_info ("end: %s", ret.msg.c_str());
+            return ret;
+        }
+        ret.status = 1;
+        LOG_END;
+        return ret;
+    }
+    catch (const std::exception &e) {
+        probe.error ();
+        ret.item = item;
+        ret.status        = 0;
+        ret.errtype       = DB_ERR;
+        ret.errsubtype    = DB_ERROR_INTERNAL;
+        ret.msg           = JSONIFY (e.what());
+        LOG_END_ABNORMAL(e);
+        return ret;
+    }
+}
+
+db_reply <std::vector <db_web_element_t>>
+select_web_elements_full (tntdb::Connection &conn,
+                          const std::vector <uint32_t> &ids,
+                          web_element_timing_t *timing)
+{
+    typedef std::chrono::steady_clock steady_t;
+
+    DBMETRICS_PROBE (probe);
+    LOG_START;
+    log_debug ("%zu elements", ids.size ());
+
+    std::vector <db_web_element_t> item {};
+    db_reply <std::vector <db_web_element_t>> ret = db_reply_new (item);
+    web_element_timing_t spent {0, {0, 0, 0, 0, 0}};
+
+    // elements in order of first occurrence in ids, rows are joined to them
+    // through index
+    std::vector <uint32_t> unique;
+    std::unordered_map <uint32_t, size_t> index;
+    for (auto id : ids) {
+        if (index.emplace (id, unique.size ()).second)
+            unique.push_back (id);
+    }
+    std::vector <db_web_element_t> elements (unique.size ());
+    for (auto &e : elements)
+        e.basic = db_web_basic_element_t {0, "", "", 0, 0, "", 0, 0, 0, "", "", ""};
+    std::vector <char> found (unique.size (), 0);
+
+    try {
+        size_t rows = 0;
+        for (size_t first = 0; first < unique.size (); first += DBSql::MAX_IN_LIST) {
+            size_t bucket = DBSql::in_list_bucket (unique.size () - first);
+            for (unsigned part = 0; part != WEB_ELEMENT_PARTS; part++) {
+                const char *owner = s_web_element_parts [part].owner;
+                auto start = steady_t::now ();
+                tntdb::Statement st = DBStatementCache::prepare (conn,
+                    s_web_element_part_sql (part,
+                                            owner,
+                                            std::string (owner) + " IN (" + DBSql::in_list ("id", bucket) + ")",
+                                            false) +
+                    " ORDER BY 1, 2");
+                DBSql::bind_in_list (st, "id", unique, first, bucket);
+                // power links
+                if (part == 2)
+                    st.set ("idlinktype", INPUT_POWER_CHAIN);
+                tntdb::Result result = st.select ();
+                auto now = steady_t::now ();
+                spent.query_us += std::chrono::duration_cast <std::chrono::microseconds> (now - start).count ();
+                rows += result.size ();
+
+                for (auto &row : result) {
+                    uint32_t owner_id = 0;
+                    row[0].get (owner_id);
+                    auto it = index.find (owner_id);
+                    if (it == index.end ())
+                        continue;
+                    bool f = found [it->second];
+                    s_decode_web_element_row (row, part, elements [it->second], f);
+                    found [it->second] = f;
+                }
+                spent.decode_us [part] += std::chrono::duration_cast <std::chrono::microseconds> (steady_t::now () - now).count ();
+            }
+        }
+        log_debug ("[v_web_element]: were selected %zu rows", rows);
+        probe.rows (rows);
+
+        ret.item.reserve (ids.size ());
+        for (auto id : ids) {
+            size_t i = index [id];
+            if (found [i])
+                ret.item.push_back (elements [i]);
+            else
+                log_debug ("element %" PRIu32 " was not found", id);
+        }
+        if (timing)
+            *timing = spent;
+        ret.status = 1;
+        LOG_END;
+        return ret;
+    }
+    catch (const std::exception &e) {
+        probe.error ();
+        ret.status        = 0;
+        ret.errtype       = DB_ERR;
+        ret.errsubtype    = DB_ERROR_INTERNAL;
+        ret.msg           = JSONIFY (e.what());
+        ret.item.clear ();
+        LOG_END_ABNORMAL(e);
+        return ret;
+    }
+}
+
 db_reply <std::map <uint32_t, std::string> >
 select_short_elements (tntdb::Connection &conn,
                        uint16_t type_id,
                        uint16_t subtype_id)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
     log_debug ("  type_id = %" PRIi16, type_id);
     log_debug ("  subtype_id = %" PRIi16, subtype_id);
@@ -1639,7 +2607,7 @@ select_short_elements (tntdb::Connection &conn,
     }
     try{
         // Can return more than one row.
-        tntdb::Statement st = conn.prepareCached(query);
+        tntdb::Statement st = DBStatementCache::prepare (conn, query);
 
         tntdb::Result result;
         if ( subtype_id == 0 )
@@ -1665,6 +2633,7 @@ select_short_elements (tntdb::Connection &conn,
         return ret;
     }
     catch (const std::exception &e) {
+        probe.error ();
         ret.status        = 0;
         ret.errtype       = DB_ERR;
         ret.errsubtype    = DB_ERROR_INTERNAL;
@@ -1680,26 +2649,28 @@ select_asset_elements_by_type (tntdb::Connection &conn,
                                uint16_t type_id,
                                std::string status)
 {
+    DBMETRICS_PROBE (probe);
 
     std::vector<db_a_elmnt_t> item{};
     db_reply <std::vector<db_a_elmnt_t>> ret = db_reply_new(item);
 
     try{
         // Can return more than one row.
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " SELECT"
             "   v.name , v.id_parent, v.status, v.priority, v.id, v.id_subtype"
             " FROM"
             "   v_bios_asset_element v"
             " WHERE v.id_type = :typeid AND"
-            "   v.status = :vstatus "
-        );
+            "   v.status = :vstatus ");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         tntdb::Result result = st.set("typeid", type_id).
                                   set("vstatus", status).
                                   select();
         log_trace("[v_bios_asset_element]: were selected %" PRIu32 " rows",
                                                             result.size());
+        probe.rows (result.size ());
 
         // Go through the selected elements
         for ( auto &row: result )
@@ -1721,6 +2692,7 @@ select_asset_elements_by_type (tntdb::Connection &conn,
         return ret;
     }
     catch (const std::exception &e) {
+        probe.error ();
         ret.status        = 0;
         ret.errtype       = DB_ERR;
         ret.errsubtype    = DB_ERROR_INTERNAL;
@@ -1736,6 +2708,7 @@ select_links_by_container (tntdb::Connection &conn,
                            uint32_t element_id,
                            std::string status)
 {
+    DBMETRICS_PROBE (probe);
     log_trace ("  links are selected for element_id = %" PRIi32, element_id);
     uint8_t linktype = INPUT_POWER_CHAIN;
 
@@ -1743,66 +2716,71 @@ select_links_by_container (tntdb::Connection &conn,
     std::set <std::pair<uint32_t ,uint32_t>> item{};
     db_reply <std::set<std::pair<uint32_t ,uint32_t>>> ret = db_reply_new(item);
 
+    std::vector <uint32_t> ids;
+    bool indexed = s_container_ids (conn, element_id, false, ids);
+    if (indexed && ids.empty ()) {
+        ret.status = 1;
+        return ret;
+    }
+    bool closure = !indexed && DBAssetClosure::available (conn);
+
     try{
-        // v_bios_asset_link are only devices,
-        // so there is no need to add more constrains
-        tntdb::Statement st = conn.prepareCached(
-            " SELECT"
-            "   v.id_asset_element_src,"
-            "   v.id_asset_element_dest"
-            " FROM"
-            "   v_bios_asset_link AS v,"
-            "   v_bios_asset_element_super_parent AS v1,"
-            "   v_bios_asset_element_super_parent AS v2"
-            " WHERE"
-            "   v.id_asset_link_type = :linktypeid AND"
-            "   v.id_asset_element_dest = v2.id_asset_element AND"
-            "   v.id_asset_element_src = v1.id_asset_element AND"
-            "   ("
-            "       ( :containerid IN (v2.id_parent1, v2.id_parent2 ,v2.id_parent3,"
-            "                          v2.id_parent4, v2.id_parent5, v2.id_parent6,"
-            "                          v2.id_parent7, v2.id_parent8, v2.id_parent9,"
-            "                          v2.id_parent10) AND v1.status = :vstatus AND v2.status = :vstatus) OR"
-            "       ( :containerid IN (v1.id_parent1, v1.id_parent2 ,v1.id_parent3,"
-            "                          v1.id_parent4, v1.id_parent5, v1.id_parent6,"
-            "                          v1.id_parent7, v1.id_parent8, v1.id_parent9,"
-            "                          v1.id_parent10) AND v1.status = :vstatus AND v2.status = :vstatus)"
-            "   )"
-        );
-
-        // can return more than one row
-        tntdb::Result result = st.set("containerid", element_id).
-                                  set("linktypeid", linktype).
-                                  set("vstatus", status).
-                                  select();
-        log_trace("[t_bios_asset_link]: were selected %" PRIu32 " rows",
-                                                         result.size());
+        size_t first = 0;
+        do {
+            size_t bucket = indexed ? DBSql::in_list_bucket (ids.size () - first) : 0;
+            // v_bios_asset_link are only devices,
+            // so there is no need to add more constrains
+            tntdb::Statement st = DBStatementCache::prepare (conn,
+                " SELECT"
+                "   v.id_asset_element_src,"
+                "   v.id_asset_element_dest"
+                " FROM"
+                "   v_bios_asset_link AS v,"
+                "   v_bios_asset_element_super_parent AS v1,"
+                "   v_bios_asset_element_super_parent AS v2"
+                " WHERE"
+                "   v.id_asset_link_type = :linktypeid AND"
+                "   v.id_asset_element_dest = v2.id_asset_element AND"
+                "   v.id_asset_element_src = v1.id_asset_element AND"
+                "   v1.status = :vstatus AND v2.status = :vstatus AND"
+                "   (" + s_in_container ("v2", bucket, closure) + " OR " + s_in_container ("v1", bucket, closure) + ")");
+            s_bind_container (st, element_id, ids, first, bucket);
+
+            // can return more than one row
+            tntdb::Result result = st.set("linktypeid", linktype).
+                                      set("vstatus", status).
+                                      select();
+            log_trace("[t_bios_asset_link]: were selected %" PRIu32 " rows",
+                                                             result.size());
+            probe.rows (result.size ());
+            for ( auto &row: result )
+            {
+                // id_asset_element_src, required
+                uint32_t id_asset_element_src = 0;
+                row[0].get(id_asset_element_src);
+                assert ( id_asset_element_src );
+
+                // id_asset_element_dest, required
+                uint32_t id_asset_element_dest = 0;
+                row[1].get(id_asset_element_dest);
+                assert ( id_asset_element_dest );
+
+                ret.item.insert(std::pair<uint32_t, uint32_t>(id_asset_element_src, id_asset_element_dest));
+            } // end for
+            first += DBSql::MAX_IN_LIST;
+        } while (indexed && first < ids.size ());
+
         // debug helper
         std::vector <std::string> inactive = list_devices_with_status (conn,"nonactive");
         log_trace ("Inactive devices omitted:");
         for (auto dev : inactive) {
             log_trace ("\t- %s", dev.c_str ());
         }
-
-        // Go through the selected links
-        for ( auto &row: result )
-        {
-            // id_asset_element_src, required
-            uint32_t id_asset_element_src = 0;
-            row[0].get(id_asset_element_src);
-            assert ( id_asset_element_src );
-
-            // id_asset_element_dest, required
-            uint32_t id_asset_element_dest = 0;
-            row[1].get(id_asset_element_dest);
-            assert ( id_asset_element_dest );
-
-            ret.item.insert(std::pair<uint32_t, uint32_t>(id_asset_element_src, id_asset_element_dest));
-        } // end for
         ret.status = 1;
         return ret;
     }
     catch (const std::exception &e) {
+        probe.error ();
         ret.status     = 0;
         ret.errtype    = DB_ERR;
         ret.errsubtype = DB_ERROR_INTERNAL;
@@ -1816,19 +2794,21 @@ select_links_by_container (tntdb::Connection &conn,
 std::vector <std::string>
 list_devices_with_status (tntdb::Connection &conn, std::string status)
 {
+    DBMETRICS_PROBE (probe);
     std::vector <std::string> asset_list;
     try {
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " SELECT"
             "   v.name, v.id_subtype"
             " FROM"
             "   v_bios_asset_element v"
-            " WHERE v.status = :vstatus "
-        );
+            " WHERE v.status = :vstatus ");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         tntdb::Result result = st.set("vstatus", status).select();
         log_trace("[v_bios_asset_element]: were selected %" PRIu32 " rows",
                                                             result.size());
+        probe.rows (result.size ());
         for (auto &row : result) {
             std::string device;
             row [0].get (device);
@@ -1837,6 +2817,7 @@ list_devices_with_status (tntdb::Connection &conn, std::string status)
 
     }
     catch (const std::exception &e) {
+        probe.error ();
         throw std::runtime_error("Reading from DB failed.");
     }
     return asset_list;
@@ -1845,9 +2826,10 @@ list_devices_with_status (tntdb::Connection &conn, std::string status)
 std::vector <std::string>
 list_power_devices_with_status (tntdb::Connection &conn, const std::string & status)
 {
+    DBMETRICS_PROBE (probe);
     std::vector <std::string> asset_list;
     try {
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " SELECT"
             "   v.name, v.id_subtype"
             " FROM"
@@ -1855,12 +2837,13 @@ list_power_devices_with_status (tntdb::Connection &conn, const std::string & sta
             " WHERE v.id_subtype IN "
                 "(SELECT id_asset_device_type FROM t_bios_asset_device_type "
                 "WHERE name IN ('epdu', 'sts', 'ups', 'pdu', 'genset')) "
-            " AND v.status = :vstatus "
-        );
+            " AND v.status = :vstatus ");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         tntdb::Result result = st.set("vstatus", status).select();
         log_trace("[t_bios_asset_element]: were selected %" PRIu32 " rows",
                                                             result.size());
+        probe.rows (result.size ());
         for (auto &row : result) {
             std::string device;
             row [0].get (device);
@@ -1869,6 +2852,7 @@ list_power_devices_with_status (tntdb::Connection &conn, const std::string & sta
 
     }
     catch (const std::exception &e) {
+        probe.error ();
         throw std::runtime_error("Reading from DB failed.");
     }
     return asset_list;
@@ -1877,7 +2861,8 @@ list_power_devices_with_status (tntdb::Connection &conn, const std::string & sta
 std::vector <std::string>
 list_power_devices_with_status (const std::string & status)
 {
-    tntdb::Connection conn = tntdb::connectCached(DBConn::url);
+    DBConn::connection_t pooled;
+    tntdb::Connection &conn = pooled.get ();
 
     std::vector <std::string> asset_list;
     asset_list = list_power_devices_with_status(conn, status);
@@ -1887,15 +2872,16 @@ list_power_devices_with_status (const std::string & status)
 int
 get_active_power_devices (tntdb::Connection &conn)
 {
+    DBMETRICS_PROBE (probe);
     int count = 0;
     try {
-        tntdb::Statement st = conn.prepareCached (
+        static const DBStatementCache::query_t st_query (
             "SELECT COUNT(*) AS CNT FROM t_bios_asset_element "
             "WHERE id_subtype IN "
                 "(SELECT id_asset_device_type FROM t_bios_asset_device_type "
                 "WHERE name IN ('epdu', 'sts', 'ups', 'pdu', 'genset')) "
-            "AND status = 'active';"
-        );
+            "AND status = 'active';");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         tntdb::Row row = st.selectRow ();
 
@@ -1904,6 +2890,7 @@ get_active_power_devices (tntdb::Connection &conn)
     }
     catch (const std::exception &e)
     {
+        probe.error ();
         log_error ("exception caught %s when getting count of active power devices", e.what ());
         return 0;
     }
@@ -1914,7 +2901,8 @@ get_active_power_devices (tntdb::Connection &conn)
 std::string
 get_status_from_db_helper (const std::string &element_name)
 {
-    tntdb::Connection conn = tntdb::connectCached(DBConn::url);
+    DBConn::connection_t pooled;
+    tntdb::Connection &conn = pooled.get ();
     std::string status = get_status_from_db (conn, element_name);
     return status;
 }
@@ -1924,13 +2912,14 @@ std::string
 get_status_from_db (tntdb::Connection conn,
                     const std::string &element_name)
 {
+    DBMETRICS_PROBE (probe);
     try {
         log_debug("get_status_from_db: getting status for asset %s", element_name.c_str());
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " SELECT v.status "
             " FROM v_bios_asset_element v "
-            " WHERE v.name=:vname ;"
-            );
+            " WHERE v.name=:vname ;");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         tntdb::Row row = st.set ("vname", element_name).selectRow ();
         log_debug("get_status_from_db: [v_bios_asset_element]: were selected %zu rows", row.size());
@@ -1947,6 +2936,7 @@ get_status_from_db (tntdb::Connection conn,
         return "unknown";
     }
     catch (const std::exception &e) {
+        probe.error ();
         log_error ("get_status_from_db: [v_bios_asset_element]: error '%s'", e.what());
         return "unknown";
     }
@@ -1955,12 +2945,13 @@ get_status_from_db (tntdb::Connection conn,
 db_reply <std::map <int, std::string> >
 select_daisy_chain (tntdb::Connection &conn, const std::string &asset_id)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
     log_debug ("  asset_id = %s", asset_id.c_str());
     std::map <int, std::string> item{};
     db_reply <std::map <int, std::string> > ret = db_reply_new(item);
 
-    std::string query = R"EOF(
+    static const DBStatementCache::query_t query (R"EOF(
 select ae_name_out.name, aea_daisychain.value as daisy_chain
     from t_bios_asset_ext_attributes aea_daisychain join t_bios_asset_element ae_name_out on aea_daisychain.id_asset_element = ae_name_out.id_asset_element
     where aea_daisychain.keytag = 'daisy_chain' and aea_daisychain.id_asset_element in
@@ -1977,10 +2968,10 @@ select ae_name_out.name, aea_daisychain.value as daisy_chain
                 ) and aea_ip.keytag like 'ip.%'
         )
     )
-)EOF";
+)EOF");
     try{
         // Can return more than one row.
-        tntdb::Statement st = conn.prepareCached(query);
+        tntdb::Statement st = DBStatementCache::prepare (conn, query);
         tntdb::Result result = st.set("asset_id", asset_id).select();
 
         // Go through the selected elements
@@ -1996,6 +2987,7 @@ select ae_name_out.name, aea_daisychain.value as daisy_chain
         return ret;
     }
     catch (const std::exception &e) {
+        probe.error ();
         ret.status        = 0;
         ret.errtype       = DB_ERR;
         ret.errsubtype    = DB_ERROR_INTERNAL;
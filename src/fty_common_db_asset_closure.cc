@@ -0,0 +1,263 @@
+/*  =========================================================================
+    fty_common_db_asset_closure - Closure table of asset containment
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    fty_common_db_asset_closure - Closure table of asset containment
+@discuss
+    Rows of deleted elements are also removed by ON DELETE CASCADE, so
+    elements deleted with foreign key checks on never leave stale rows.
+    Write functions check the table after their statement, a process which
+    did not see it yet checks again after RECHECK_S seconds. create waits
+    until all processes check again and for writers which wrote before
+    they did, fills the table and only then creates the marker readers
+    look for, so readers never see a closure which misses some write.
+@end
+*/
+
+#include "fty_common_db_classes.h"
+
+#include <atomic>
+
+namespace DBAssetClosure {
+
+// deepest containment rebuild follows, protects against cycles in id_parent
+static const uint32_t MAX_DEPTH = 1024;
+
+// closure table, maintained by write functions once it exists
+static DBSql::optional_table_t s_closure ("t_bios_asset_element_closure");
+// marker created when the closure table is complete, readers use it then
+static DBSql::optional_table_t s_ready ("t_bios_asset_element_closure_ready");
+
+bool
+available (tntdb::Connection &conn)
+{
+    try {
+        return s_ready.exists (conn);
+    }
+    catch (const std::exception &e) {
+        log_error ("can't check closure table: %s", e.what ());
+        return false;
+    }
+}
+
+int
+create (tntdb::Connection &conn)
+{
+    LOG_START;
+
+    try {
+        conn.execute (
+            " CREATE TABLE IF NOT EXISTS t_bios_asset_element_closure ("
+            "   id_ancestor     INT UNSIGNED NOT NULL,"
+            "   id_descendant   INT UNSIGNED NOT NULL,"
+            "   depth           INT UNSIGNED NOT NULL,"
+            "   PRIMARY KEY (id_ancestor, id_descendant),"
+            "   INDEX FK_ASSET_CLOSURE_DESCENDANT_idx (id_descendant, depth),"
+            "   CONSTRAINT FK_ASSET_CLOSURE_ANCESTOR"
+            "     FOREIGN KEY (id_ancestor)"
+            "     REFERENCES t_bios_asset_element (id_asset_element)"
+            "     ON DELETE CASCADE,"
+            "   CONSTRAINT FK_ASSET_CLOSURE_DESCENDANT"
+            "     FOREIGN KEY (id_descendant)"
+            "     REFERENCES t_bios_asset_element (id_asset_element)"
+            "     ON DELETE CASCADE"
+            " ) ENGINE=InnoDB"
+        );
+        s_closure.created ();
+        // writers which did not see the table yet end before it is filled
+        DBSql::wait_for_writers (conn);
+    }
+    catch (const std::exception &e) {
+        LOG_END_ABNORMAL(e);
+        return -1;
+    }
+
+    if (rebuild (conn) != 0) {
+        log_error ("end: closure table was not filled");
+        return -1;
+    }
+
+    try {
+        conn.execute (
+            " CREATE TABLE IF NOT EXISTS t_bios_asset_element_closure_ready ("
+            "   id_ready        TINYINT UNSIGNED NOT NULL,"
+            "   PRIMARY KEY (id_ready)"
+            " ) ENGINE=InnoDB"
+        );
+    }
+    catch (const std::exception &e) {
+        LOG_END_ABNORMAL(e);
+        return -1;
+    }
+    s_ready.created ();
+    LOG_END;
+    return 0;
+}
+
+int
+rebuild (tntdb::Connection &conn)
+{
+    LOG_START;
+
+    try {
+        tntdb::Transaction trans (conn);
+
+        conn.execute ("DELETE FROM t_bios_asset_element_closure");
+        // every element is its own descendant in depth 0
+        uint32_t rows = conn.execute (
+            " INSERT IGNORE INTO t_bios_asset_element_closure"
+            "   (id_ancestor, id_descendant, depth)"
+            " SELECT id_asset_element, id_asset_element, 0"
+            " FROM t_bios_asset_element"
+        );
+        log_debug ("[t_bios_asset_element_closure]: %" PRIu32 " elements", rows);
+
+        // children of descendants in depth N are descendants in depth N + 1
+        // IGNORE: write functions may add the same rows meanwhile
+        static const DBStatementCache::query_t st_query (
+            " INSERT IGNORE INTO t_bios_asset_element_closure"
+            "   (id_ancestor, id_descendant, depth)"
+            " SELECT c.id_ancestor, e.id_asset_element, c.depth + 1"
+            " FROM"
+            "   t_bios_asset_element_closure AS c"
+            "   JOIN t_bios_asset_element AS e ON e.id_parent = c.id_descendant"
+            " WHERE"
+            "   c.depth = :depth");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
+        uint32_t depth = 0;
+        for (; depth != MAX_DEPTH; depth++) {
+            rows = st.set ("depth", depth).execute ();
+            if (rows == 0)
+                break;
+            log_debug ("[t_bios_asset_element_closure]: %" PRIu32 " rows in depth %" PRIu32, rows, depth + 1);
+        }
+        if (depth == MAX_DEPTH) {
+            log_error ("end: containment is deeper than %" PRIu32 ", id_parent has a cycle", MAX_DEPTH);
+            return -1;
+        }
+        trans.commit ();
+    }
+    catch (const std::exception &e) {
+        LOG_END_ABNORMAL(e);
+        return -1;
+    }
+    LOG_END;
+    return 0;
+}
+
+// s_attach: add rows from all ancestors of parent_id (including itself)
+// to all descendants of id (including itself)
+static void
+s_attach (tntdb::Connection &conn, uint32_t id, uint32_t parent_id)
+{
+    static const DBStatementCache::query_t st_query (
+        " INSERT INTO t_bios_asset_element_closure"
+        "   (id_ancestor, id_descendant, depth)"
+        " SELECT a.id_ancestor, d.id_descendant, a.depth + d.depth + 1"
+        " FROM"
+        "   t_bios_asset_element_closure AS a,"
+        "   t_bios_asset_element_closure AS d"
+        " WHERE"
+        "   a.id_descendant = :parent AND"
+        "   d.id_ancestor = :id");
+    tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
+    uint32_t rows = st.set ("parent", parent_id).
+                       set ("id", id).
+                       execute ();
+    log_debug ("[t_bios_asset_element_closure]: was inserted %" PRIu32 " rows", rows);
+}
+
+void
+element_inserted (tntdb::Connection &conn, uint32_t id, uint32_t parent_id)
+{
+    if (!s_closure.exists (conn))
+        return;
+
+    static const DBStatementCache::query_t st_query (
+        " INSERT INTO t_bios_asset_element_closure"
+        "   (id_ancestor, id_descendant, depth)"
+        " VALUES"
+        "   (:id, :id, 0)");
+    tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
+    st.set ("id", id).execute ();
+    if (parent_id != 0)
+        s_attach (conn, id, parent_id);
+}
+
+void
+element_moved (tntdb::Connection &conn, uint32_t id, uint32_t parent_id)
+{
+    if (!s_closure.exists (conn))
+        return;
+
+    uint32_t old_parent_id = 0;
+    try {
+        static const DBStatementCache::query_t st_query (
+            " SELECT id_ancestor"
+            " FROM"
+            "   t_bios_asset_element_closure"
+            " WHERE"
+            "   id_descendant = :id AND"
+            "   depth = 1");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
+        st.set ("id", id).selectValue ().get (old_parent_id);
+    }
+    catch (const tntdb::NotFound &e) {
+        // element has no parent
+    }
+    if (old_parent_id == parent_id)
+        return;
+
+    // drop rows from former ancestors to the subtree, rows inside the
+    // subtree are kept
+    static const DBStatementCache::query_t st_query (
+        " DELETE c FROM"
+        "   t_bios_asset_element_closure AS c"
+        "   JOIN t_bios_asset_element_closure AS d"
+        "     ON d.id_descendant = c.id_descendant AND d.id_ancestor = :id"
+        "   JOIN t_bios_asset_element_closure AS a"
+        "     ON a.id_ancestor = c.id_ancestor AND a.id_descendant = :id AND a.depth > 0");
+    tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
+    uint32_t rows = st.set ("id", id).execute ();
+    log_debug ("[t_bios_asset_element_closure]: was deleted %" PRIu32 " rows", rows);
+
+    if (parent_id != 0)
+        s_attach (conn, id, parent_id);
+}
+
+void
+element_deleted (tntdb::Connection &conn, uint32_t id)
+{
+    if (!s_closure.exists (conn))
+        return;
+
+    static const DBStatementCache::query_t st_query (
+        " DELETE FROM"
+        "   t_bios_asset_element_closure"
+        " WHERE"
+        "   id_descendant = :id OR id_ancestor = :id");
+    tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
+    uint32_t rows = st.set ("id", id).execute ();
+    log_debug ("[t_bios_asset_element_closure]: was deleted %" PRIu32 " rows", rows);
+}
+
+} // namespace
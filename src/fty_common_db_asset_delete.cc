@@ -39,6 +39,7 @@ delete_asset_link (tntdb::Connection &conn,
                    uint32_t asset_element_id_src,
                    uint32_t asset_element_id_dest)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
     log_debug ("  asset_element_id_src = %" PRIu32, asset_element_id_src);
     log_debug ("  asset_element_id_dest = %" PRIu32, asset_element_id_dest);
@@ -67,25 +68,29 @@ delete_asset_link (tntdb::Connection &conn,
     log_debug ("input parameters are correct");
 
     try{
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " DELETE"
             " FROM"
             "   t_bios_asset_link"
             " WHERE"
             "   id_asset_device_src = :src AND"
-            "   id_asset_device_dest = :dest"
-        );
+            "   id_asset_device_dest = :dest");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         ret.affected_rows = st.set("src", asset_element_id_src).
                                set("dest", asset_element_id_dest).
                                execute();
         log_debug ("[t_bios_asset_link]: was deleted %"
                                     PRIu64 " rows", ret.affected_rows);
+        probe.rows (ret.affected_rows);
+        if (ret.affected_rows != 0)
+            DBAssetGeneration::changed (conn, DBChangeNotify::LINK, DBChangeNotify::DELETED, asset_element_id_dest);
         ret.status = 1;
         LOG_END;
         return ret;
     }
     catch (const std::exception &e) {
+        probe.error ();
         ret.status     = 0;
         ret.errtype    = DB_ERR;
         ret.errsubtype = DB_ERROR_INTERNAL;
@@ -99,28 +104,33 @@ db_reply_t
 delete_asset_links_to (tntdb::Connection &conn,
                        uint32_t asset_device_id)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
     log_debug ("  asset_device_id = %" PRIu32, asset_device_id);
 
     db_reply_t ret = db_reply_new();
 
     try{
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " DELETE FROM"
             "   t_bios_asset_link"
             " WHERE"
-            "   id_asset_device_dest = :dest"
-        );
+            "   id_asset_device_dest = :dest");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         ret.affected_rows = st.set("dest", asset_device_id).
                                execute();
         log_debug ("[t_bios_asset_link]: was deleted %"
                                 PRIu64 " rows", ret.affected_rows);
+        probe.rows (ret.affected_rows);
+        if (ret.affected_rows != 0)
+            DBAssetGeneration::changed (conn, DBChangeNotify::LINK, DBChangeNotify::DELETED, asset_device_id);
         ret.status = 1;
         LOG_END;
         return ret;
     }
     catch (const std::exception &e) {
+        probe.error ();
         ret.status     = 0;
         ret.errtype    = DB_ERR;
         ret.errsubtype = DB_ERROR_INTERNAL;
@@ -136,28 +146,33 @@ db_reply_t
 delete_asset_group_links (tntdb::Connection &conn,
                           uint32_t asset_group_id)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
     log_debug ("  asset_group_id = %" PRIu32, asset_group_id);
 
     db_reply_t ret = db_reply_new();
 
     try{
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " DELETE FROM"
             "   t_bios_asset_group_relation"
             " WHERE"
-            "   id_asset_group = :grp"
-        );
+            "   id_asset_group = :grp");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         ret.affected_rows = st.set("grp", asset_group_id).
                                execute();
         log_debug ("[t_bios_asset_group_relation]: was deleted %"
                                 PRIu64 " rows", ret.affected_rows);
+        probe.rows (ret.affected_rows);
+        if (ret.affected_rows != 0)
+            DBAssetGeneration::changed (conn, DBChangeNotify::GROUP, DBChangeNotify::DELETED, asset_group_id);
         ret.status = 1;
         LOG_END;
         return ret;
     }
     catch (const std::exception &e) {
+        probe.error ();
         ret.status     = 0;
         ret.errtype    = DB_ERR;
         ret.errsubtype = DB_ERROR_INTERNAL;
@@ -175,6 +190,7 @@ delete_asset_ext_attribute (tntdb::Connection &conn,
                             const char *keytag,
                             uint32_t asset_element_id)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
 
     db_reply_t ret = db_reply_new();
@@ -201,19 +217,22 @@ delete_asset_ext_attribute (tntdb::Connection &conn,
     log_debug ("input parameters are correct");
 
     try{
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " DELETE FROM"
             "   t_bios_asset_ext_attributes"
             " WHERE"
             "   keytag = :keytag AND"
-            "   id_asset_element = :element"
-        );
+            "   id_asset_element = :element");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         ret.affected_rows = st.set("keytag", keytag).
                                set("element", asset_element_id).
                                execute();
         log_debug("[t_bios_asset_ext_attributes]: was deleted %"
                                 PRIu64 " rows", ret.affected_rows);
+        probe.rows (ret.affected_rows);
+        if (ret.affected_rows != 0)
+            DBAssetGeneration::changed (conn, DBChangeNotify::EXT_ATTRIBUTE, DBChangeNotify::DELETED, asset_element_id);
         if ( ( ret.affected_rows == 1 ) || ( ret.affected_rows == 0 ) )
         {
             ret.status = 1;
@@ -231,6 +250,7 @@ delete_asset_ext_attribute (tntdb::Connection &conn,
         }
     }
     catch (const std::exception &e) {
+        probe.error ();
         ret.status     = 0;
         ret.errtype    = DB_ERR;
         ret.errsubtype = DB_ERROR_INTERNAL;
@@ -245,30 +265,35 @@ delete_asset_ext_attributes_with_ro (tntdb::Connection &conn,
                                      uint32_t asset_element_id,
                                      bool read_only)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
     log_debug ("read_only = %i, asset_element_id = %" PRIu32, read_only, asset_element_id);
 
     db_reply_t ret = db_reply_new();
 
     try{
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " DELETE FROM"
             "   t_bios_asset_ext_attributes"
             " WHERE"
             "   id_asset_element = :element AND "
-            "   read_only = :ro "
-        );
+            "   read_only = :ro ");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         ret.affected_rows = st.set("element", asset_element_id).
                                set("ro", read_only).
                                execute();
         log_debug("[t_bios_asset_ext_attributes]: was deleted %"
                                 PRIu64 " rows", ret.affected_rows);
+        probe.rows (ret.affected_rows);
+        if (ret.affected_rows != 0)
+            DBAssetGeneration::changed (conn, DBChangeNotify::EXT_ATTRIBUTE, DBChangeNotify::DELETED, asset_element_id);
         ret.status = 1;
         LOG_END;
         return ret;
     }
     catch (const std::exception &e) {
+        probe.error ();
         ret.status     = 0;
         ret.errtype    = DB_ERR;
         ret.errsubtype = DB_ERROR_INTERNAL;
@@ -282,23 +307,29 @@ db_reply_t
 delete_asset_element (tntdb::Connection &conn,
                       uint32_t asset_element_id)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
     log_debug ("asset_element_id = %" PRIu32, asset_element_id);
 
     db_reply_t ret = db_reply_new();
 
     try{
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " DELETE FROM"
             "   t_bios_asset_element"
             " WHERE"
-            "   id_asset_element = :element"
-        );
+            "   id_asset_element = :element");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         ret.affected_rows  = st.set("element", asset_element_id).
                                 execute();
         log_debug("[t_bios_asset_element]: was deleted %"
                                 PRIu64 " rows", ret.affected_rows);
+        probe.rows (ret.affected_rows);
+        if (ret.affected_rows != 0)
+            DBAssetGeneration::changed (conn, DBChangeNotify::ELEMENT, DBChangeNotify::DELETED, asset_element_id);
+        if (ret.affected_rows == 1)
+            DBAssetClosure::element_deleted (conn, asset_element_id);
         if ( ( ret.affected_rows == 1 ) || ( ret.affected_rows == 0 ) )
         {
             ret.status = 1;
@@ -316,6 +347,7 @@ delete_asset_element (tntdb::Connection &conn,
         }
     }
     catch (const std::exception &e) {
+        probe.error ();
         ret.status     = 0;
         ret.errtype    = DB_ERR;
         ret.errsubtype = DB_ERROR_INTERNAL;
@@ -329,28 +361,34 @@ db_reply_t
 delete_asset_element_from_asset_groups (tntdb::Connection &conn,
                                         uint32_t asset_element_id)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
     log_debug ("asset_element_id = %" PRIu32, asset_element_id);
 
     db_reply_t ret = db_reply_new();
 
     try{
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " DELETE FROM"
             "   t_bios_asset_group_relation"
             " WHERE"
-            "   id_asset_element = :element"
-        );
+            "   id_asset_element = :element");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         ret.affected_rows = st.set("element", asset_element_id).
                                execute();
         log_debug("[t_bios_asset_group_relation]: was deleted %"
                                 PRIu64 " rows", ret.affected_rows);
+        probe.rows (ret.affected_rows);
+        // groups of element are not known
+        if (ret.affected_rows != 0)
+            DBAssetGeneration::changed (conn, DBChangeNotify::GROUP, DBChangeNotify::DELETED, 0);
         ret.status = 1;
         LOG_END;
         return ret;
     }
     catch (const std::exception &e) {
+        probe.error ();
         ret.status     = 0;
         ret.errtype    = DB_ERR;
         ret.errsubtype = DB_ERROR_INTERNAL;
@@ -365,6 +403,7 @@ delete_asset_element_from_asset_group (tntdb::Connection &conn,
                                        uint32_t asset_group_id,
                                        uint32_t asset_element_id)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
     log_debug ("  asset_group_id = %" PRIu32, asset_group_id);
     log_debug ("  asset_element_id = %" PRIu32, asset_element_id);
@@ -372,19 +411,22 @@ delete_asset_element_from_asset_group (tntdb::Connection &conn,
     db_reply_t ret = db_reply_new();
 
     try{
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " DELETE FROM"
             "   t_bios_asset_group_relation"
             " WHERE"
             "   id_asset_group = :grp AND"
-            "   id_asset_element = :element"
-        );
+            "   id_asset_element = :element");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         ret.affected_rows = st.set("grp", asset_group_id).
                                set("element", asset_element_id).
                                execute();
         log_debug("[t_bios_asset_group_relation]: was deleted %"
                                 PRIu64 " rows", ret.affected_rows);
+        probe.rows (ret.affected_rows);
+        if (ret.affected_rows != 0)
+            DBAssetGeneration::changed (conn, DBChangeNotify::GROUP, DBChangeNotify::DELETED, asset_group_id);
         if ( ( ret.affected_rows == 1 ) || ( ret.affected_rows == 0 ) )
         {
             ret.status = 1;
@@ -402,6 +444,7 @@ delete_asset_element_from_asset_group (tntdb::Connection &conn,
         }
     }
     catch (const std::exception &e) {
+        probe.error ();
         ret.status     = 0;
         ret.errtype    = DB_ERR;
         ret.errsubtype = DB_ERROR_INTERNAL;
@@ -416,28 +459,33 @@ db_reply_t
 delete_monitor_asset_relation_by_a (tntdb::Connection &conn,
                                     uint32_t id)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
     log_debug ("  id = %" PRIu32, id);
 
     db_reply_t ret = db_reply_new();
 
     try{
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " DELETE FROM"
             "   t_bios_monitor_asset_relation"
             " WHERE"
-            "   id_asset_element = :id"
-        );
+            "   id_asset_element = :id");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         ret.affected_rows = st.set("id", id).
                                execute();
         log_debug("[t_bios_monitor_asset_relation]: was deleted %"
                                 PRIu64 " rows", ret.affected_rows);
+        probe.rows (ret.affected_rows);
+        if (ret.affected_rows != 0)
+            DBAssetGeneration::bump (conn);
         ret.status = 1;
         LOG_END;
         return ret;
     }
     catch (const std::exception &e) {
+        probe.error ();
         ret.status     = 0;
         ret.errtype    = DB_ERR;
         ret.errsubtype = DB_ERROR_INTERNAL;
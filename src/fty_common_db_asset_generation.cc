@@ -0,0 +1,349 @@
+/*  =========================================================================
+    fty_common_db_asset_generation - Generation counter of asset tables
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+
+/*
+@header
+    fty_common_db_asset_generation - Generation counter of asset tables
+@discuss
+    Row 1 of the generation table is the generation, row 2 the generation
+    up to which the change log was trimmed. Generation only grows, write
+    functions bump it once per statement, even if they change more rows.
+    Changes are logged at the next generation before it is bumped, by one
+    statement which locks the generation row, so a reader which sees the
+    bumped generation sees its changes too, even if the writer does not use
+    a transaction.
+    Write functions check the tables after their statement, a process which
+    did not see them yet checks again after RECHECK_S seconds. create waits
+    until all processes check again and for the writers which did not see
+    the tables, and marks all changes before it as trimmed.
+@end
+*/
+
+#include "fty_common_db_classes.h"
+
+namespace DBAssetGeneration {
+
+static DBSql::optional_table_t s_generation ("t_bios_asset_generation");
+static DBSql::optional_table_t s_change_log ("t_bios_asset_change_log");
+
+// s_table_available: check if table exists
+static bool
+s_table_available (tntdb::Connection &conn,
+                   DBSql::optional_table_t &table)
+{
+    try {
+        return table.exists (conn);
+    }
+    catch (const std::exception &e) {
+        log_error ("can't check %s: %s", table.name (), e.what ());
+        return false;
+    }
+}
+
+bool
+available (tntdb::Connection &conn)
+{
+    return s_table_available (conn, s_generation);
+}
+
+bool
+log_available (tntdb::Connection &conn)
+{
+    return available (conn) && s_table_available (conn, s_change_log);
+}
+
+static const DBStatementCache::query_t s_current_query (
+    " SELECT generation"
+    " FROM"
+    "   t_bios_asset_generation"
+    " WHERE"
+    "   id_generation = 1");
+
+static const DBStatementCache::query_t s_trim_mark_query (
+    " INSERT INTO t_bios_asset_generation"
+    "   (id_generation, generation)"
+    " VALUES"
+    "   (2, :generation)"
+    " ON DUPLICATE KEY UPDATE"
+    "   generation = GREATEST(generation, VALUES(generation))");
+
+int
+create (tntdb::Connection &conn)
+{
+    LOG_START;
+
+    try {
+        conn.execute (
+            " CREATE TABLE IF NOT EXISTS t_bios_asset_generation ("
+            "   id_generation   TINYINT UNSIGNED NOT NULL,"
+            "   generation      BIGINT UNSIGNED NOT NULL,"
+            "   PRIMARY KEY (id_generation)"
+            " ) ENGINE=InnoDB"
+        );
+        conn.execute (
+            " INSERT IGNORE INTO t_bios_asset_generation"
+            "   (id_generation, generation)"
+            " VALUES"
+            "   (1, 0), (2, 0)"
+        );
+        conn.execute (
+            " CREATE TABLE IF NOT EXISTS t_bios_asset_change_log ("
+            "   id_change       BIGINT UNSIGNED NOT NULL AUTO_INCREMENT,"
+            "   generation      BIGINT UNSIGNED NOT NULL,"
+            "   table_id        TINYINT UNSIGNED NOT NULL,"
+            "   kind            TINYINT UNSIGNED NOT NULL,"
+            "   id_row          INT UNSIGNED NOT NULL,"
+            "   PRIMARY KEY (id_change),"
+            "   INDEX (generation)"
+            " ) ENGINE=InnoDB"
+        );
+        s_generation.created ();
+        s_change_log.created ();
+
+        // writers which did not see the tables did not bump the generation,
+        // wait for them and start a new generation which nothing can be
+        // refreshed to by changes_since
+        DBSql::wait_for_writers (conn);
+        tntdb::Transaction trans (conn);
+        bump (conn);
+        uint64_t generation = 0;
+        DBStatementCache::prepare (conn, s_current_query).selectValue ().get (generation);
+        DBStatementCache::prepare (conn, s_trim_mark_query).set ("generation", generation).execute ();
+        trans.commit ();
+    }
+    catch (const std::exception &e) {
+        LOG_END_ABNORMAL(e);
+        return -1;
+    }
+    LOG_END;
+    return 0;
+}
+
+int64_t
+current (tntdb::Connection &conn)
+{
+    if (!available (conn))
+        return -1;
+
+    try {
+        tntdb::Statement st = DBStatementCache::prepare (conn, s_current_query);
+        uint64_t generation = 0;
+        st.selectValue ().get (generation);
+        return static_cast <int64_t> (generation);
+    }
+    catch (const std::exception &e) {
+        log_error ("can't read asset generation: %s", e.what ());
+        return -1;
+    }
+}
+
+void
+bump (tntdb::Connection &conn)
+{
+    if (!s_table_available (conn, s_generation))
+        return;
+
+    static const DBStatementCache::query_t st_query (
+        " UPDATE t_bios_asset_generation"
+        " SET"
+        "   generation = generation + 1"
+        " WHERE"
+        "   id_generation = 1");
+    tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
+    st.execute ();
+}
+
+// s_log_sql: INSERT of n changes at the next generation
+static std::string
+s_log_sql (size_t n)
+{
+    std::string changes;
+    for (size_t i = 0; i != n; i++) {
+        changes += i == 0 ? "   SELECT " : "   UNION ALL SELECT ";
+        changes += ":" + DBSql::sql_plac (i, 0) + " AS table_id, ";
+        changes += ":" + DBSql::sql_plac (i, 1) + " AS kind, ";
+        changes += ":" + DBSql::sql_plac (i, 2) + " AS id_row";
+    }
+    return
+        " INSERT INTO t_bios_asset_change_log"
+        "   (generation, table_id, kind, id_row)"
+        " SELECT"
+        "   g.generation + 1, c.table_id, c.kind, c.id_row"
+        " FROM"
+        "   t_bios_asset_generation g,"
+        "   (" + changes + ") c"
+        " WHERE"
+        "   g.id_generation = 1"
+        " FOR UPDATE";
+}
+
+void
+changed (tntdb::Connection &conn,
+         const std::vector <DBChangeNotify::change_t> &changes)
+{
+    if (changes.empty ())
+        return;
+
+    if (s_table_available (conn, s_generation) && s_table_available (conn, s_change_log)) {
+        size_t count = 0;
+        for (size_t first = 0; first < changes.size (); first += count) {
+            count = DBSql::insert_chunk (changes.size () - first);
+            tntdb::Statement st = DBStatementCache::prepare (conn, s_log_sql (count));
+            for (size_t i = 0; i != count; i++) {
+                const DBChangeNotify::change_t &change = changes [first + i];
+                st.set (DBSql::sql_plac (i, 0), static_cast <uint32_t> (change.table)).
+                   set (DBSql::sql_plac (i, 1), static_cast <uint32_t> (change.kind)).
+                   set (DBSql::sql_plac (i, 2), change.id);
+            }
+            st.execute ();
+        }
+    }
+    bump (conn);
+    for (const auto &change : changes)
+        DBChangeNotify::changed (change.table, change.kind, change.id);
+}
+
+void
+changed (tntdb::Connection &conn,
+         DBChangeNotify::table_t table,
+         DBChangeNotify::kind_t kind,
+         uint32_t id)
+{
+    changed (conn, std::vector <DBChangeNotify::change_t> {DBChangeNotify::change_t {table, kind, id}});
+}
+
+static const DBStatementCache::query_t s_log_bounds_query (
+    " SELECT"
+    "   MAX(CASE WHEN id_generation = 1 THEN generation END),"
+    "   COALESCE(MAX(CASE WHEN id_generation = 2 THEN generation END), 0)"
+    " FROM"
+    "   t_bios_asset_generation");
+
+static const unsigned CHANGES_FETCH_SIZE = 256;
+
+int64_t
+changes_since (tntdb::Connection &conn,
+               uint64_t generation,
+               change_cb_f cb)
+{
+    LOG_START;
+    if (!log_available (conn)) {
+        log_debug ("end: change log is not available");
+        return -1;
+    }
+
+    try {
+        tntdb::Row bounds = DBStatementCache::prepare (conn, s_log_bounds_query).selectRow ();
+        uint64_t current = 0;
+        uint64_t trimmed = 0;
+        bounds[0].get (current);
+        bounds[1].get (trimmed);
+        if (generation < trimmed) {
+            log_info ("end: changes after %" PRIu64 " were trimmed up to %" PRIu64, generation, trimmed);
+            return CHANGES_TRIMMED;
+        }
+
+        size_t rows = 0;
+        if (generation < current) {
+            // changes of generations up to current are all committed
+            // rows are streamed, the statement is not cached, see select_assets_stream
+            static const DBStatementCache::query_t st_query (
+                " SELECT"
+                "   generation, table_id, kind, id_row"
+                " FROM"
+                "   t_bios_asset_change_log"
+                " WHERE"
+                "   generation > :since AND"
+                "   generation <= :current"
+                " ORDER BY"
+                "   generation, id_change");
+            tntdb::Statement st = conn.prepare (st_query.sql ());
+            st.set ("since", generation).
+               set ("current", current);
+            for (auto it = st.begin (CHANGES_FETCH_SIZE); it != st.end (); ++it) {
+                uint64_t made = 0;
+                uint32_t table = 0, kind = 0, id = 0;
+                (*it)[0].get (made);
+                (*it)[1].get (table);
+                (*it)[2].get (kind);
+                (*it)[3].get (id);
+                rows++;
+                if (table < DBChangeNotify::ELEMENT || table > DBChangeNotify::EXT_ATTRIBUTE ||
+                    kind < DBChangeNotify::INSERTED || kind > DBChangeNotify::DELETED) {
+                    log_warning ("unknown change %" PRIu32 "/%" PRIu32 " ignored", table, kind);
+                    continue;
+                }
+                cb (DBChangeNotify::change_t {static_cast <DBChangeNotify::table_t> (table),
+                                              static_cast <DBChangeNotify::kind_t> (kind),
+                                              id},
+                    made);
+            }
+        }
+        log_debug ("[t_bios_asset_change_log]: were streamed %zu rows", rows);
+
+        // trim marks first and deletes then, changes read after the first
+        // look at the mark may be gone
+        bounds = DBStatementCache::prepare (conn, s_log_bounds_query).selectRow ();
+        bounds[1].get (trimmed);
+        if (generation < trimmed) {
+            log_info ("end: changes after %" PRIu64 " were trimmed while reading them", generation);
+            return CHANGES_TRIMMED;
+        }
+        LOG_END;
+        return static_cast <int64_t> (current);
+    }
+    catch (const std::exception &e) {
+        LOG_END_ABNORMAL(e);
+        return -1;
+    }
+}
+
+int
+trim_changes (tntdb::Connection &conn,
+              uint64_t generation)
+{
+    LOG_START;
+    if (!log_available (conn)) {
+        log_debug ("end: change log is not available");
+        return -1;
+    }
+
+    try {
+        // mark first, so readers notice changes deleted under them
+        DBStatementCache::prepare (conn, s_trim_mark_query).set ("generation", generation).execute ();
+        static const DBStatementCache::query_t st_query (
+            " DELETE FROM t_bios_asset_change_log"
+            " WHERE"
+            "   generation <= :generation");
+        tntdb::Statement::size_type rows =
+            DBStatementCache::prepare (conn, st_query).set ("generation", generation).execute ();
+        log_debug ("[t_bios_asset_change_log]: were deleted %" PRIu32 " rows", rows);
+    }
+    catch (const std::exception &e) {
+        LOG_END_ABNORMAL(e);
+        return -1;
+    }
+    LOG_END;
+    return 0;
+}
+
+} // namespace
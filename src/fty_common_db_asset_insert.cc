@@ -117,7 +117,7 @@ insert_into_asset_ext_attribute_template (tntdb::Connection &conn,
 
     try {
 
-        tntdb::Statement st = conn.prepareCached(query);
+        tntdb::Statement st = DBStatementCache::prepare (conn, query);
 
         n = st.set("keytag"  , keytag).
                set("value"   , value).
@@ -128,6 +128,10 @@ insert_into_asset_ext_attribute_template (tntdb::Connection &conn,
         log_debug ("was inserted %" PRIu32 " rows", n);
         ret.affected_rows = n;
         ret.rowid = newid;
+        if (n != 0)
+            DBAssetGeneration::changed (conn, DBChangeNotify::EXT_ATTRIBUTE,
+                                        n == 1 ? DBChangeNotify::INSERTED : DBChangeNotify::UPDATED,
+                                        asset_element_id);
         // attention:
         //  -- 0 rows can be inserted
         //        - there is no free space
@@ -174,6 +178,7 @@ insert_into_asset_ext_attribute (tntdb::Connection &conn,
                                  uint32_t  asset_element_id,
                                  bool          read_only)
 {
+    DBMETRICS_PROBE (probe);
     if ( !read_only )
     {
         log_debug ("use pure insert");
@@ -190,54 +195,15 @@ insert_into_asset_ext_attribute (tntdb::Connection &conn,
     }
 }
 
-// sql_plac: generate the placeholder name
-// example: sql_plac(2, 3) -> "item2_3";
-static std::string
-sql_plac (size_t i, size_t j)
-{
-    return "item" + std::to_string(i) + "_" + std::to_string(j);
-}
-
-//multi_insert_string: generate the SQL string for multivalue insert
-// Example:
-// multi_insert_string("INSERT INTO t_bios_foo", 2, 3, "ON DUPLICATE KEY ....") ->
-// 'INSERT INTO t_bios_foo (foo, bar)
-// VALUES(:item0_0, :item0_1),
-// (:item1_0, :item1_1),
-// (:item2_0, :item2_1)
-//  ON DUPLICATE KEY UPDATE ...'
-static std::string
-multi_insert_string (const std::string& sql_header,
-                     size_t tuple_len,
-                     size_t items_len,
-                     const std::string& sql_postfix)
-{
-    std::stringstream s{};
-
-    s << sql_header;
-    s << "\nVALUES ";
-    for (size_t i = 0; i != items_len; i++) {
-        s << "(";
-        for (size_t j = 0; j != tuple_len; j++) {
-            s << ":" << sql_plac(i, j);
-            if (j < tuple_len -1)
-                s << ", ";
-        }
-        if (i < items_len -1)
-            s << "),\n";
-        else
-            s << ")\n";
-    }
-    s << sql_postfix;
-    return s.str();
-}
-
-// generate the proper tntdb::Statement for multi value insert for extended attributes
-static tntdb::Statement
-s_multi_insert_statement (tntdb::Connection& conn,
-                          uint32_t element_id,
-                          bool read_only,
-                          zhash_t* attributes)
+// s_insert_ext_attributes_chunk: insert attributes [first, first + count) by one statement
+// returns number of affected rows
+static size_t
+s_insert_ext_attributes_chunk (tntdb::Connection &conn,
+                               uint32_t element_id,
+                               const std::vector <std::pair <std::string, std::string>> &attributes,
+                               bool read_only,
+                               size_t first,
+                               size_t count)
 {
     static const std::string sql_header =
         "INSERT INTO "
@@ -246,28 +212,60 @@ s_multi_insert_statement (tntdb::Connection& conn,
         " ON DUPLICATE KEY "
         "   UPDATE "
         "       id_asset_ext_attribute = LAST_INSERT_ID(id_asset_ext_attribute) ";
-    auto sql = multi_insert_string(
-            sql_header,
-            4,
-            zhash_size(attributes), sql_postfix);
+    tntdb::Statement st = DBStatementCache::prepare (conn, DBSql::multi_insert_string (sql_header, 4, count, sql_postfix));
+
+    for (size_t i = 0; i != count; i++) {
+        const auto &attribute = attributes [first + i];
+        st.set(DBSql::sql_plac(i, 0), attribute.first);
+        st.set(DBSql::sql_plac(i, 1), attribute.second);
+        st.set(DBSql::sql_plac(i, 2), element_id);
+        st.set(DBSql::sql_plac(i, 3), read_only);
+    }
+    return st.execute ();
+}
 
-    log_debug("sql: '%s'", sql.c_str());
-    auto st = conn.prepare(sql);
+// s_insert_ext_attributes: insert attributes in chunks in one transaction
+static db_reply_t
+s_insert_ext_attributes (tntdb::Connection &conn,
+                         uint32_t element_id,
+                         const std::vector <std::pair <std::string, std::string>> &attributes,
+                         bool read_only,
+                         std::vector <size_t> &affected)
+{
+    DBMETRICS_PROBE_AS (probe, "insert_into_asset_ext_attributes");
+    LOG_START;
 
-    char *value = (char *) zhash_first (attributes);   // first value
-    size_t i = 0;
-    while ( value != NULL )
-        {
-            char *key = (char *) zhash_cursor (attributes);   // key of this value
-            st.set(sql_plac(i, 0), key);
-            st.set(sql_plac(i, 1), value);
-            st.set(sql_plac(i, 2), element_id);
-            st.set(sql_plac(i, 3), read_only);
-            value     = (char *) zhash_next (attributes);   // next value
-            i++;
+    db_reply_t ret = db_reply_new();
+    affected.clear ();
+    try {
+        tntdb::Transaction trans (conn);
+        size_t count = 0;
+        for (size_t first = 0; first < attributes.size (); first += count) {
+            count = DBSql::insert_chunk (attributes.size () - first);
+            affected.push_back (s_insert_ext_attributes_chunk (conn, element_id, attributes, read_only, first, count));
+            ret.affected_rows += affected.back ();
         }
+        if (ret.affected_rows != 0)
+            DBAssetGeneration::changed (conn, DBChangeNotify::EXT_ATTRIBUTE, DBChangeNotify::UPDATED, element_id);
+        trans.commit ();
+        log_debug("%zu attributes written in %zu chunks", attributes.size (), affected.size ());
+        probe.rows (attributes.size ());
+    }
+    catch (const std::exception& e) {
+        probe.error ();
+        affected.clear ();
+        ret.affected_rows = 0;
+        ret.status     = 0;
+        ret.errtype       = DB_ERR;
+        ret.errsubtype    = DB_ERROR_INTERNAL;
+        ret.msg           = e.what();
+        LOG_END_ABNORMAL(e);
+        return ret;
+    }
 
-    return st;
+    ret.status     = 1;
+    LOG_END;
+    return ret;
 }
 
 db_reply_t
@@ -278,7 +276,6 @@ insert_into_asset_ext_attributes (tntdb::Connection &conn,
                                   std::string &err)
 {
     LOG_START;
-    size_t i = 0;
 
     db_reply_t ret = db_reply_new();
     if (!attributes) {
@@ -298,27 +295,46 @@ insert_into_asset_ext_attributes (tntdb::Connection &conn,
         return ret;
     }
 
-    try {
-        auto st = s_multi_insert_statement(
-                conn,
-                element_id,
-                read_only,
-                attributes);
-        i = st.execute();
-        log_debug("%zu attributes written", i);
-        ret.status     = 1;
-        LOG_END;
-        return ret;
-    }
-    catch (const std::exception& e) {
-        ret.affected_rows = i;
+    std::vector <std::pair <std::string, std::string>> pairs;
+    pairs.reserve (zhash_size (attributes));
+    for (char *value = (char *) zhash_first (attributes); value != NULL; value = (char *) zhash_next (attributes))
+        pairs.emplace_back ((const char *) zhash_cursor (attributes), value);
+
+    std::vector <size_t> affected;
+    return s_insert_ext_attributes (conn, element_id, pairs, read_only, affected);
+}
+
+db_reply_t
+insert_into_asset_ext_attributes (tntdb::Connection &conn,
+                                  uint32_t element_id,
+                                  const std::vector <std::pair <std::string, std::string>> &attributes,
+                                  bool read_only,
+                                  std::vector <size_t> &affected)
+{
+    LOG_START;
+
+    db_reply_t ret = db_reply_new();
+    affected.clear ();
+    if ( element_id == 0 || attributes.empty () ) {
         ret.status     = 0;
-        ret.errtype       = DB_ERR;
-        ret.errsubtype    = DB_ERROR_INTERNAL;
-        ret.msg           = e.what();
-        LOG_END_ABNORMAL(e);
+        ret.errtype    = DB_ERR;
+        ret.errsubtype = DB_ERROR_BADINPUT;
+        ret.msg        = TRANSLATE_ME ("no attributes to insert");
+        log_error ("end: %s, %s", "ignore insert", ret.msg.c_str());
         return ret;
     }
+    for (const auto &attribute : attributes) {
+        if ( !persist::is_ok_keytag (attribute.first.c_str ()) || !persist::is_ok_value (attribute.second.c_str ()) ) {
+            ret.status     = 0;
+            ret.errtype    = DB_ERR;
+            ret.errsubtype = DB_ERROR_BADINPUT;
+            ret.msg        = "unacceptable keytag or value";
+            log_error ("end: ignore insert, unacceptable keytag '%s' or value '%s'",
+                       attribute.first.c_str (), attribute.second.c_str ());
+            return ret;
+        }
+    }
+    return s_insert_ext_attributes (conn, element_id, attributes, read_only, affected);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////
@@ -343,6 +359,7 @@ insert_asset_element_into_asset_group (tntdb::Connection &conn,
                                        uint32_t group_id,
                                        uint32_t asset_element_id)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
     log_debug ("  group_id = %" PRIu32, group_id);
     log_debug ("  asset_element_id = %" PRIu32, asset_element_id);
@@ -370,7 +387,7 @@ insert_asset_element_into_asset_group (tntdb::Connection &conn,
     }
 
     try{
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " INSERT INTO"
             "   t_bios_asset_group_relation"
             "   (id_asset_group, id_asset_element)"
@@ -387,8 +404,8 @@ insert_asset_element_into_asset_group (tntdb::Connection &conn,
             "       WHERE"
             "           id_asset_group = :group AND"
             "           id_asset_element = :element"
-            "   )"
-        );
+            "   )");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         ret.affected_rows = st.set("group"  , group_id).
                                set("element", asset_element_id).
@@ -396,11 +413,15 @@ insert_asset_element_into_asset_group (tntdb::Connection &conn,
         ret.rowid = conn.lastInsertId();
         log_debug ("[t_bios_asset_group_relation]: was inserted %"
                                     PRIu64 " rows", ret.affected_rows);
+        probe.rows (ret.affected_rows);
+        if (ret.affected_rows != 0)
+            DBAssetGeneration::changed (conn, DBChangeNotify::GROUP, DBChangeNotify::INSERTED, group_id);
         ret.status = 1;
         LOG_END;
         return ret;
     }
     catch (const std::exception &e) {
+        probe.error ();
         ret.status     = 0;
         ret.errtype    = DB_ERR;
         ret.errsubtype = DB_ERROR_INTERNAL;
@@ -415,6 +436,7 @@ insert_element_into_groups (tntdb::Connection &conn,
                             std::set <uint32_t> const &groups,
                             uint32_t asset_element_id)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
     log_debug ("  asset_element_id = %" PRIu32, asset_element_id);
 
@@ -449,6 +471,13 @@ insert_element_into_groups (tntdb::Connection &conn,
         ret.affected_rows = st.execute();
         log_debug ("[t_bios_asset_group_relation]: was inserted %"
                                 PRIu64 " rows", ret.affected_rows);
+        probe.rows (ret.affected_rows);
+        if (ret.affected_rows != 0) {
+            std::vector <DBChangeNotify::change_t> changes;
+            for (auto group_id : groups)
+                changes.push_back (DBChangeNotify::change_t {DBChangeNotify::GROUP, DBChangeNotify::INSERTED, group_id});
+            DBAssetGeneration::changed (conn, changes);
+        }
 
         if ( ret.affected_rows == groups.size() )
         {
@@ -466,6 +495,7 @@ insert_element_into_groups (tntdb::Connection &conn,
         return ret;
     }
     catch (const std::exception &e) {
+        probe.error ();
         LOG_END_ABNORMAL(e);
         ret.status     = 0;
         ret.errtype    = INTERNAL_ERR;
@@ -475,20 +505,14 @@ insert_element_into_groups (tntdb::Connection &conn,
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-// TODO: check, if it works with multiple powerlinks between two devices
-db_reply_t
-insert_into_asset_link (tntdb::Connection &conn,
-                        uint32_t    asset_element_src_id,
-                        uint32_t    asset_element_dest_id,
-                        uint8_t   link_type_id,
-                        const char* src_out,
-                        const char* dest_in)
+// s_link_input_ok: check parameters of a power link
+// returns false and fills ret with error if link can't be inserted
+static bool
+s_link_input_ok (uint32_t    asset_element_src_id,
+                 uint32_t    asset_element_dest_id,
+                 uint8_t     link_type_id,
+                 db_reply_t &ret)
 {
-    LOG_START;
-
-    db_reply_t ret = db_reply_new();
-
-    // input parameters control
     if ( asset_element_dest_id == 0 )
     {
         ret.status     = 0;
@@ -496,7 +520,7 @@ insert_into_asset_link (tntdb::Connection &conn,
         ret.errsubtype = DB_ERROR_BADINPUT;
         ret.msg        = "destination device is not specified";
         log_error ("end: %s, %s", "ignore insert", ret.msg.c_str());
-        return ret;
+        return false;
     }
     if ( asset_element_src_id == 0 )
     {
@@ -505,7 +529,7 @@ insert_into_asset_link (tntdb::Connection &conn,
         ret.errsubtype = DB_ERROR_BADINPUT;
         ret.msg        = "source device is not specified";
         log_error ("end: %s, %s","ignore insert", ret.msg.c_str());
-        return ret;
+        return false;
     }
     if ( !persist::is_ok_link_type (link_type_id) )
     {
@@ -514,13 +538,33 @@ insert_into_asset_link (tntdb::Connection &conn,
         ret.errsubtype = DB_ERROR_BADINPUT;
         ret.msg        = "wrong link type";
         log_error ("end: %s, %s","ignore insert", ret.msg.c_str());
-        return ret;
+        return false;
     }
     // src_out and dest_in can take any value from available range
+    return true;
+}
+
+// TODO: check, if it works with multiple powerlinks between two devices
+db_reply_t
+insert_into_asset_link (tntdb::Connection &conn,
+                        uint32_t    asset_element_src_id,
+                        uint32_t    asset_element_dest_id,
+                        uint8_t   link_type_id,
+                        const char* src_out,
+                        const char* dest_in)
+{
+    DBMETRICS_PROBE (probe);
+    LOG_START;
+
+    db_reply_t ret = db_reply_new();
+
+    // input parameters control
+    if ( !s_link_input_ok (asset_element_src_id, asset_element_dest_id, link_type_id, ret) )
+        return ret;
     log_debug ("input parameters are correct");
 
     try{
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " INSERT INTO"
             "   t_bios_asset_link"
             "   (id_asset_device_src, id_asset_device_dest,"
@@ -545,8 +589,8 @@ insert_into_asset_link (tntdb::Connection &conn,
             "               v3.id_asset_device_dest = v2.id_asset_element AND"
             "               ( ((v3.src_out = :out) AND (v3.dest_in = :in)) ) AND"
             "               v3.id_asset_device_dest = v2.id_asset_element"
-            "    )"
-        );
+            "    )");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         if ( !src_out || strcmp(src_out, "") == 0 )
             st = st.setNull("out");
@@ -566,11 +610,15 @@ insert_into_asset_link (tntdb::Connection &conn,
         ret.rowid = conn.lastInsertId();
         log_debug ("[t_bios_asset_link]: was inserted %"
                                         PRIu64 " rows", ret.affected_rows);
+        probe.rows (ret.affected_rows);
+        if (ret.affected_rows == 1)
+            DBAssetGeneration::changed (conn, DBChangeNotify::LINK, DBChangeNotify::INSERTED, asset_element_dest_id);
         ret.status = 1;
         LOG_END;
         return ret;
     }
     catch (const std::exception &e) {
+        probe.error ();
         ret.status     = 0;
         ret.errtype    = DB_ERR;
         ret.errsubtype = DB_ERROR_INTERNAL;
@@ -584,14 +632,53 @@ db_reply_t
 insert_into_new_asset_links (tntdb::Connection &conn,
                             std::vector <new_link_t> const &links)
 {
+    DBMETRICS_PROBE (probe);
     std::vector<link_t> oldLinks;
 
+    std::vector <std::string> names;
+    for (const auto &l : links)
+    {
+        names.push_back (l.src);
+        names.push_back (l.dest);
+    }
+
+    std::map <std::string, uint32_t> ids;
+    std::vector <std::string> missing;
+    if (DBAssets::names_to_asset_ids (conn, names, ids, missing) != 0)
+    {
+        db_reply_t ret = db_reply_new();
+        ret.status     = 0;
+        ret.errtype    = DB_ERR;
+        ret.errsubtype = DB_ERROR_INTERNAL;
+        ret.msg        = "cannot resolve names of linked assets";
+        log_error ("end: %s", ret.msg.c_str());
+        return ret;
+    }
+    for (const auto &name : missing)
+        log_error ("element %s not found", name.c_str ());
+
+    // ids are keyed by names as stored in the database, match them folded
+    std::map <std::string, uint32_t> folded_ids;
+    for (const auto &it : ids)
+    {
+        std::string key;
+        DBSql::fold (it.first, key);
+        folded_ids [key] = it.second;
+    }
+
+    // unknown names stay 0 and such links are refused by insert_into_asset_link
     for(const auto & l : links)
     {
         link_t oldLink;
 
-        oldLink.src = DBAssets::name_to_asset_id(l.src);
-        oldLink.dest = DBAssets::name_to_asset_id(l.dest);
+        std::string src_key;
+        std::string dest_key;
+        DBSql::fold (l.src, src_key);
+        DBSql::fold (l.dest, dest_key);
+        auto src = folded_ids.find (src_key);
+        auto dest = folded_ids.find (dest_key);
+        oldLink.src = src == folded_ids.end () ? 0 : src->second;
+        oldLink.dest = dest == folded_ids.end () ? 0 : dest->second;
         oldLink.src_out = l.src_out;
         oldLink.dest_in = l.dest_in;
         oldLink.type = l.type;
@@ -602,13 +689,145 @@ insert_into_new_asset_links (tntdb::Connection &conn,
     return insert_into_asset_links(conn, oldLinks);
 }
 
+// s_socket: NULL or empty socket name is stored as NULL
+static bool
+s_socket_null (const char *socket)
+{
+    return !socket || strcmp (socket, "") == 0;
+}
+
+// s_select_devices: which of given ids are devices (see v_bios_asset_device)
+static std::set <uint32_t>
+s_select_devices (tntdb::Connection &conn,
+                  const std::vector <uint32_t> &ids)
+{
+    std::set <uint32_t> devices;
+    for (size_t first = 0; first < ids.size (); first += DBSql::MAX_IN_LIST) {
+        size_t bucket = DBSql::in_list_bucket (ids.size () - first);
+        tntdb::Statement st = DBStatementCache::prepare (conn,
+            " SELECT"
+            "   v.id_asset_element"
+            " FROM"
+            "   v_bios_asset_device v"
+            " WHERE"
+            "   v.id_asset_element IN (" + DBSql::in_list ("id", bucket) + ")");
+        DBSql::bind_in_list (st, "id", ids, first, bucket);
+        for (const auto &row : st.select ()) {
+            uint32_t id = 0;
+            row[0].get(id);
+            devices.insert (id);
+        }
+    }
+    return devices;
+}
+
+typedef std::tuple <uint32_t, uint32_t, std::string, std::string> s_link_key_t;
+
+// s_link_key: key of link with folded sockets, they are compared like the
+// database does, without case and trailing spaces
+// returns false if a socket has other than ASCII characters
+static bool
+s_link_key (uint32_t src,
+            uint32_t dest,
+            const std::string &src_out,
+            const std::string &dest_in,
+            s_link_key_t &key)
+{
+    std::get<0>(key) = src;
+    std::get<1>(key) = dest;
+    return DBSql::fold (src_out, std::get<2>(key)) && DBSql::fold (dest_in, std::get<3>(key));
+}
+
+// s_select_links_to: existing links (src, dest, src_out, dest_in) to given devices
+// links with NULL socket are omitted, same as in duplicity check of insert_into_asset_link
+// devices having a link with socket which can't be folded go to unsafe
+static std::set <s_link_key_t>
+s_select_links_to (tntdb::Connection &conn,
+                   const std::vector <uint32_t> &dests,
+                   std::set <uint32_t> &unsafe)
+{
+    std::set <s_link_key_t> links;
+    for (size_t first = 0; first < dests.size (); first += DBSql::MAX_IN_LIST) {
+        size_t bucket = DBSql::in_list_bucket (dests.size () - first);
+        tntdb::Statement st = DBStatementCache::prepare (conn,
+            " SELECT"
+            "   id_asset_device_src, id_asset_device_dest, src_out, dest_in"
+            " FROM"
+            "   t_bios_asset_link"
+            " WHERE"
+            "   src_out IS NOT NULL AND dest_in IS NOT NULL AND"
+            "   id_asset_device_dest IN (" + DBSql::in_list ("id", bucket) + ")");
+        DBSql::bind_in_list (st, "id", dests, first, bucket);
+        for (const auto &row : st.select ()) {
+            uint32_t src = 0;
+            uint32_t dest = 0;
+            std::string src_out;
+            std::string dest_in;
+            row[0].get(src);
+            row[1].get(dest);
+            row[2].get(src_out);
+            row[3].get(dest_in);
+            s_link_key_t key;
+            if (s_link_key (src, dest, src_out, dest_in, key))
+                links.insert (key);
+            else
+                unsafe.insert (dest);
+        }
+    }
+    return links;
+}
+
+// s_insert_links_chunk: insert links [first, first + count) of pending by one statement
+static void
+s_insert_links_chunk (tntdb::Connection &conn,
+                      std::vector <link_t> const &links,
+                      std::vector <size_t> const &pending,
+                      size_t first,
+                      size_t count)
+{
+    static const std::string sql_header =
+        " INSERT INTO"
+        "   t_bios_asset_link"
+        "   (id_asset_device_src, id_asset_device_dest,"
+        "        id_asset_link_type, src_out, dest_in)";
+    tntdb::Statement st = DBStatementCache::prepare (conn, DBSql::multi_insert_string (sql_header, 5, count, ""));
+
+    for (size_t i = 0; i != count; i++) {
+        const link_t &link = links [pending [first + i]];
+        st.set(DBSql::sql_plac(i, 0), link.src);
+        st.set(DBSql::sql_plac(i, 1), link.dest);
+        st.set(DBSql::sql_plac(i, 2), link.type);
+        if ( s_socket_null (link.src_out) )
+            st.setNull(DBSql::sql_plac(i, 3));
+        else
+            st.set(DBSql::sql_plac(i, 3), link.src_out);
+        if ( s_socket_null (link.dest_in) )
+            st.setNull(DBSql::sql_plac(i, 4));
+        else
+            st.set(DBSql::sql_plac(i, 4), link.dest_in);
+    }
+    size_t n = st.execute();
+    log_debug ("[t_bios_asset_link]: was inserted %zu rows", n);
+}
+
 db_reply_t
 insert_into_asset_links (tntdb::Connection &conn,
                          std::vector <link_t> const &links)
 {
+    std::vector <db_reply_t> statuses;
+    return insert_into_asset_links (conn, links, statuses);
+}
+
+db_reply_t
+insert_into_asset_links (tntdb::Connection &conn,
+                         std::vector <link_t> const &links,
+                         std::vector <db_reply_t> &statuses)
+{
+    DBMETRICS_PROBE (probe);
     LOG_START;
 
     db_reply_t ret = db_reply_new();
+    statuses.assign (links.size (), db_reply_new());
 
     // input parameters control
     if ( links.empty() )
@@ -619,14 +838,120 @@ insert_into_asset_links (tntdb::Connection &conn,
         // actually, if there is nothing to insert, then insert was ok :)
         return ret;
     }
-    log_debug ("input parameters are correct");
 
-    for ( auto &one_link : links )
+    std::vector <size_t> valid;
+    std::set <uint32_t> ids;
+    std::set <uint32_t> dests;
+    for ( size_t i = 0; i != links.size (); i++ )
     {
-        auto ret_internal = DBAssetsInsert::insert_into_asset_link
-                (conn, one_link.src, one_link.dest, one_link.type,
-                       one_link.src_out, one_link.dest_in);
-        if ( ret_internal.status == 1 )
+        const link_t &link = links [i];
+        if ( !s_link_input_ok (link.src, link.dest, link.type, statuses [i]) )
+            continue;
+        valid.push_back (i);
+        ids.insert (link.src);
+        ids.insert (link.dest);
+        dests.insert (link.dest);
+    }
+    log_debug ("%zu of %zu links have correct input parameters", valid.size (), links.size ());
+
+    // links which are not between devices or which already exist are
+    // not inserted, but reported as ok, same as by insert_into_asset_link
+    // sockets which can't be folded are compared by the database, such
+    // links are inserted one by one
+    std::vector <size_t> pending;
+    std::vector <size_t> single;
+    try {
+        std::set <uint32_t> devices = s_select_devices (conn, std::vector <uint32_t> (ids.begin (), ids.end ()));
+        std::set <uint32_t> unsafe;
+        std::set <s_link_key_t> existing = s_select_links_to (conn, std::vector <uint32_t> (dests.begin (), dests.end ()), unsafe);
+
+        for ( auto i : valid )
+        {
+            const link_t &link = links [i];
+            if ( devices.count (link.src) == 0 || devices.count (link.dest) == 0 )
+                continue;
+            if ( !s_socket_null (link.src_out) && !s_socket_null (link.dest_in) )
+            {
+                s_link_key_t key;
+                if ( unsafe.count (link.dest) != 0 || !s_link_key (link.src, link.dest, link.src_out, link.dest_in, key) )
+                {
+                    single.push_back (i);
+                    continue;
+                }
+                // also filters duplicities inside of links
+                if ( !existing.insert (key).second )
+                    continue;
+            }
+            pending.push_back (i);
+        }
+    }
+    catch (const std::exception &e) {
+        probe.error ();
+        LOG_END_ABNORMAL(e);
+        for ( auto i : valid )
+        {
+            statuses [i].status     = 0;
+            statuses [i].errtype    = DB_ERR;
+            statuses [i].errsubtype = DB_ERROR_INTERNAL;
+            statuses [i].msg        = e.what();
+        }
+        ret.status     = 0;
+        ret.errtype    = INTERNAL_ERR;
+        log_error ("end: %s", "not all links were inserted");
+        return ret;
+    }
+
+    size_t count = 0;
+    for ( size_t first = 0; first < pending.size (); first += count )
+    {
+        count = DBSql::insert_chunk (pending.size () - first);
+        try {
+            s_insert_links_chunk (conn, links, pending, first, count);
+        }
+        catch (const std::exception &e) {
+            probe.error ();
+            // find out which link is wrong, one by one
+            log_warning ("multi-row insert of links failed with '%s', inserting one by one", e.what());
+            for ( size_t i = first; i != first + count; i++ )
+                single.push_back (pending [i]);
+            continue;
+        }
+
+        // only links of the chunk are in the table now, failure here must
+        // not insert them again
+        try {
+            std::vector <DBChangeNotify::change_t> changes;
+            for ( size_t i = first; i != first + count; i++ )
+            {
+                const link_t &link = links [pending [i]];
+                statuses [pending [i]].affected_rows = 1;
+                changes.push_back (DBChangeNotify::change_t {DBChangeNotify::LINK, DBChangeNotify::INSERTED, link.dest});
+            }
+            DBAssetGeneration::changed (conn, changes);
+        }
+        catch (const std::exception &e) {
+            probe.error ();
+            log_error ("links were inserted, but their changes were not recorded: %s", e.what());
+            for ( size_t i = first; i != first + count; i++ )
+            {
+                statuses [pending [i]].status     = 0;
+                statuses [pending [i]].errtype    = DB_ERR;
+                statuses [pending [i]].errsubtype = DB_ERROR_INTERNAL;
+                statuses [pending [i]].msg        = e.what();
+            }
+        }
+    }
+    for ( auto i : single )
+    {
+        const link_t &link = links [i];
+        statuses [i] = DBAssetsInsert::insert_into_asset_link
+            (conn, link.src, link.dest, link.type,
+                   link.src_out, link.dest_in);
+    }
+
+    for ( const auto &status : statuses )
+    {
+        if ( status.status == 1 )
             ret.affected_rows++;
     }
     if ( ret.affected_rows == links.size() )
@@ -659,6 +984,7 @@ insert_into_asset_element (tntdb::Connection &conn,
                            const char *asset_tag,
                            bool update)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
     log_debug ("  element_name = '%s'", element_name);
     if (subtype_id == 0)
@@ -701,21 +1027,22 @@ insert_into_asset_element (tntdb::Connection &conn,
         // this concat with last_insert_id may have raise condition issue but hopefully is not important
         tntdb::Statement statement;
         if (update) {
-            statement = conn.prepareCached (
+            static const DBStatementCache::query_t statement_query (
                 " INSERT INTO t_bios_asset_element "
                 " (name, id_type, id_subtype, id_parent, status, priority, asset_tag) "
                 " VALUES "
                 " (:name, :id_type, :id_subtype, :id_parent, :status, :priority, :asset_tag) "
-                " ON DUPLICATE KEY UPDATE name = :name "
-            );
+                " ON DUPLICATE KEY UPDATE name = :name ");
+            statement = DBStatementCache::prepare (conn, statement_query);
         } else {
             // @ is prohibited in name => name-@@-342 is unique
-            statement = conn.prepareCached (
+            static const DBStatementCache::query_t statement_query (
                 " INSERT INTO t_bios_asset_element "
                 " (name, id_type, id_subtype, id_parent, status, priority, asset_tag) "
                 " VALUES "
-                " (concat (:name, '-@@-', " + std::to_string (rand ())  + "), :id_type, :id_subtype, :id_parent, :status, :priority, :asset_tag) "
-            );
+                " (concat (:name, '-@@-', :suffix), :id_type, :id_subtype, :id_parent, :status, :priority, :asset_tag) ");
+            statement = DBStatementCache::prepare (conn, statement_query);
+            statement.set ("suffix", rand ());
         }
         if (parent_id == 0)
         {
@@ -744,13 +1071,21 @@ insert_into_asset_element (tntdb::Connection &conn,
 
         ret.rowid = conn.lastInsertId ();
         log_debug ("[t_bios_asset_element]: was inserted %" PRIu64 " rows", ret.affected_rows);
+        probe.rows (ret.affected_rows);
+        // 2 rows means existing element was updated, its parent is unchanged
+        if (ret.affected_rows == 1)
+            DBAssetClosure::element_inserted (conn, ret.rowid, parent_id);
+        if (ret.affected_rows != 0)
+            DBAssetGeneration::changed (conn, DBChangeNotify::ELEMENT,
+                                        ret.affected_rows == 1 ? DBChangeNotify::INSERTED : DBChangeNotify::UPDATED,
+                                        ret.rowid);
         if (! update) {
             // it is insert, fix the name
-            statement = conn.prepareCached (
+            static const DBStatementCache::query_t statement_query (
                 " UPDATE t_bios_asset_element "
                 "  set name = concat(:name, '-', :id) "
-                " WHERE id_asset_element = :id "
-            );
+                " WHERE id_asset_element = :id ");
+            statement = DBStatementCache::prepare (conn, statement_query);
             statement.set ("name", element_name).
                 set ("id", ret.rowid).
                 execute();
@@ -766,6 +1101,7 @@ insert_into_asset_element (tntdb::Connection &conn,
         return ret;
     }
     catch (const std::exception &e) {
+        probe.error ();
         LOG_END_ABNORMAL(e);
         ret.status     = 0;
         ret.errtype    = DB_ERR;
@@ -782,6 +1118,7 @@ insert_into_monitor_asset_relation (tntdb::Connection &conn,
                                     uint16_t   monitor_id,
                                     uint32_t element_id)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
     log_debug ("  monitor_id = %" PRIu32, monitor_id);
     log_debug ("  element_id = %" PRIu32, element_id);
@@ -807,13 +1144,13 @@ insert_into_monitor_asset_relation (tntdb::Connection &conn,
     log_debug ("input parameters are correct");
 
     try{
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " INSERT INTO"
             "   t_bios_monitor_asset_relation"
             "   (id_discovered_device, id_asset_element)"
             " VALUES"
-            "   (:monitor, :asset)"
-        );
+            "   (:monitor, :asset)");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         ret.affected_rows = st.set("monitor", monitor_id).
                                set("asset"  , element_id).
@@ -821,11 +1158,15 @@ insert_into_monitor_asset_relation (tntdb::Connection &conn,
         ret.rowid = conn.lastInsertId();
         log_debug ("[t_bios_monitor_asset_relation]: was inserted %"
                                         PRIu64 " rows", ret.affected_rows);
+        probe.rows (ret.affected_rows);
+        if (ret.affected_rows != 0)
+            DBAssetGeneration::bump (conn);
         ret.status = 1;
         LOG_END;
         return ret;
     }
     catch (const std::exception &e) {
+        probe.error ();
         LOG_END_ABNORMAL(e);
         ret.status     = 0;
         ret.errtype    = INTERNAL_ERR;
@@ -839,18 +1180,19 @@ insert_into_monitor_device (tntdb::Connection &conn,
                             uint16_t device_type_id,
                             const char* device_name)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
 
     db_reply_t ret = db_reply_new();
     try{
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " INSERT INTO"
             "   t_bios_discovered_device (name, id_device_type)"
             " VALUES (:name, :iddevicetype)"
             " ON DUPLICATE KEY"
             "   UPDATE"
-            "       id_discovered_device = LAST_INSERT_ID(id_discovered_device)"
-        );
+            "       id_discovered_device = LAST_INSERT_ID(id_discovered_device)");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         // Insert one row or nothing
         ret.affected_rows = st.set("name", device_name).
@@ -858,12 +1200,14 @@ insert_into_monitor_device (tntdb::Connection &conn,
                                execute();
         log_debug ("[t_bios_discovered_device]: was inserted %"
                                         PRIu64 " rows", ret.affected_rows);
+        probe.rows (ret.affected_rows);
         ret.rowid = conn.lastInsertId();
         ret.status = 1;
         LOG_END;
         return ret;
     }
     catch (const std::exception &e) {
+        probe.error ();
         LOG_END_ABNORMAL(e);
         ret.status     = 0;
         ret.errtype    = INTERNAL_ERR;
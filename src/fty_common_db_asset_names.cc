@@ -0,0 +1,400 @@
+/*  =========================================================================
+    fty_common_db_asset_names - In-process dictionary of asset names
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+
+/*
+@header
+    fty_common_db_asset_names - In-process dictionary of asset names
+@discuss
+    Name indexes are keyed by folded names, see DBSql::fold; an extended
+    name shared by more assets is not answered. Dictionary is never changed
+    by write functions: they run in the transaction of the caller, which
+    may be rolled back. The generation a caller sees tells if the dictionary
+    holds what the caller would read, uncommitted writes of the caller
+    included.
+@end
+*/
+
+#include "fty_common_db_classes.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include <assert.h>
+
+namespace DBAssetNames {
+
+// RELOAD_INTERVAL_MS: the shortest time between starts of loads, a writer
+// in a long transaction sees generations the load can't read
+static const unsigned RELOAD_INTERVAL_MS = 1000;
+
+struct s_entry_t {
+    std::string name;
+    std::string ext_name;
+    bool        has_ext;
+};
+
+static std::mutex s_mutex;
+static std::atomic <bool> s_enabled {false};
+// increased by invalidate, s_mutex
+static uint64_t s_epoch = 0;
+static bool s_loaded = false;
+// generation of asset tables the dictionary was loaded at
+static int64_t s_generation = -1;
+static std::future <void> s_loading;
+static std::chrono::steady_clock::time_point s_load_started;
+
+static std::unordered_map <uint32_t, s_entry_t> s_by_id;
+// folded name -> id
+static std::unordered_map <std::string, uint32_t> s_by_name;
+// folded extended name -> id, 0 if more assets have it
+static std::unordered_map <std::string, uint32_t> s_by_ext;
+
+static std::atomic <uint64_t> s_hits {0};
+static std::atomic <uint64_t> s_misses {0};
+static std::atomic <uint64_t> s_loads {0};
+
+// s_hit: count the lookup result and pass it through
+static bool
+s_hit (bool found)
+{
+    if (found)
+        s_hits++;
+    else
+        s_misses++;
+    return found;
+}
+
+// s_clear: drop everything, s_mutex must be held
+static void
+s_clear ()
+{
+    s_by_id.clear ();
+    s_by_name.clear ();
+    s_by_ext.clear ();
+    s_loaded = false;
+    s_generation = -1;
+}
+
+// s_install: replace the dictionary, s_mutex must be held
+static void
+s_install (const std::vector <std::tuple <uint32_t, std::string, std::string, bool>> &assets,
+           int64_t generation)
+{
+    s_clear ();
+    for (const auto &a : assets) {
+        uint32_t id = std::get <0> (a);
+        s_entry_t &entry = s_by_id [id];
+        entry.name = std::get <1> (a);
+        entry.ext_name = std::get <2> (a);
+        entry.has_ext = std::get <3> (a);
+
+        std::string key;
+        DBSql::fold (entry.name, key);
+        s_by_name [key] = id;
+        if (entry.has_ext) {
+            DBSql::fold (entry.ext_name, key);
+            auto it = s_by_ext.emplace (key, id);
+            if (!it.second)
+                it.first->second = 0;
+        }
+    }
+    s_loaded = true;
+    s_generation = generation;
+    s_loads++;
+}
+
+void
+enable (bool on)
+{
+    s_enabled = on;
+    if (!on)
+        invalidate ();
+}
+
+bool
+enabled ()
+{
+    return s_enabled;
+}
+
+void
+build (const std::vector <std::tuple <uint32_t, std::string, std::string, bool>> &assets,
+       int64_t generation)
+{
+    std::lock_guard <std::mutex> lock (s_mutex);
+    s_install (assets, generation);
+}
+
+// s_load: load the dictionary and install it if nothing was invalidated since epoch
+// returns 0 on success, -1 if error occurs
+static int
+s_load (tntdb::Connection &conn, uint64_t epoch)
+{
+    DBMETRICS_PROBE_AS (probe, "load");
+    LOG_START;
+
+    int64_t generation = -1;
+    std::vector <std::tuple <uint32_t, std::string, std::string, bool>> assets;
+    try {
+        // generation and names from one snapshot
+        tntdb::Transaction trans (conn);
+        generation = DBAssetGeneration::current (conn);
+        if (generation < 0) {
+            log_info ("end: generation of asset tables is not known, dictionary is not used");
+            return -1;
+        }
+        static const DBStatementCache::query_t st_query (
+            " SELECT"
+            "   a.id_asset_element, a.name, e.value"
+            " FROM"
+            "   t_bios_asset_element a"
+            " LEFT JOIN"
+            "   t_bios_asset_ext_attributes e"
+            " ON"
+            "   e.id_asset_element = a.id_asset_element AND"
+            "   e.keytag = 'name'");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
+
+        tntdb::Result result = st.select ();
+        log_debug ("[t_bios_asset_element]: were selected %" PRIu32 " rows", result.size ());
+        probe.rows (result.size ());
+        assets.reserve (result.size ());
+        for (const auto &row : result) {
+            uint32_t id = 0;
+            std::string name;
+            std::string ext_name;
+            row[0].get (id);
+            row[1].get (name);
+            bool has_ext = row[2].get (ext_name);
+            assets.emplace_back (id, name, ext_name, has_ext);
+        }
+        trans.commit ();
+    }
+    catch (const std::exception &e) {
+        probe.error ();
+        LOG_END_ABNORMAL(e);
+        return -1;
+    }
+
+    {
+        std::lock_guard <std::mutex> lock (s_mutex);
+        if (epoch != s_epoch) {
+            log_info ("end: dictionary was dropped while loading, it is not used");
+            return -1;
+        }
+        s_install (assets, generation);
+    }
+    LOG_END;
+    return 0;
+}
+
+int
+load (tntdb::Connection &conn)
+{
+    uint64_t epoch;
+    {
+        std::lock_guard <std::mutex> lock (s_mutex);
+        epoch = s_epoch;
+    }
+    return s_load (conn, epoch);
+}
+
+// s_start_load: load the dictionary by DBAsync executor, on connection of
+// the pool which is not in a transaction of any caller; s_mutex must be held
+static void
+s_start_load ()
+{
+    if (s_loading.valid ()) {
+        if (s_loading.wait_for (std::chrono::seconds (0)) != std::future_status::ready)
+            return;
+        if (std::chrono::steady_clock::now () - s_load_started < std::chrono::milliseconds (RELOAD_INTERVAL_MS))
+            return;
+    }
+    s_load_started = std::chrono::steady_clock::now ();
+    uint64_t epoch = s_epoch;
+    s_loading = DBAsync::executor ().try_submit ([epoch] (tntdb::Connection &conn) {
+        s_load (conn, epoch);
+    });
+}
+
+// s_current: check the dictionary is loaded at generation, start loading
+// it if it is older; s_mutex must be held
+static bool
+s_current (int64_t generation)
+{
+    if (s_loaded && s_generation == generation)
+        return true;
+    // older generation is seen by a transaction started before the load
+    if (!s_loaded || s_generation < generation)
+        s_start_load ();
+    return false;
+}
+
+void
+invalidate ()
+{
+    std::lock_guard <std::mutex> lock (s_mutex);
+    s_epoch++;
+    s_clear ();
+}
+
+// s_find: find id in index by folded text
+static bool
+s_find (const std::unordered_map <std::string, uint32_t> &index,
+        int64_t generation,
+        const std::string &text,
+        uint32_t &id)
+{
+    if (!s_enabled || generation < 0)
+        return false;
+
+    std::string key;
+    DBSql::fold (text, key);
+    std::lock_guard <std::mutex> lock (s_mutex);
+    if (!s_current (generation))
+        return s_hit (false);
+    auto it = index.find (key);
+    if (it == index.end () || it->second == 0)
+        return s_hit (false);
+    id = it->second;
+    return s_hit (true);
+}
+
+bool
+find_id (int64_t generation, const std::string &name, uint32_t &id)
+{
+    return s_find (s_by_name, generation, name, id);
+}
+
+bool
+find_id_by_extname (int64_t generation, const std::string &ext_name, uint32_t &id)
+{
+    return s_find (s_by_ext, generation, ext_name, id);
+}
+
+bool
+find_name (int64_t generation, uint32_t id, std::string &name)
+{
+    if (!s_enabled || generation < 0)
+        return false;
+
+    std::lock_guard <std::mutex> lock (s_mutex);
+    if (!s_current (generation))
+        return s_hit (false);
+    auto it = s_by_id.find (id);
+    if (it == s_by_id.end ())
+        return s_hit (false);
+    name = it->second.name;
+    return s_hit (true);
+}
+
+bool
+find_extname (int64_t generation, uint32_t id, std::string &ext_name)
+{
+    if (!s_enabled || generation < 0)
+        return false;
+
+    std::lock_guard <std::mutex> lock (s_mutex);
+    if (!s_current (generation))
+        return s_hit (false);
+    auto it = s_by_id.find (id);
+    if (it == s_by_id.end () || !it->second.has_ext)
+        return s_hit (false);
+    ext_name = it->second.ext_name;
+    return s_hit (true);
+}
+
+stats_t
+stats ()
+{
+    stats_t ret;
+    ret.hits = s_hits;
+    ret.misses = s_misses;
+    ret.loads = s_loads;
+    std::lock_guard <std::mutex> lock (s_mutex);
+    ret.entries = s_by_id.size ();
+    return ret;
+}
+
+void
+reset_stats ()
+{
+    s_hits = 0;
+    s_misses = 0;
+    s_loads = 0;
+}
+
+} // namespace
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+void
+fty_common_db_asset_names_test (bool verbose)
+{
+    printf (" * fty_common_db_asset_names: ");
+
+    uint32_t id = 0;
+    std::string name;
+
+    // disabled dictionary knows nothing
+    DBAssetNames::build ({std::make_tuple (1, "ups-1", "UPS 1", true)}, 7);
+    assert (!DBAssetNames::find_id (7, "ups-1", id));
+
+    DBAssetNames::enable (true);
+    DBAssetNames::reset_stats ();
+    DBAssetNames::build ({
+        std::make_tuple (1, "ups-1", "UPS 1", true),
+        std::make_tuple (2, "epdu-2", "", false),
+        std::make_tuple (3, "ups-3", "Shared", true),
+        std::make_tuple (4, "ups-4", "shared ", true),
+    }, 7);
+    assert (DBAssetNames::find_id (7, "ups-1", id) && id == 1);
+    assert (DBAssetNames::find_id_by_extname (7, "UPS 1", id) && id == 1);
+    assert (DBAssetNames::find_extname (7, 1, name) && name == "UPS 1");
+    assert (!DBAssetNames::find_id (7, "ups-2", id));
+    assert (!DBAssetNames::find_extname (7, 2, name));
+
+    // names are matched like the database does, returned as it stores them
+    assert (DBAssetNames::find_id (7, "UPS-1  ", id) && id == 1);
+    assert (DBAssetNames::find_id_by_extname (7, "ups 1", id) && id == 1);
+    assert (DBAssetNames::find_name (7, 1, name) && name == "ups-1");
+    // extended name of more assets
+    assert (!DBAssetNames::find_id_by_extname (7, "shared", id));
+
+    // dictionary answers only at the generation it was loaded at; writes
+    // not committed or rolled back never get into it
+    assert (!DBAssetNames::find_id (6, "ups-1", id));
+    assert (!DBAssetNames::find_id (-1, "ups-1", id));
+
+    DBAssetNames::stats_t st = DBAssetNames::stats ();
+    assert (st.hits == 6);
+    assert (st.misses == 4);
+    assert (st.loads == 1);
+    assert (st.entries == 4);
+
+    DBAssetNames::enable (false);
+    assert (DBAssetNames::stats ().entries == 0);
+    printf ("OK\n");
+}
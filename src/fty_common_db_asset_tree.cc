@@ -0,0 +1,334 @@
+/*  =========================================================================
+    fty_common_db_asset_tree - In-memory index of asset containment
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    fty_common_db_asset_tree - In-memory index of asset containment
+@discuss
+    The depth-first numbering (order of elements and [first, last) range
+    of every element in it) is computed when the index is installed, in
+    O(n). Index is never changed by write functions: they run in the
+    transaction of the caller, which may be rolled back. The generation a
+    caller sees tells if the index holds what the caller would read,
+    uncommitted writes of the caller included.
+@end
+*/
+
+#include "fty_common_db_classes.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include <assert.h>
+
+namespace DBAssetTree {
+
+// RELOAD_INTERVAL_MS: the shortest time between starts of loads, a writer
+// in a long transaction sees generations the load can't read
+static const unsigned RELOAD_INTERVAL_MS = 1000;
+
+static std::mutex s_mutex;
+static std::atomic <bool> s_enabled {false};
+// increased by invalidate, s_mutex
+static uint64_t s_epoch = 0;
+static bool s_loaded = false;
+// generation of asset tables the index was loaded at
+static int64_t s_generation = -1;
+static std::future <void> s_loading;
+static std::chrono::steady_clock::time_point s_load_started;
+
+// elements in depth-first order
+static std::vector <uint32_t> s_order;
+// id -> [first, last) of element and its descendants in s_order
+static std::unordered_map <uint32_t, std::pair <size_t, size_t>> s_ranges;
+
+// s_renumber: compute s_order and s_ranges from id -> parent id (0 = no
+// parent), s_mutex must be held
+static void
+s_renumber (const std::unordered_map <uint32_t, uint32_t> &parents)
+{
+    std::unordered_map <uint32_t, std::vector <uint32_t>> children;
+    std::vector <uint32_t> roots;
+    for (const auto &it : parents) {
+        // element with unknown parent is numbered as a root
+        if (it.second == 0 || parents.find (it.second) == parents.end ())
+            roots.push_back (it.first);
+        else
+            children [it.second].push_back (it.first);
+    }
+    std::sort (roots.begin (), roots.end ());
+    for (auto &it : children)
+        std::sort (it.second.begin (), it.second.end ());
+
+    s_order.clear ();
+    s_order.reserve (parents.size ());
+    s_ranges.clear ();
+
+    // iterative depth-first walk, stack of (element, index of next child)
+    std::vector <std::pair <uint32_t, size_t>> stack;
+    for (auto root : roots) {
+        stack.emplace_back (root, 0);
+        s_ranges [root].first = s_order.size ();
+        s_order.push_back (root);
+        while (!stack.empty ()) {
+            auto &top = stack.back ();
+            auto kids = children.find (top.first);
+            if (kids == children.end () || top.second == kids->second.size ()) {
+                s_ranges [top.first].second = s_order.size ();
+                stack.pop_back ();
+                continue;
+            }
+            uint32_t child = kids->second [top.second++];
+            stack.emplace_back (child, 0);
+            s_ranges [child].first = s_order.size ();
+            s_order.push_back (child);
+        }
+    }
+    // elements in a cycle are not reachable from any root, they are ignored
+    if (s_order.size () != parents.size ())
+        log_error ("%zu elements are not reachable from top level elements", parents.size () - s_order.size ());
+}
+
+// s_clear: drop everything, s_mutex must be held
+static void
+s_clear ()
+{
+    s_order.clear ();
+    s_ranges.clear ();
+    s_loaded = false;
+    s_generation = -1;
+}
+
+void
+enable (bool on)
+{
+    s_enabled = on;
+    if (!on)
+        invalidate ();
+}
+
+bool
+enabled ()
+{
+    return s_enabled;
+}
+
+// s_install: replace the index, s_mutex must be held
+static void
+s_install (const std::vector <std::pair <uint32_t, uint32_t>> &elements,
+           int64_t generation)
+{
+    std::unordered_map <uint32_t, uint32_t> parents;
+    for (const auto &it : elements)
+        parents [it.first] = it.second;
+    s_renumber (parents);
+    s_loaded = true;
+    s_generation = generation;
+}
+
+void
+build (const std::vector <std::pair <uint32_t, uint32_t>> &elements,
+       int64_t generation)
+{
+    std::lock_guard <std::mutex> lock (s_mutex);
+    s_install (elements, generation);
+}
+
+// s_load: load the index and install it if nothing was invalidated since epoch
+// returns 0 on success, -1 if error occurs
+static int
+s_load (tntdb::Connection &conn, uint64_t epoch)
+{
+    DBMETRICS_PROBE_AS (probe, "load");
+    LOG_START;
+
+    int64_t generation = -1;
+    std::vector <std::pair <uint32_t, uint32_t>> elements;
+    try {
+        // generation and elements from one snapshot
+        tntdb::Transaction trans (conn);
+        generation = DBAssetGeneration::current (conn);
+        if (generation < 0) {
+            log_info ("end: generation of asset tables is not known, index is not used");
+            return -1;
+        }
+        static const DBStatementCache::query_t st_query (
+            " SELECT"
+            "   id_asset_element, id_parent"
+            " FROM"
+            "   t_bios_asset_element");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
+
+        tntdb::Result result = st.select ();
+        log_debug("[t_bios_asset_element]: were selected %" PRIu32 " rows", result.size());
+        probe.rows (result.size ());
+        elements.reserve (result.size ());
+        for (const auto &row : result) {
+            uint32_t id = 0;
+            uint32_t parent_id = 0;
+            row[0].get(id);
+            row[1].get(parent_id);
+            elements.emplace_back (id, parent_id);
+        }
+        trans.commit ();
+    }
+    catch (const std::exception &e) {
+        probe.error ();
+        LOG_END_ABNORMAL(e);
+        return -1;
+    }
+
+    {
+        std::lock_guard <std::mutex> lock (s_mutex);
+        if (epoch != s_epoch) {
+            log_info ("end: index was dropped while loading, it is not used");
+            return -1;
+        }
+        s_install (elements, generation);
+    }
+    LOG_END;
+    return 0;
+}
+
+int
+load (tntdb::Connection &conn)
+{
+    uint64_t epoch;
+    {
+        std::lock_guard <std::mutex> lock (s_mutex);
+        epoch = s_epoch;
+    }
+    return s_load (conn, epoch);
+}
+
+// s_start_load: load the index by DBAsync executor, on connection of the
+// pool which is not in a transaction of any caller; s_mutex must be held
+static void
+s_start_load ()
+{
+    if (s_loading.valid ()) {
+        if (s_loading.wait_for (std::chrono::seconds (0)) != std::future_status::ready)
+            return;
+        if (std::chrono::steady_clock::now () - s_load_started < std::chrono::milliseconds (RELOAD_INTERVAL_MS))
+            return;
+    }
+    s_load_started = std::chrono::steady_clock::now ();
+    uint64_t epoch = s_epoch;
+    s_loading = DBAsync::executor ().try_submit ([epoch] (tntdb::Connection &conn) {
+        s_load (conn, epoch);
+    });
+}
+
+void
+invalidate ()
+{
+    std::lock_guard <std::mutex> lock (s_mutex);
+    s_epoch++;
+    s_clear ();
+}
+
+int
+descendants (int64_t generation,
+             uint32_t container_id,
+             std::vector <uint32_t> &out)
+{
+    if (!s_enabled || generation < 0)
+        return -1;
+
+    std::lock_guard <std::mutex> lock (s_mutex);
+    if (!s_loaded || s_generation != generation) {
+        // older generation is seen by a transaction started before the load
+        if (!s_loaded || s_generation < generation)
+            s_start_load ();
+        return -1;
+    }
+
+    out.clear ();
+    auto it = s_ranges.find (container_id);
+    if (it == s_ranges.end ())
+        return 0;
+    out.assign (s_order.begin () + it->second.first + 1,
+                s_order.begin () + it->second.second);
+    return 0;
+}
+
+int
+descendants (tntdb::Connection &conn,
+             uint32_t container_id,
+             std::vector <uint32_t> &out)
+{
+    if (!s_enabled)
+        return -1;
+    return descendants (DBAssetGeneration::current (conn), container_id, out);
+}
+
+} // namespace
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+void
+fty_common_db_asset_tree_test (bool verbose)
+{
+    printf (" * fty_common_db_asset_tree: ");
+
+    std::vector <uint32_t> out;
+    assert (DBAssetTree::descendants (7, 1, out) == -1);
+
+    DBAssetTree::enable (true);
+
+    // 1 - 2 - 3 - ... - 12 is deeper than v_bios_asset_element_super_parent
+    std::vector <std::pair <uint32_t, uint32_t>> elements;
+    elements.emplace_back (1, 0);
+    for (uint32_t id = 2; id <= 12; id++)
+        elements.emplace_back (id, id - 1);
+    elements.emplace_back (20, 0);
+    elements.emplace_back (21, 20);
+    elements.emplace_back (22, 20);
+    DBAssetTree::build (elements, 7);
+
+    assert (DBAssetTree::descendants (7, 1, out) == 0);
+    assert (out.size () == 11 && out.front () == 2 && out.back () == 12);
+    assert (DBAssetTree::descendants (7, 12, out) == 0 && out.empty ());
+    assert (DBAssetTree::descendants (7, 99, out) == 0 && out.empty ());
+    assert (DBAssetTree::descendants (7, 20, out) == 0);
+    assert ((out == std::vector <uint32_t> {21, 22}));
+
+    // children of unknown element are top level elements
+    elements [4].second = 21;
+    elements.erase (elements.begin () + 13);
+    DBAssetTree::build (elements, 8);
+    assert (DBAssetTree::descendants (8, 20, out) == 0);
+    assert ((out == std::vector <uint32_t> {22}));
+    assert (DBAssetTree::descendants (8, 5, out) == 0 && out.size () == 7);
+
+    // index answers only at the generation it was loaded at; writes not
+    // committed or rolled back never get into it
+    assert (DBAssetTree::descendants (7, 20, out) == -1);
+    assert (DBAssetTree::descendants (-1, 20, out) == -1);
+
+    DBAssetTree::enable (false);
+    assert (DBAssetTree::descendants (8, 1, out) == -1);
+    printf ("OK\n");
+}
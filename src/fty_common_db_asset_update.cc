@@ -48,6 +48,7 @@ update_asset_element (tntdb::Connection &conn,
                       const char *asset_tag,
                       int32_t &affected_rows)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
     log_debug ("  element_id = %" PRIi32, element_id);
     log_debug ("  element_name = '%s'", element_name);
@@ -59,7 +60,7 @@ update_asset_element (tntdb::Connection &conn,
     // if parent id == 0 ->  it means that there is no parent and value
     // should be updated to NULL
     try{
-        tntdb::Statement st = conn.prepareCached(
+        static const DBStatementCache::query_t st_query (
             " UPDATE"
             "   t_bios_asset_element"
             " SET"
@@ -68,8 +69,8 @@ update_asset_element (tntdb::Connection &conn,
             "   id_parent = :id_parent,"
             "   status = :status,"
             "   priority = :priority"
-            " WHERE id_asset_element = :id"
-        );
+            " WHERE id_asset_element = :id");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
         st = st.set("id", element_id).
 //                           set("name", element_name).
@@ -88,12 +89,17 @@ update_asset_element (tntdb::Connection &conn,
                                execute();
         }
         log_debug("[t_asset_element]: updated %" PRIu32 " rows", affected_rows);
+        probe.rows (affected_rows);
+        DBAssetClosure::element_moved (conn, element_id, parent_id);
+        if (affected_rows != 0)
+            DBAssetGeneration::changed (conn, DBChangeNotify::ELEMENT, DBChangeNotify::UPDATED, element_id);
         LOG_END;
         // if we are here and affected rows = 0 -> nothing was updated because
         // it was the same
         return 0;
     }
     catch (const std::exception &e) {
+        probe.error ();
         LOG_END_ABNORMAL(e);
         return ERRCODE_ABNORMAL;
     }
@@ -103,6 +109,7 @@ int
 update_asset_status_by_name (const char *element_name,
                             const char *status)
 {
+    DBMETRICS_PROBE (probe);
     LOG_START;
 
     if (!streq (status, "active") && !streq (status, "nonactive"))
@@ -111,14 +118,15 @@ update_asset_status_by_name (const char *element_name,
         return -1;
     }
 
-    tntdb::Connection conn = tntdb::connectCached(DBConn::url);
-    tntdb::Statement st = conn.prepareCached(
+    DBConn::connection_t pooled;
+    tntdb::Connection &conn = pooled.get ();
+    static const DBStatementCache::query_t st_query (
         " UPDATE"
         "   t_bios_asset_element"
         " SET"
         "   status = :status"
-        " WHERE name = :name"
-    );
+        " WHERE name = :name");
+    tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
 
     int32_t affected_rows = st.set("name", element_name).
                                set("status", status).
@@ -131,6 +139,13 @@ update_asset_status_by_name (const char *element_name,
     }
 
     log_debug("[t_asset_element]: updated %" PRIu32 " rows", affected_rows);
+    probe.rows (affected_rows);
+    if (affected_rows != 0) {
+        // name is usually cached, id 0 means unknown element
+        int64_t element_id = DBAssets::name_to_asset_id (element_name);
+        DBAssetGeneration::changed (conn, DBChangeNotify::ELEMENT, DBChangeNotify::UPDATED,
+                                    element_id > 0 ? static_cast <uint32_t> (element_id) : 0);
+    }
     LOG_END;
     return 0;
 }
@@ -0,0 +1,297 @@
+/*  =========================================================================
+    fty_common_db_async - Asynchronous execution of database requests
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    fty_common_db_async - Asynchronous execution of database requests
+@discuss
+    Cancel is checked when a worker takes the request from the queue, a
+    query already sent to the database is not interrupted. Worker holds the
+    connection of the pool only while it runs a request, so workers and
+    other threads of the process share the pool.
+@end
+*/
+
+#include "fty_common_db_classes.h"
+
+#include <assert.h>
+
+namespace DBAsync {
+
+executor_t::executor_t (size_t workers, size_t capacity) :
+    m_capacity (capacity ? capacity : 1),
+    m_stopping (false),
+    m_stats ()
+{
+    m_workers.reserve (workers);
+    for (size_t i = 0; i != workers; i++)
+        m_workers.emplace_back (&executor_t::work, this);
+}
+
+executor_t::~executor_t ()
+{
+    std::deque <task_t> queue;
+    {
+        std::lock_guard <std::mutex> lock (m_mutex);
+        m_stopping = true;
+        queue.swap (m_queue);
+        m_stats.cancelled += queue.size ();
+    }
+    m_not_empty.notify_all ();
+    m_not_full.notify_all ();
+    for (auto &task : queue)
+        task.fail (std::make_exception_ptr (cancelled ()));
+    for (auto &worker : m_workers)
+        worker.join ();
+}
+
+size_t
+executor_t::pending () const
+{
+    std::lock_guard <std::mutex> lock (m_mutex);
+    return m_queue.size ();
+}
+
+executor_stats_t
+executor_t::stats () const
+{
+    std::lock_guard <std::mutex> lock (m_mutex);
+    executor_stats_t ret = m_stats;
+    ret.pending = m_queue.size ();
+    return ret;
+}
+
+bool
+executor_t::push (task_t &task, bool wait)
+{
+    {
+        std::unique_lock <std::mutex> lock (m_mutex);
+        if (wait)
+            m_not_full.wait (lock, [this] { return m_stopping || m_queue.size () < m_capacity; });
+        if (m_stopping || m_queue.size () >= m_capacity) {
+            m_stats.rejected++;
+            return false;
+        }
+        m_queue.push_back (std::move (task));
+        m_stats.submitted++;
+        if (m_queue.size () > m_stats.max_pending)
+            m_stats.max_pending = m_queue.size ();
+    }
+    m_not_empty.notify_one ();
+    return true;
+}
+
+void
+executor_t::work ()
+{
+    while (true) {
+        task_t task;
+        {
+            std::unique_lock <std::mutex> lock (m_mutex);
+            m_not_empty.wait (lock, [this] { return m_stopping || !m_queue.empty (); });
+            if (m_queue.empty ())
+                return;
+            task = std::move (m_queue.front ());
+            m_queue.pop_front ();
+        }
+        m_not_full.notify_one ();
+
+        // counted before the future is ready, so the caller sees it
+        bool run = !task.cancel.cancelled ();
+        {
+            std::lock_guard <std::mutex> lock (m_mutex);
+            if (run)
+                m_stats.completed++;
+            else
+                m_stats.cancelled++;
+        }
+
+        if (!run) {
+            task.fail (std::make_exception_ptr (cancelled ()));
+            continue;
+        }
+        try {
+            DBConn::connection_t pooled;
+            task.run (pooled.get ());
+        }
+        catch (...) {
+            // run sets exceptions of f itself, this is the pool failing
+            task.fail (std::current_exception ());
+        }
+    }
+}
+
+executor_t &
+executor ()
+{
+    static executor_t ret;
+    return ret;
+}
+
+std::future <db_reply <db_web_basic_element_t>>
+select_asset_element_web_byId_async (uint32_t element_id, cancel_t cancel)
+{
+    return executor ().try_submit ([element_id] (tntdb::Connection &conn) {
+        return DBAssets::select_asset_element_web_byId (conn, element_id);
+    }, std::move (cancel));
+}
+
+std::future <db_reply <db_web_basic_element_t>>
+select_asset_element_web_byName_async (const std::string &element_name, cancel_t cancel)
+{
+    return executor ().try_submit ([element_name] (tntdb::Connection &conn) {
+        return DBAssets::select_asset_element_web_byName (conn, element_name.c_str ());
+    }, std::move (cancel));
+}
+
+std::future <db_reply <std::map <std::string, std::pair<std::string, bool>>>>
+select_ext_attributes_async (uint32_t element_id, cancel_t cancel)
+{
+    return executor ().try_submit ([element_id] (tntdb::Connection &conn) {
+        return DBAssets::select_ext_attributes (conn, element_id);
+    }, std::move (cancel));
+}
+
+std::future <db_reply <std::vector <db_tmp_link_t>>>
+select_asset_device_links_to_async (uint32_t element_id, uint8_t link_type_id, cancel_t cancel)
+{
+    return executor ().try_submit ([element_id, link_type_id] (tntdb::Connection &conn) {
+        return DBAssets::select_asset_device_links_to (conn, element_id, link_type_id);
+    }, std::move (cancel));
+}
+
+std::future <db_reply <std::map <uint32_t, std::string> >>
+select_asset_element_groups_async (uint32_t element_id, cancel_t cancel)
+{
+    return executor ().try_submit ([element_id] (tntdb::Connection &conn) {
+        return DBAssets::select_asset_element_groups (conn, element_id);
+    }, std::move (cancel));
+}
+
+std::future <db_reply <db_web_element_t>>
+select_web_element_full_async (uint32_t element_id, cancel_t cancel)
+{
+    return executor ().try_submit ([element_id] (tntdb::Connection &conn) {
+        return DBAssets::select_web_element_full (conn, element_id);
+    }, std::move (cancel));
+}
+
+std::future <db_reply <std::vector <db_web_element_t>>>
+select_web_elements_full_async (const std::vector <uint32_t> &ids, cancel_t cancel)
+{
+    return executor ().try_submit ([ids] (tntdb::Connection &conn) {
+        return DBAssets::select_web_elements_full (conn, ids);
+    }, std::move (cancel));
+}
+
+std::future <db_reply_t>
+insert_into_asset_ext_attributes_async (uint32_t element_id,
+                                        const std::vector <std::pair <std::string, std::string>> &attributes,
+                                        bool read_only,
+                                        cancel_t cancel)
+{
+    return executor ().try_submit ([element_id, attributes, read_only] (tntdb::Connection &conn) {
+        std::vector <size_t> affected;
+        return DBAssetsInsert::insert_into_asset_ext_attributes (conn, element_id, attributes, read_only, affected);
+    }, std::move (cancel));
+}
+
+std::future <db_reply_t>
+delete_asset_element_async (uint32_t asset_element_id, cancel_t cancel)
+{
+    return executor ().try_submit ([asset_element_id] (tntdb::Connection &conn) {
+        return DBAssetsDelete::delete_asset_element (conn, asset_element_id);
+    }, std::move (cancel));
+}
+
+} // namespace
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+void
+fty_common_db_async_test (bool verbose)
+{
+    printf (" * fty_common_db_async: ");
+
+    using namespace DBAsync;
+
+    // without workers nothing touches the database
+    std::future <int> first, second, refused;
+    std::future <void> cancelled_void;
+    {
+        executor_t e (0, 3);
+        assert (e.workers () == 0 && e.capacity () == 3);
+        cancel_t cancel;
+        first = e.try_submit ([] (tntdb::Connection&) { return 1; });
+        second = e.try_submit ([] (tntdb::Connection&) { return 2; }, cancel);
+        cancelled_void = e.try_submit ([] (tntdb::Connection&) {});
+        refused = e.try_submit ([] (tntdb::Connection&) { return 3; });
+        cancel.cancel ();
+        assert (cancel.cancelled ());
+        assert (e.pending () == 3);
+
+        // the full queue answers at once
+        assert (refused.wait_for (std::chrono::seconds (0)) == std::future_status::ready);
+        try {
+            refused.get ();
+            assert (false);
+        }
+        catch (const queue_full&) {
+        }
+
+        executor_stats_t stats = e.stats ();
+        assert (stats.submitted == 3 && stats.rejected == 1);
+        assert (stats.pending == 3 && stats.max_pending == 3);
+    }
+
+    // destructor cancels what is left in the queue
+    try {
+        first.get ();
+        assert (false);
+    }
+    catch (const cancelled&) {
+    }
+    try {
+        cancelled_void.get ();
+        assert (false);
+    }
+    catch (const cancelled&) {
+    }
+    assert (second.wait_for (std::chrono::seconds (0)) == std::future_status::ready);
+
+    // request cancelled before it starts is not run by worker
+    {
+        executor_t e (1, 1);
+        cancel_t cancel;
+        cancel.cancel ();
+        std::future <int> f = e.submit ([] (tntdb::Connection&) { return 1; }, cancel);
+        try {
+            f.get ();
+            assert (false);
+        }
+        catch (const cancelled&) {
+        }
+        assert (e.stats ().cancelled == 1);
+    }
+
+    printf ("OK\n");
+}
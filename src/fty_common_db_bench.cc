@@ -0,0 +1,462 @@
+/*  =========================================================================
+    fty_common_db_bench - Benchmark of asset functions
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    fty_common_db_bench - Benchmark of asset functions
+@discuss
+    For every requested size, generates a synthetic topology into the
+    database (datacenters, rooms, rows, racks and devices nested up to 10
+    levels deep, power chains, groups and 20-50 ext attributes per asset),
+    calls every public function of DBAssets, DBAssetsInsert, DBAssetsUpdate
+    and DBAssetsDelete over it, deletes it again and writes DBMetrics
+    collected during all of that as JSON.
+
+    Generated assets are named bench-*, the program refuses to run if such
+    asset already exists. Functions of monitor tables (insert_into_monitor_*)
+    are not called, as nothing deletes what they insert.
+
+    It writes into the database, never run it on a production system.
+@end
+*/
+
+#include "fty_common_db_classes.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+#define BENCH_PREFIX "bench-"
+
+struct s_asset_t {
+    uint32_t    id;
+    std::string name;
+    std::string ext_name;
+};
+
+struct s_topology_t {
+    // in order of creation, so parents come first
+    std::vector <s_asset_t> all;
+    std::vector <uint32_t> dcs;
+    std::vector <uint32_t> racks;
+    std::vector <uint32_t> devices;
+    std::vector <uint32_t> power;   // devices with power outlets
+    std::vector <uint32_t> groups;
+    std::vector <link_t> links;
+};
+
+static bool s_verbose = false;
+
+//  --------------------------------------------------------------------------
+//  Topology generator
+
+static uint32_t
+s_add_asset (tntdb::Connection &conn,
+             s_topology_t &topo,
+             const std::string &kind,
+             uint16_t type_id,
+             uint16_t subtype_id,
+             uint32_t parent_id)
+{
+    std::string name = BENCH_PREFIX + kind + "-" + std::to_string (topo.all.size ());
+    db_reply_t ret = DBAssetsInsert::insert_into_asset_element
+        (conn, name.c_str (), type_id, parent_id, "active", 3, subtype_id, "", true);
+    if (ret.status != 1 || ret.rowid == 0)
+        throw std::runtime_error ("can't insert " + name + ": " + ret.msg);
+
+    s_asset_t asset {static_cast <uint32_t> (ret.rowid), name, "Bench " + name};
+    topo.all.push_back (asset);
+
+    // 20 - 50 ext attributes, one of them is the extended name
+    zhash_t *attributes = zhash_new ();
+    zhash_autofree (attributes);
+    zhash_insert (attributes, "name", (void *) asset.ext_name.c_str ());
+    size_t count = 19 + rand () % 31;
+    for (size_t i = 0; i != count; i++) {
+        std::string keytag = "bench.attr." + std::to_string (i);
+        std::string value = std::to_string (rand () % 100);
+        zhash_insert (attributes, keytag.c_str (), (void *) value.c_str ());
+    }
+    std::string err;
+    ret = DBAssetsInsert::insert_into_asset_ext_attributes (conn, asset.id, attributes, false, err);
+    zhash_destroy (&attributes);
+    if (ret.status != 1)
+        throw std::runtime_error ("can't insert ext attributes of " + name + ": " + err);
+    return asset.id;
+}
+
+static void
+s_add_link (s_topology_t &topo, uint32_t src, uint32_t dest)
+{
+    topo.links.push_back (link_t {src, dest, NULL, NULL, INPUT_POWER_CHAIN});
+}
+
+// s_generate: datacenter - 2 rooms - 4 rows - 8 racks, every row has an UPS
+// fed by the feed of datacenter, every rack two ePDUs fed by the UPS, the
+// rest of devices are servers fed by ePDUs, some of them in a chain of
+// chassis nested 6 levels below the rack
+static void
+s_generate (tntdb::Connection &conn, size_t assets, s_topology_t &topo)
+{
+    const size_t rooms = 2, rows = 4, racks = 8, chain = 6;
+    const size_t containers = 1 + rooms * (1 + rows * (1 + racks));
+    size_t dcs = std::max <size_t> (1, assets / 5000);
+    size_t per_dc = assets / dcs;
+    // fewer assets than the skeleton get the minimal racks
+    size_t per_rack = std::max <size_t> (3 + chain,
+        per_dc > containers ? (per_dc - containers) / (rooms * rows * racks) : 0);
+
+    for (size_t d = 0; d != dcs; d++) {
+        uint32_t dc = s_add_asset (conn, topo, "dc", persist::asset_type::DATACENTER, persist::asset_subtype::N_A, 0);
+        topo.dcs.push_back (dc);
+        uint32_t feed = s_add_asset (conn, topo, "feed", persist::asset_type::DEVICE, persist::asset_subtype::FEED, dc);
+        topo.devices.push_back (feed);
+        topo.power.push_back (feed);
+
+        uint32_t group = s_add_asset (conn, topo, "group", persist::asset_type::GROUP, persist::asset_subtype::N_A, 0);
+        topo.groups.push_back (group);
+
+        for (size_t r = 0; r != rooms; r++) {
+            uint32_t room = s_add_asset (conn, topo, "room", persist::asset_type::ROOM, persist::asset_subtype::N_A, dc);
+            for (size_t w = 0; w != rows; w++) {
+                uint32_t row = s_add_asset (conn, topo, "row", persist::asset_type::ROW, persist::asset_subtype::N_A, room);
+                uint32_t ups = s_add_asset (conn, topo, "ups", persist::asset_type::DEVICE, persist::asset_subtype::UPS, row);
+                topo.devices.push_back (ups);
+                topo.power.push_back (ups);
+                s_add_link (topo, feed, ups);
+
+                for (size_t k = 0; k != racks; k++) {
+                    uint32_t rack = s_add_asset (conn, topo, "rack", persist::asset_type::RACK, persist::asset_subtype::N_A, row);
+                    topo.racks.push_back (rack);
+                    DBAssetsInsert::insert_asset_element_into_asset_group (conn, group, rack);
+
+                    uint32_t epdu [2];
+                    for (auto &e : epdu) {
+                        e = s_add_asset (conn, topo, "epdu", persist::asset_type::DEVICE, persist::asset_subtype::EPDU, rack);
+                        topo.devices.push_back (e);
+                        topo.power.push_back (e);
+                        s_add_link (topo, ups, e);
+                    }
+
+                    uint32_t parent = rack;
+                    for (size_t s = 0; s != per_rack - 2; s++) {
+                        bool nested = s < chain;
+                        uint32_t dev = s_add_asset (conn, topo, nested ? "chassis" : "server",
+                            persist::asset_type::DEVICE,
+                            nested ? persist::asset_subtype::N_A : persist::asset_subtype::SERVER,
+                            parent);
+                        topo.devices.push_back (dev);
+                        if (nested)
+                            parent = dev;
+                        s_add_link (topo, epdu [0], dev);
+                        s_add_link (topo, epdu [1], dev);
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector <db_reply_t> statuses;
+    db_reply_t ret = DBAssetsInsert::insert_into_asset_links (conn, topo.links, statuses);
+    if (ret.status != 1)
+        throw std::runtime_error ("can't insert power links");
+}
+
+// s_cleanup: delete everything s_generate created, children first
+static void
+s_cleanup (tntdb::Connection &conn, s_topology_t &topo)
+{
+    for (auto dev : topo.devices)
+        DBAssetsDelete::delete_asset_links_to (conn, dev);
+    for (auto group : topo.groups)
+        DBAssetsDelete::delete_asset_group_links (conn, group);
+    for (auto it = topo.all.rbegin (); it != topo.all.rend (); ++it) {
+        DBAssetsDelete::delete_asset_element_from_asset_groups (conn, it->id);
+        DBAssetsDelete::delete_monitor_asset_relation_by_a (conn, it->id);
+        DBAssetsDelete::delete_asset_ext_attributes_with_ro (conn, it->id, false);
+        DBAssetsDelete::delete_asset_ext_attributes_with_ro (conn, it->id, true);
+        db_reply_t ret = DBAssetsDelete::delete_asset_element (conn, it->id);
+        if (ret.status != 1)
+            log_error ("can't delete %s: %s", it->name.c_str (), ret.msg.c_str ());
+    }
+    topo = s_topology_t ();
+}
+
+//  --------------------------------------------------------------------------
+//  Workload
+
+// s_workload: call every public function n times, functions reading the
+// whole table n / 10 times
+static void
+s_workload (tntdb::Connection &conn, s_topology_t &topo, size_t n)
+{
+    size_t heavy = std::max <size_t> (1, n / 10);
+    size_t rows = 0;
+    std::function <void (const tntdb::Row&)> cb = [&rows] (const tntdb::Row &) { rows++; };
+
+    const auto &all = topo.all;
+    auto asset = [&all] (size_t i) -> const s_asset_t& { return all [(i * 7919) % all.size ()]; };
+    auto dev = [&topo] (size_t i) { return topo.devices [(i * 7919) % topo.devices.size ()]; };
+    auto dc = [&topo] (size_t i) { return topo.dcs [i % topo.dcs.size ()]; };
+    auto rack = [&topo] (size_t i) { return topo.racks [(i * 31) % topo.racks.size ()]; };
+
+    std::vector <std::string> names;
+    for (size_t i = 0; i != std::min <size_t> (256, all.size ()); i++)
+        names.push_back (asset (i).name);
+    std::set <uint32_t> ids;
+    for (size_t i = 0; i != std::min <size_t> (100, all.size ()); i++)
+        ids.insert (asset (i).id);
+
+    for (size_t i = 0; i != n; i++) {
+        const s_asset_t &a = asset (i);
+        std::string s;
+        uint16_t monitor_id = 0;
+        std::vector <std::string> out;
+        std::map <std::string, std::pair <std::string, bool>> ext;
+
+        DBAssets::id_to_name_ext_name (a.id);
+        DBAssets::extname_to_asset_id (a.ext_name);
+        DBAssets::name_to_extname (a.name, s);
+        DBAssets::name_to_asset_id (a.name);
+        DBAssets::name_to_asset_id_check_type (a.name, persist::asset_type::DEVICE);
+        DBAssets::extname_to_asset_name (a.ext_name, s);
+        DBAssets::select_asset_element_super_parent (conn, a.id, cb);
+        DBAssets::select_assets_by_container (conn, rack (i), {persist::asset_type::DEVICE}, {}, "", "active", cb);
+        DBAssets::select_assets_by_container (conn, rack (i), cb, "active");
+        DBAssets::select_assets_by_container (conn, rack (i), cb);
+        DBAssets::select_assets_by_container <DBAssets::container_row_view_t> (conn, rack (i),
+            [&rows] (const DBAssets::container_row_view_t &) { rows++; });
+        DBAssets::convert_asset_to_monitor (conn, a.id, monitor_id);
+        DBAssets::count_keytag (conn, "bench.attr.1", "42");
+        DBAssets::unique_keytag (conn, "name", a.ext_name, a.id);
+        DBAssets::count_of_link_src (conn, dev (i));
+        DBAssets::select_group_names (conn, rack (i), out);
+        row_cb_f row_cb = cb;
+        DBAssets::select_v_web_asset_power_link_src_byId (conn, dev (i), row_cb);
+        DBAssets::select_asset_ext_attribute_by_keytag (conn, "name", ids, cb);
+        DBAssets::select_ext_attributes (conn, a.id);
+        DBAssets::select_ext_attributes (conn, a.id, ext);
+        DBAssets::select_ext_attributes_cb (conn, a.id, cb);
+        DBAssets::select_ext_attributes_in_container <DBAssets::ext_attribute_t> (conn, rack (i),
+            [&rows] (const DBAssets::ext_attribute_t &) { rows++; });
+        DBAssets::select_asset_element_basic_cb (conn, a.name, cb);
+        DBAssets::select_monitor_device_type_id (conn, "ups");
+        DBAssets::select_asset_element_web_byId (conn, a.id);
+        DBAssets::select_asset_element_web_byName (conn, a.name.c_str ());
+        DBAssets::select_asset_device_links_to (conn, dev (i), INPUT_POWER_CHAIN);
+        DBAssets::select_asset_element_groups (conn, rack (i));
+        DBAssets::select_web_element_full (conn, a.id);
+        DBAssets::get_status_from_db_helper (a.name);
+        DBAssets::get_status_from_db (conn, a.name);
+        DBAssets::select_daisy_chain (conn, a.name);
+
+        int32_t affected_rows = 0;
+        DBAssetsUpdate::update_asset_status_by_name (a.name.c_str (), "active");
+        std::function <void (const tntdb::Row&)> parent_cb = [&] (const tntdb::Row &row) {
+            uint32_t parent_id = 0;
+            row ["id_parent"].get (parent_id);
+            DBAssetsUpdate::update_asset_element (conn, a.id, a.name.c_str (), parent_id, "active", 3, "", affected_rows);
+        };
+        DBAssets::select_asset_element_basic_cb (conn, a.name, parent_cb);
+
+        DBAssetsInsert::insert_into_asset_ext_attribute (conn, "1", "bench.extra", a.id, false);
+        std::vector <size_t> affected;
+        DBAssetsInsert::insert_into_asset_ext_attributes (conn, a.id, {{"bench.extra", "1"}, {"bench.extra.2", "2"}}, false, affected);
+        DBAssetsDelete::delete_asset_ext_attribute (conn, "bench.extra", a.id);
+        DBAssetsDelete::delete_asset_ext_attribute (conn, "bench.extra.2", a.id);
+        DBAssetsDelete::delete_asset_element_from_asset_group (conn, topo.groups [0], rack (i));
+        DBAssetsInsert::insert_element_into_groups (conn, {topo.groups [0]}, rack (i));
+    }
+
+    for (size_t i = 0; i != n && topo.power.size () > 1; i++) {
+        // relink UPS under other power device, so power chain stays the same size
+        uint32_t src = topo.power [0];
+        uint32_t dest = topo.power [1 + i % (topo.power.size () - 1)];
+        DBAssetsDelete::delete_asset_link (conn, src, dest);
+        DBAssetsInsert::insert_into_asset_link (conn, src, dest, INPUT_POWER_CHAIN, NULL, NULL);
+    }
+
+    std::map <std::string, uint32_t> found;
+    std::vector <std::string> missing;
+    for (size_t i = 0; i != heavy; i++) {
+        std::vector <std::string> out;
+        DBAssets::names_to_asset_ids (conn, names, found, missing);
+        DBAssets::select_asset_element_all_with_warranty_end (conn, cb);
+        DBAssets::select_assets_by_container_name_filter (conn, asset (0).name, {"ups", "epdu"}, out);
+        DBAssets::select_assets_by_filter (conn, {"rack"}, out);
+        DBAssets::select_assets_without_container (conn, {}, {}, cb);
+        DBAssets::select_assets_all_container (conn, {}, {}, "", "active", cb);
+        DBAssets::select_asset_element_by_dc (conn, dc (i), cb);
+        DBAssets::select_asset_element_all (conn, cb);
+        DBAssets::max_number_of_power_links (conn);
+        DBAssets::max_number_of_asset_groups (conn);
+        DBAssets::select_ext_rw_attributes_keytags (conn, cb);
+        DBAssets::select_assets_cb (conn, cb);
+        row_stream_cb_f stream_cb = [&rows] (const tntdb::Row &) { rows++; return true; };
+        DBAssets::select_assets_stream (conn, stream_cb);
+        DBAssets::select_asset_element_all_stream (conn, stream_cb);
+        DBAssets::select_assets_all_container_stream (conn, {}, {}, "", "active", stream_cb);
+        DBAssets::select_asset_element_all_with_warranty_end_stream (conn, stream_cb);
+        DBAssets::select_short_elements (conn, persist::asset_type::RACK, persist::asset_subtype::N_A);
+        DBAssets::select_asset_elements_by_type (conn, persist::asset_type::RACK, "active");
+        DBAssets::select_links_by_container (conn, dc (i), "active");
+        DBAssets::list_devices_with_status (conn, "active");
+        DBAssets::list_power_devices_with_status (conn, "active");
+        DBAssets::list_power_devices_with_status ("active");
+        DBAssets::get_active_power_devices (conn);
+        DBAssets::select_web_elements_full (conn, std::vector <uint32_t> (ids.begin (), ids.end ()));
+        std::vector <DBAssets::ext_attribute_t> attributes;
+        DBAssets::select_ext_attributes_of (conn, std::vector <uint32_t> (ids.begin (), ids.end ()), attributes);
+        DBAssets::current_generation (conn);
+        DBAssets::changes_since (conn, 0, [] (const DBChangeNotify::change_t &, uint64_t) {});
+
+        std::vector <new_link_t> new_links {new_link_t {asset (0).name, asset (1).name, NULL, NULL, INPUT_POWER_CHAIN}};
+        DBAssetsInsert::insert_into_new_asset_links (conn, new_links);
+    }
+    if (s_verbose)
+        log_info ("workload selected %zu rows", rows);
+}
+
+//  --------------------------------------------------------------------------
+//  Main
+
+static double
+s_seconds (std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration <double> (std::chrono::steady_clock::now () - start).count ();
+}
+
+static int
+s_usage (const char *program)
+{
+    printf ("%s [options] -u URL\n", program);
+    printf ("  -u/--url URL            tntdb url of a scratch database (required)\n");
+    printf ("  -s/--sizes N[,N...]     numbers of assets (default 1000,10000,100000)\n");
+    printf ("  -n/--iterations N       calls of every function (default 100)\n");
+    printf ("  -o/--output FILE        write JSON results to FILE (default stdout)\n");
+    printf ("  -v/--verbose            verbose output\n");
+    printf ("  -h/--help               this information\n");
+    return 1;
+}
+
+int
+main (int argc, char *argv [])
+{
+    std::string url;
+    std::string output;
+    std::vector <size_t> sizes;
+    size_t iterations = 100;
+
+    for (int argn = 1; argn < argc; argn++) {
+        std::string arg = argv [argn];
+        bool has_value = argn + 1 < argc;
+        if (arg == "--help" || arg == "-h")
+            return s_usage (argv [0]);
+        else if (arg == "--verbose" || arg == "-v")
+            s_verbose = true;
+        else if ((arg == "--url" || arg == "-u") && has_value)
+            url = argv [++argn];
+        else if ((arg == "--output" || arg == "-o") && has_value)
+            output = argv [++argn];
+        else if ((arg == "--iterations" || arg == "-n") && has_value)
+            iterations = std::stoul (argv [++argn]);
+        else if ((arg == "--sizes" || arg == "-s") && has_value) {
+            std::stringstream list (argv [++argn]);
+            std::string size;
+            while (std::getline (list, size, ','))
+                sizes.push_back (std::stoul (size));
+        }
+        else {
+            printf ("Unknown option: %s\n", argv [argn]);
+            return s_usage (argv [0]);
+        }
+    }
+    if (url.empty ())
+        return s_usage (argv [0]);
+    if (sizes.empty ())
+        sizes = {1000, 10000, 100000};
+
+    // functions without connection argument use DBConn::url
+    // connection of the pool, so statements are bounded and counted
+    DBConn::url = url;
+    DBConn::connection_t pooled;
+    tntdb::Connection &conn = pooled.get ();
+    if (DBAssets::name_to_asset_id (BENCH_PREFIX "dc-0") > 0) {
+        log_error ("assets of previous benchmark exist, use a clean database");
+        return 1;
+    }
+
+    std::stringstream json;
+    json << "[";
+    for (size_t i = 0; i != sizes.size (); i++) {
+        s_topology_t topo;
+        DBMetrics::reset ();
+        DBStatementCache::reset_stats ();
+        try {
+            auto start = std::chrono::steady_clock::now ();
+            s_generate (conn, sizes [i], topo);
+            double generate_s = s_seconds (start);
+            log_info ("%zu assets generated in %.1f s", topo.all.size (), generate_s);
+
+            start = std::chrono::steady_clock::now ();
+            s_workload (conn, topo, iterations);
+            double workload_s = s_seconds (start);
+            log_info ("workload done in %.1f s", workload_s);
+
+            start = std::chrono::steady_clock::now ();
+            size_t assets = topo.all.size ();
+            s_cleanup (conn, topo);
+            double cleanup_s = s_seconds (start);
+
+            DBStatementCache::stats_t statements = DBStatementCache::stats ();
+            json << (i ? "," : "")
+                 << "{\"assets\":" << assets
+                 << ",\"generate_s\":" << generate_s
+                 << ",\"workload_s\":" << workload_s
+                 << ",\"cleanup_s\":" << cleanup_s
+                 << ",\"statement_cache\":{\"hits\":" << statements.hits
+                 << ",\"misses\":" << statements.misses
+                 << ",\"evictions\":" << statements.evictions
+                 << ",\"connections\":" << statements.connections
+                 << ",\"dropped\":" << statements.dropped << "}"
+                 << ",\"functions\":" << DBMetrics::snapshot_json ()
+                 << "}";
+        }
+        catch (const std::exception &e) {
+            log_error ("benchmark of %zu assets failed: %s", sizes [i], e.what ());
+            s_cleanup (conn, topo);
+            return 1;
+        }
+    }
+    json << "]\n";
+
+    if (output.empty ())
+        std::cout << json.str ();
+    else {
+        std::ofstream file (output);
+        file << json.str ();
+        if (!file) {
+            log_error ("can't write %s", output.c_str ());
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,391 @@
+/*  =========================================================================
+    fty_common_db_change_notify - Change notifications of asset tables
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    fty_common_db_change_notify - Change notifications of asset tables
+@discuss
+    Message has three frames: TOPIC, header (instance of the publishing
+    process and sequence number of the message, 8 bytes each, big endian)
+    and changes (table, kind and id, 6 bytes per change, big endian).
+    Subscriber ignores messages of its own process. Caches of this library
+    check the generation of asset tables (see DBAssetGeneration), so they
+    do not depend on the messages; apply only drops them early.
+@end
+*/
+
+#include "fty_common_db_classes.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <assert.h>
+
+namespace DBChangeNotify {
+
+static const size_t HEADER_SIZE = 16;
+static const size_t CHANGE_SIZE = 6;
+static const int SNDHWM = 10000;
+// MAX_PENDING: changes kept for one message, more of them are published
+// as a change of unknown elements
+static const size_t MAX_PENDING = 4096;
+
+static std::mutex s_mutex;
+static std::atomic <bool> s_publishing {false};
+static zsock_t *s_pub = nullptr;
+static uint64_t s_sequence = 0;
+static thread_local batch_t *t_batch = nullptr;
+// changes recorded out of batch_t, see publish
+static thread_local std::vector <change_t> t_pending;
+
+// s_instance: random id of this process, pid is not unique across
+// containers
+static uint64_t
+s_instance ()
+{
+    static const uint64_t instance = [] {
+        std::random_device rd;
+        uint64_t r = (static_cast <uint64_t> (rd ()) << 32) | rd ();
+        return r ^ static_cast <uint64_t> (std::chrono::system_clock::now ().time_since_epoch ().count ());
+    } ();
+    return instance;
+}
+
+static void
+s_put (std::string &out, uint64_t value, size_t bytes)
+{
+    for (size_t i = bytes; i != 0; i--)
+        out.push_back (static_cast <char> ((value >> (8 * (i - 1))) & 0xff));
+}
+
+static uint64_t
+s_get (const byte *data, size_t bytes)
+{
+    uint64_t ret = 0;
+    for (size_t i = 0; i != bytes; i++)
+        ret = (ret << 8) | data [i];
+    return ret;
+}
+
+std::string
+encode (const std::vector <change_t> &changes)
+{
+    std::string ret;
+    ret.reserve (changes.size () * CHANGE_SIZE);
+    for (const auto &change : changes) {
+        s_put (ret, change.table, 1);
+        s_put (ret, change.kind, 1);
+        s_put (ret, change.id, 4);
+    }
+    return ret;
+}
+
+bool
+decode (const void *data, size_t size, std::vector <change_t> &changes)
+{
+    if (size % CHANGE_SIZE != 0)
+        return false;
+    const byte *p = static_cast <const byte*> (data);
+    size_t first = changes.size ();
+    for (const byte *end = p + size; p != end; p += CHANGE_SIZE) {
+        if (p [0] < ELEMENT || p [0] > EXT_ATTRIBUTE || p [1] < INSERTED || p [1] > DELETED) {
+            changes.resize (first);
+            return false;
+        }
+        changes.push_back (change_t {static_cast <table_t> (p [0]),
+                                     static_cast <kind_t> (p [1]),
+                                     static_cast <uint32_t> (s_get (p + 2, 4))});
+    }
+    return true;
+}
+
+// s_publish: send one message with all changes
+static void
+s_publish (const std::vector <change_t> &changes)
+{
+    if (changes.empty ())
+        return;
+    std::string data = encode (changes);
+    std::lock_guard <std::mutex> lock (s_mutex);
+    if (!s_pub)
+        return;
+    std::string header;
+    s_put (header, s_instance (), 8);
+    s_put (header, s_sequence++, 8);
+    zmsg_t *msg = zmsg_new ();
+    zmsg_addstr (msg, TOPIC);
+    zmsg_addmem (msg, header.data (), header.size ());
+    zmsg_addmem (msg, data.data (), data.size ());
+    if (zmsg_send (&msg, s_pub) != 0) {
+        // subscribers find the gap in sequence
+        log_warning ("publishing of %zu asset changes failed", changes.size ());
+        zmsg_destroy (&msg);
+    }
+}
+
+// s_add: append change, too many of them collapse into unknown elements
+static void
+s_add (std::vector <change_t> &changes, const change_t &change)
+{
+    if (changes.size () < MAX_PENDING)
+        changes.push_back (change);
+    else
+        changes.assign (1, change_t {ELEMENT, UPDATED, 0});
+}
+
+batch_t::batch_t () :
+    m_outer (t_batch)
+{
+    t_batch = this;
+}
+
+batch_t::~batch_t ()
+{
+    t_batch = m_outer;
+}
+
+void
+batch_t::commit ()
+{
+    if (m_outer) {
+        for (const auto &change : m_changes)
+            s_add (m_outer->m_changes, change);
+    }
+    else
+        s_publish (m_changes);
+    m_changes.clear ();
+}
+
+int
+start_publisher (const std::string &endpoint)
+{
+    LOG_START;
+    zsock_t *pub = zsock_new_pub (endpoint.c_str ());
+    if (!pub) {
+        log_error ("end: can't create publisher on '%s'", endpoint.c_str ());
+        return -1;
+    }
+    zsock_set_sndhwm (pub, SNDHWM);
+    {
+        std::lock_guard <std::mutex> lock (s_mutex);
+        zsock_destroy (&s_pub);
+        s_pub = pub;
+        s_publishing = true;
+    }
+    LOG_END;
+    return 0;
+}
+
+void
+stop_publisher ()
+{
+    std::lock_guard <std::mutex> lock (s_mutex);
+    s_publishing = false;
+    zsock_destroy (&s_pub);
+}
+
+bool
+publishing ()
+{
+    return s_publishing;
+}
+
+void
+changed (table_t table, kind_t kind, uint32_t id)
+{
+    if (!s_publishing)
+        return;
+    s_add (t_batch ? t_batch->m_changes : t_pending, change_t {table, kind, id});
+}
+
+void
+publish ()
+{
+    s_publish (t_pending);
+    t_pending.clear ();
+}
+
+void
+discard ()
+{
+    t_pending.clear ();
+}
+
+size_t
+pending ()
+{
+    return t_pending.size ();
+}
+
+subscriber_t::subscriber_t (const std::string &endpoints) :
+    m_sock (zsock_new_sub (endpoints.c_str (), TOPIC)),
+    m_lost (0)
+{
+    if (!m_sock)
+        throw std::runtime_error ("can't subscribe to asset changes on '" + endpoints + "'");
+}
+
+subscriber_t::~subscriber_t ()
+{
+    zsock_t *sock = static_cast <zsock_t*> (m_sock);
+    zsock_destroy (&sock);
+}
+
+int
+subscriber_t::receive (std::vector <change_t> &changes, int timeout_ms)
+{
+    zsock_set_rcvtimeo (m_sock, timeout_ms);
+    zmsg_t *msg = zmsg_recv (m_sock);
+    if (!msg)
+        return -1;
+    if (zmsg_size (msg) != 3) {
+        log_warning ("malformed message of asset changes ignored");
+        zmsg_destroy (&msg);
+        return 0;
+    }
+    char *topic = zmsg_popstr (msg);
+    zstr_free (&topic);
+    zframe_t *header = zmsg_pop (msg);
+    zframe_t *data = zmsg_pop (msg);
+    zmsg_destroy (&msg);
+
+    if (zframe_size (header) == HEADER_SIZE) {
+        uint64_t instance = s_get (zframe_data (header), 8);
+        uint64_t sequence = s_get (zframe_data (header) + 8, 8);
+        auto it = m_sequences.begin ();
+        while (it != m_sequences.end () && it->first != instance)
+            ++it;
+        bool gap = it != m_sequences.end () && sequence != it->second + 1;
+        if (it == m_sequences.end ())
+            m_sequences.emplace_back (instance, sequence);
+        else
+            it->second = sequence;
+        if (instance != s_instance ()) {
+            if (gap) {
+                m_lost++;
+                log_warning ("asset changes of publisher %" PRIx64 " were lost", instance);
+                changes.push_back (change_t {ELEMENT, UPDATED, 0});
+            }
+            if (!decode (zframe_data (data), zframe_size (data), changes))
+                log_warning ("malformed asset changes ignored");
+        }
+    }
+    else
+        log_warning ("malformed message of asset changes ignored");
+
+    zframe_destroy (&header);
+    zframe_destroy (&data);
+    return 0;
+}
+
+void
+apply (const change_t &change)
+{
+    switch (change.table) {
+        case ELEMENT:
+            // unknown elements, store would not answer until loaded again
+            if (change.id == 0)
+                DBExtStore::invalidate ();
+            break;
+        case LINK:
+        case GROUP:
+        case EXT_ATTRIBUTE:
+            // caches are validated by generation
+            break;
+    }
+}
+
+void
+apply (const std::vector <change_t> &changes)
+{
+    for (const auto &change : changes)
+        apply (change);
+}
+
+} // namespace
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+void
+fty_common_db_change_notify_test (bool verbose)
+{
+    printf (" * fty_common_db_change_notify: ");
+
+    using namespace DBChangeNotify;
+
+    std::vector <change_t> changes {
+        change_t {ELEMENT, INSERTED, 1},
+        change_t {LINK, DELETED, 0x01020304},
+        change_t {EXT_ATTRIBUTE, UPDATED, UINT32_MAX}};
+    std::string data = encode (changes);
+    assert (data.size () == 18);
+
+    std::vector <change_t> decoded {change_t {GROUP, DELETED, 7}};
+    assert (decode (data.data (), data.size (), decoded));
+    assert (decoded.size () == 4);
+    assert (decoded [0] == (change_t {GROUP, DELETED, 7}));
+    assert (std::equal (changes.begin (), changes.end (), decoded.begin () + 1));
+
+    // malformed frame does not add anything
+    assert (!decode (data.data (), data.size () - 1, decoded));
+    data [6] = 9;
+    assert (!decode (data.data (), data.size (), decoded));
+    assert (decoded.size () == 4);
+
+    // without publisher changes are not collected
+    assert (!publishing ());
+    changed (ELEMENT, UPDATED, 1);
+    assert (pending () == 0);
+
+    // changes wait until the caller says they are committed
+    assert (start_publisher ("inproc://fty-db-changes-selftest") == 0);
+    changed (ELEMENT, UPDATED, 1);
+    {
+        batch_t batch;
+        changed (ELEMENT, UPDATED, 2);
+        {
+            batch_t rolled_back;
+            changed (ELEMENT, UPDATED, 3);
+        }
+        batch.commit ();
+    }
+    assert (pending () == 1);
+    publish ();
+    assert (pending () == 0);
+    changed (ELEMENT, UPDATED, 4);
+    discard ();
+    assert (pending () == 0);
+
+    // too many changes become a change of unknown elements
+    for (uint32_t id = 1; id <= 5000; id++)
+        changed (EXT_ATTRIBUTE, UPDATED, id);
+    assert (pending () < 5000);
+    discard ();
+    stop_publisher ();
+
+    // caches are disabled, apply does not touch the database
+    apply (decoded);
+    apply (change_t {ELEMENT, DELETED, 0});
+
+    printf ("OK\n");
+}
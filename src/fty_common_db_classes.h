@@ -33,11 +33,17 @@
 #include "../include/fty_common_db.h"
 
 //  Opaque class structures to allow forward references
+#ifndef FTY_COMMON_DB_SQL_T_DEFINED
+typedef struct _fty_common_db_sql_t fty_common_db_sql_t;
+#define FTY_COMMON_DB_SQL_T_DEFINED
+#endif
 
 //  Extra headers
 
 //  Internal API
 
+#include "fty_common_db_sql.h"
+
 
 //  *** To avoid double-definitions, only define if building without draft ***
 #ifndef FTY_COMMON_DB_BUILD_DRAFT_API
@@ -0,0 +1,501 @@
+/*  =========================================================================
+    fty_common_db_connection_pool - Pool of database connections
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    fty_common_db_connection_pool - Pool of database connections
+@discuss
+    Slots of the pool are never freed while in use, a thread remembers its
+    held slot (for nested acquisitions) and its last slot (for affinity).
+    Waiting threads take a ticket and are served in ticket order.
+    Connections are opened, pinged and closed outside of the pool lock.
+@end
+*/
+
+#include "fty_common_db_classes.h"
+
+#include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace DBConn {
+
+typedef std::chrono::steady_clock steady_t;
+
+struct s_slot_t {
+    tntdb::Connection   conn;
+    std::string         url;
+    bool                busy;
+    bool                open;
+    steady_t::time_point last_used;
+};
+
+static std::mutex s_mutex;
+static std::condition_variable s_released;
+static std::list <std::unique_ptr <s_slot_t>> s_slots;
+static size_t s_size = DEFAULT_POOL_SIZE;
+static uint64_t s_next_ticket = 0;
+static uint64_t s_serving = 0;
+static pool_stats_t s_stats {0, 0, 0, 0, 0, 0, 0};
+
+static thread_local s_slot_t *t_held = nullptr;
+static thread_local unsigned t_depth = 0;
+static thread_local s_slot_t *t_last = nullptr;
+
+// s_idle_slot: idle slot, the last one of this thread if possible
+// call with s_mutex locked
+static s_slot_t *
+s_idle_slot ()
+{
+    s_slot_t *ret = nullptr;
+    for (auto &slot : s_slots) {
+        if (slot->busy)
+            continue;
+        if (slot.get () == t_last)
+            return slot.get ();
+        if (!ret)
+            ret = slot.get ();
+    }
+    return ret;
+}
+
+// s_acquire: take idle slot or reserve a new one, wait if pool is full
+static s_slot_t *
+s_acquire ()
+{
+    std::unique_lock <std::mutex> lock (s_mutex);
+    uint64_t ticket = s_next_ticket++;
+    auto start = steady_t::now ();
+    bool waited = false;
+    s_slot_t *slot = nullptr;
+    while (true) {
+        if (ticket == s_serving) {
+            slot = s_idle_slot ();
+            if (slot)
+                break;
+            if (s_slots.size () < s_size) {
+                s_slots.emplace_back (new s_slot_t {tntdb::Connection (), "", false, false, start});
+                slot = s_slots.back ().get ();
+                break;
+            }
+        }
+        waited = true;
+        s_released.wait (lock);
+    }
+    slot->busy = true;
+    s_serving++;
+    s_stats.acquired++;
+    if (waited) {
+        uint64_t us = std::chrono::duration_cast <std::chrono::microseconds> (steady_t::now () - start).count ();
+        s_stats.waits++;
+        s_stats.wait_us += us;
+        if (us > s_stats.max_wait_us)
+            s_stats.max_wait_us = us;
+    }
+    lock.unlock ();
+    // next ticket may be served by other idle slot
+    s_released.notify_all ();
+    return slot;
+}
+
+// s_release: return slot to the pool, returns the slot if it was removed
+// from the pool because the pool is over size or the slot is not open,
+// caller closes it by s_close outside of the pool lock
+static std::unique_ptr <s_slot_t>
+s_release (s_slot_t *slot)
+{
+    std::unique_ptr <s_slot_t> closed;
+    {
+        std::lock_guard <std::mutex> lock (s_mutex);
+        slot->busy = false;
+        slot->last_used = steady_t::now ();
+        if (s_slots.size () > s_size || !slot->open) {
+            for (auto it = s_slots.begin (); it != s_slots.end (); ++it) {
+                if (it->get () == slot) {
+                    closed = std::move (*it);
+                    s_slots.erase (it);
+                    break;
+                }
+            }
+            if (t_last == slot)
+                t_last = nullptr;
+        }
+    }
+    s_released.notify_all ();
+    return closed;
+}
+
+// s_close: close connection of slot removed from the pool
+static void
+s_close (std::unique_ptr <s_slot_t> slot)
+{
+    if (slot && slot->open) {
+        DBStatementCache::forget (slot->conn);
+        slot->conn.close ();
+    }
+}
+
+// s_enter: slot held by this thread, or a slot of the pool acquired for it;
+// acquired is set if the slot is new for this thread and must be checked
+static s_slot_t *
+s_enter (bool &acquired)
+{
+    acquired = !t_held;
+    if (t_held) {
+        t_depth++;
+        return t_held;
+    }
+    s_slot_t *slot = s_acquire ();
+    t_held = t_last = slot;
+    t_depth = 1;
+    return slot;
+}
+
+// s_leave: release slot of this thread when its outermost holder leaves
+// returns the slot to close, see s_release
+static std::unique_ptr <s_slot_t>
+s_leave ()
+{
+    if (--t_depth != 0)
+        return nullptr;
+    s_slot_t *slot = t_held;
+    t_held = nullptr;
+    return s_release (slot);
+}
+
+// s_check: open connection of the slot, or replace it if it is broken or
+// connected to other url, slot is held by this thread
+static void
+s_check (s_slot_t *slot)
+{
+    if (slot->open) {
+        bool idle = steady_t::now () - slot->last_used > std::chrono::seconds (HEALTH_CHECK_IDLE_S);
+        bool healthy = slot->url == url;
+        if (healthy && idle) {
+            try {
+                healthy = slot->conn.ping ();
+            }
+            catch (const std::exception &e) {
+                log_warning ("connection to database is broken: %s", e.what ());
+                healthy = false;
+            }
+        }
+        if (healthy)
+            return;
+        DBStatementCache::forget (slot->conn);
+        slot->open = false;
+        std::lock_guard <std::mutex> lock (s_mutex);
+        s_stats.reconnects++;
+    }
+    slot->url = url;
+    slot->conn = tntdb::connect (slot->url);
+    DBStatementCache::track (slot->conn);
+    slot->open = true;
+}
+
+connection_t::connection_t () :
+    m_slot (nullptr)
+{
+    bool acquired = false;
+    s_slot_t *slot = s_enter (acquired);
+    if (acquired) {
+        try {
+            s_check (slot);
+        }
+        catch (...) {
+            s_close (s_leave ());
+            throw;
+        }
+    }
+    m_slot = slot;
+}
+
+connection_t::~connection_t ()
+{
+    s_close (s_leave ());
+}
+
+tntdb::Connection &
+connection_t::get ()
+{
+    return static_cast <s_slot_t*> (m_slot)->conn;
+}
+
+void
+set_pool_size (size_t size)
+{
+    {
+        std::lock_guard <std::mutex> lock (s_mutex);
+        s_size = size > 0 ? size : 1;
+    }
+    pool_clear ();
+}
+
+size_t
+pool_size ()
+{
+    std::lock_guard <std::mutex> lock (s_mutex);
+    return s_size;
+}
+
+pool_stats_t
+pool_stats ()
+{
+    std::lock_guard <std::mutex> lock (s_mutex);
+    pool_stats_t ret = s_stats;
+    ret.size = s_slots.size ();
+    ret.busy = 0;
+    for (const auto &slot : s_slots) {
+        if (slot->busy)
+            ret.busy++;
+    }
+    return ret;
+}
+
+void
+reset_pool_stats ()
+{
+    std::lock_guard <std::mutex> lock (s_mutex);
+    s_stats.acquired = s_stats.waits = s_stats.wait_us = s_stats.max_wait_us = s_stats.reconnects = 0;
+}
+
+void
+pool_clear ()
+{
+    std::list <std::unique_ptr <s_slot_t>> closed;
+    {
+        std::lock_guard <std::mutex> lock (s_mutex);
+        for (auto it = s_slots.begin (); it != s_slots.end (); ) {
+            if ((*it)->busy)
+                ++it;
+            else {
+                closed.push_back (std::move (*it));
+                it = s_slots.erase (it);
+            }
+        }
+    }
+    for (auto &slot : closed)
+        s_close (std::move (slot));
+}
+
+// s_warm_up_thread: joined on exit, so warm-up never outlives the pool
+struct s_warm_up_thread_t {
+    std::mutex  mutex;
+    std::thread thread;
+
+    ~s_warm_up_thread_t () {
+        if (thread.joinable ())
+            thread.join ();
+    }
+};
+
+static s_warm_up_thread_t s_warm_up_thread;
+
+// s_warm_up_connection: open a connection and add it to the pool as idle
+// slot, it does not take a ticket, so it never delays threads waiting for
+// the pool; returns false if the pool filled up meanwhile
+static bool
+s_warm_up_connection ()
+{
+    std::unique_ptr <s_slot_t> slot (new s_slot_t {tntdb::Connection (), url, false, false, steady_t::now ()});
+    slot->conn = tntdb::connect (slot->url);
+    DBStatementCache::track (slot->conn);
+    slot->open = true;
+    {
+        std::lock_guard <std::mutex> lock (s_mutex);
+        if (s_slots.size () < s_size)
+            s_slots.push_back (std::move (slot));
+    }
+    if (slot) {
+        s_close (std::move (slot));
+        return false;
+    }
+    // waiting thread may take the new slot
+    s_released.notify_all ();
+    return true;
+}
+
+static void
+s_warm_up (size_t connections)
+{
+    auto start = steady_t::now ();
+    size_t missing = 0;
+    {
+        std::lock_guard <std::mutex> lock (s_mutex);
+        size_t wanted = connections ? std::min (connections, s_size) : s_size;
+        if (wanted > s_slots.size ())
+            missing = wanted - s_slots.size ();
+    }
+    std::atomic <size_t> opened {0};
+
+    std::vector <std::thread> threads;
+    for (size_t i = 0; i != missing; i++) {
+        threads.emplace_back ([&opened] () {
+            try {
+                if (s_warm_up_connection ())
+                    opened++;
+            }
+            catch (const std::exception &e) {
+                log_error ("warm-up of database connection failed: %s", e.what ());
+            }
+        });
+    }
+    for (auto &t : threads)
+        t.join ();
+    log_info ("warm-up of database connections done in %" PRIu64 " ms, %zu connections opened",
+              static_cast <uint64_t> (std::chrono::duration_cast <std::chrono::milliseconds> (steady_t::now () - start).count ()),
+              opened.load ());
+}
+
+void
+warm_up (size_t connections)
+{
+    std::lock_guard <std::mutex> lock (s_warm_up_thread.mutex);
+    if (s_warm_up_thread.thread.joinable ())
+        s_warm_up_thread.thread.join ();
+    s_warm_up_thread.thread = std::thread (s_warm_up, connections);
+}
+
+void
+warm_up_wait ()
+{
+    std::lock_guard <std::mutex> lock (s_warm_up_thread.mutex);
+    if (s_warm_up_thread.thread.joinable ())
+        s_warm_up_thread.thread.join ();
+}
+
+} // namespace
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+void
+fty_common_db_connection_pool_test (bool verbose)
+{
+    printf (" * fty_common_db_connection_pool: ");
+
+    using namespace DBConn;
+
+    // slots are taken and released by hand, s_check is never called, so
+    // nothing connects; open slots have an empty connection
+    set_pool_size (2);
+    reset_pool_stats ();
+    assert (pool_stats ().size == 0);
+
+    // nested acquisition of one thread shares its slot
+    bool acquired = false;
+    s_slot_t *a = s_enter (acquired);
+    assert (acquired);
+    a->open = true;
+    assert (s_enter (acquired) == a);
+    assert (!acquired);
+    assert (!s_leave ());
+    assert (a->busy);
+    assert (!s_leave ());
+    assert (!a->busy);
+    assert (pool_stats ().acquired == 1 && pool_stats ().size == 1);
+
+    // affinity: thread gets its last slot back, not the first idle one
+    assert (s_acquire () == a);
+    s_slot_t *b = s_enter (acquired);
+    assert (acquired && b != a);
+    b->open = true;
+    assert (!s_leave ());
+    assert (!s_release (a));
+    assert (s_enter (acquired) == b);
+    assert (!s_leave ());
+    std::thread other ([a] () {
+        bool acquired = false;
+        // other thread has no last slot, it takes the first idle one
+        assert (s_enter (acquired) == a);
+        assert (!s_leave ());
+    });
+    other.join ();
+
+    // FIFO tickets: with full pool, waiting threads are served in order
+    a = s_acquire ();
+    b = s_acquire ();
+    auto waiting = [] (uint64_t count) {
+        while (true) {
+            {
+                std::lock_guard <std::mutex> lock (s_mutex);
+                if (s_next_ticket - s_serving == count)
+                    return;
+            }
+            std::this_thread::sleep_for (std::chrono::milliseconds (1));
+        }
+    };
+    std::mutex order_mutex;
+    std::vector <int> order;
+    std::vector <std::thread> waiters;
+    for (int i = 0; i != 3; i++) {
+        waiters.emplace_back ([i, &order_mutex, &order] () {
+            s_slot_t *slot = s_acquire ();
+            {
+                std::lock_guard <std::mutex> lock (order_mutex);
+                order.push_back (i);
+            }
+            assert (!s_release (slot));
+        });
+        waiting (i + 1);
+    }
+    assert (pool_stats ().busy == 2);
+    // one slot is passed from waiter to waiter
+    assert (!s_release (a));
+    for (auto &t : waiters)
+        t.join ();
+    assert (order == std::vector <int> ({0, 1, 2}));
+    assert (!s_release (b));
+    pool_stats_t stats = pool_stats ();
+    assert (stats.waits == 3 && stats.max_wait_us <= stats.wait_us);
+    assert (stats.size == 2 && stats.busy == 0);
+
+    // release above pool size or of a slot which is not open removes it
+    a = s_acquire ();
+    b = s_acquire ();
+    {
+        std::lock_guard <std::mutex> lock (s_mutex);
+        s_size = 1;
+    }
+    std::unique_ptr <s_slot_t> closed = s_release (a);
+    assert (closed.get () == a);
+    assert (!s_release (b));
+    assert (pool_stats ().size == 1);
+    assert (s_acquire () == b);
+    b->open = false;
+    closed = s_release (b);
+    assert (closed.get () == b);
+    assert (pool_stats ().size == 0);
+
+    stats = pool_stats ();
+    assert (stats.acquired == 13);
+    reset_pool_stats ();
+    stats = pool_stats ();
+    assert (stats.acquired == 0 && stats.waits == 0 && stats.wait_us == 0);
+    set_pool_size (DEFAULT_POOL_SIZE);
+
+    printf ("OK\n");
+}
@@ -52,6 +52,12 @@ void dbpath () {
     url = s_get_dbpath();
 }
 
+void dbpath (bool warm_up) {
+    dbpath ();
+    if (warm_up)
+        DBConn::warm_up ();
+}
+
 // drop double quotes from a string
 // needed for reading of db passwd file
 // DB_USER="user" -> DB_USER=user
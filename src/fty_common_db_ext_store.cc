@@ -0,0 +1,373 @@
+/*  =========================================================================
+    fty_common_db_ext_store - Columnar in-memory store of extended attributes
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    fty_common_db_ext_store - Columnar in-memory store of extended attributes
+@discuss
+    add appends to the columns in the order attributes come, finish sorts
+    them by element (counting sort) and by keytag id inside element, so get
+    is a hash lookup of element and a binary search among its few keytags.
+    The store is never changed once finished, nor by write functions: they
+    run in the transaction of the caller, which may be rolled back. The
+    generation a caller sees tells if the store holds what the caller would
+    read, uncommitted writes of the caller included. A load in background
+    replaces the store, readers keep the old one as long as they hold it.
+@end
+*/
+
+#include "fty_common_db_classes.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <assert.h>
+
+namespace DBExtStore {
+
+void
+store_t::add (uint32_t element_id,
+              const std::string &keytag,
+              const std::string &value,
+              bool read_only)
+{
+    auto k = m_keytag_ids.emplace (keytag, static_cast <uint32_t> (m_keytags.size ()));
+    if (k.second)
+        m_keytags.push_back (keytag);
+    auto r = m_rows.emplace (element_id, static_cast <uint32_t> (m_rows.size ()));
+
+    m_added.push_back (r.first->second);
+    m_keys.push_back (k.first->second);
+    m_offsets.push_back (static_cast <uint32_t> (m_arena.size ()));
+    m_sizes.push_back (static_cast <uint32_t> (value.size ()));
+    m_read_only.push_back (read_only ? 1 : 0);
+    m_arena.append (value);
+}
+
+void
+store_t::finish ()
+{
+    // counting sort by row, keeps the order of adding inside row
+    m_first.assign (m_rows.size () + 1, 0);
+    for (auto row : m_added)
+        m_first [row + 1]++;
+    for (size_t r = 0; r != m_rows.size (); r++)
+        m_first [r + 1] += m_first [r];
+    std::vector <uint32_t> order (m_added.size ());
+    std::vector <uint32_t> next (m_first.begin (), m_first.end () - 1);
+    for (uint32_t a = 0; a != m_added.size (); a++)
+        order [next [m_added [a]]++] = a;
+
+    // sort by keytag inside row, the last added value of keytag wins
+    std::vector <uint32_t> keys, offsets, sizes;
+    std::vector <uint8_t> read_only;
+    keys.reserve (order.size ());
+    offsets.reserve (order.size ());
+    sizes.reserve (order.size ());
+    read_only.reserve (order.size ());
+    for (size_t r = 0; r != m_rows.size (); r++) {
+        auto begin = order.begin () + m_first [r];
+        auto end = order.begin () + m_first [r + 1];
+        std::stable_sort (begin, end, [this] (uint32_t a, uint32_t b) {
+            return m_keys [a] < m_keys [b];
+        });
+        m_first [r] = static_cast <uint32_t> (keys.size ());
+        for (auto it = begin; it != end; ++it) {
+            if (it + 1 != end && m_keys [*(it + 1)] == m_keys [*it])
+                continue;
+            keys.push_back (m_keys [*it]);
+            offsets.push_back (m_offsets [*it]);
+            sizes.push_back (m_sizes [*it]);
+            read_only.push_back (m_read_only [*it]);
+        }
+    }
+    m_first [m_rows.size ()] = static_cast <uint32_t> (keys.size ());
+
+    m_keys.swap (keys);
+    m_offsets.swap (offsets);
+    m_sizes.swap (sizes);
+    m_read_only.swap (read_only);
+    std::vector <uint32_t> ().swap (m_added);
+}
+
+uint32_t
+store_t::keytag_id (const std::string &keytag) const
+{
+    auto it = m_keytag_ids.find (keytag);
+    return it == m_keytag_ids.end () ? NO_KEYTAG : it->second;
+}
+
+bool
+store_t::get (uint32_t element_id,
+              uint32_t keytag_id,
+              value_t &out) const
+{
+    auto it = m_rows.find (element_id);
+    if (it == m_rows.end ())
+        return false;
+    auto begin = m_keys.begin () + m_first [it->second];
+    auto end = m_keys.begin () + m_first [it->second + 1];
+    auto k = std::lower_bound (begin, end, keytag_id);
+    if (k == end || *k != keytag_id)
+        return false;
+    out = value_at (static_cast <uint32_t> (k - m_keys.begin ()));
+    return true;
+}
+
+bool
+store_t::get (uint32_t element_id,
+              const std::string &keytag,
+              value_t &out) const
+{
+    uint32_t id = keytag_id (keytag);
+    return id != NO_KEYTAG && get (element_id, id, out);
+}
+
+// RELOAD_INTERVAL_MS: the shortest time between starts of loads, a writer
+// in a long transaction sees generations the load can't read
+static const unsigned RELOAD_INTERVAL_MS = 1000;
+
+static std::mutex s_mutex;
+static std::atomic <bool> s_enabled {false};
+// increased by invalidate, s_mutex
+static uint64_t s_epoch = 0;
+static store_ptr s_store;
+// generation of asset tables the store was loaded at
+static int64_t s_generation = -1;
+static std::future <void> s_loading;
+static std::chrono::steady_clock::time_point s_load_started;
+
+void
+enable (bool on)
+{
+    s_enabled = on;
+    if (!on)
+        invalidate ();
+}
+
+bool
+enabled ()
+{
+    return s_enabled;
+}
+
+// s_install: replace the store, s_mutex must be held
+static void
+s_install (store_ptr store, int64_t generation)
+{
+    s_store = std::move (store);
+    s_generation = generation;
+}
+
+void
+build (std::unique_ptr <store_t> store,
+       int64_t generation)
+{
+    std::lock_guard <std::mutex> lock (s_mutex);
+    s_install (store_ptr (store.release ()), generation);
+}
+
+// s_load: load the store and install it if nothing was invalidated since epoch
+// returns 0 on success, -1 if error occurs
+static int
+s_load (tntdb::Connection &conn, uint64_t epoch)
+{
+    DBMETRICS_PROBE_AS (probe, "load");
+    LOG_START;
+
+    int64_t generation = -1;
+    std::unique_ptr <store_t> store (new store_t ());
+    try {
+        // generation and attributes from one snapshot
+        tntdb::Transaction trans (conn);
+        generation = DBAssetGeneration::current (conn);
+        if (generation < 0) {
+            log_info ("end: generation of asset tables is not known, store is not used");
+            return -1;
+        }
+        static const DBStatementCache::query_t st_query (
+            " SELECT"
+            "   v.id_asset_element, v.keytag, v.value, v.read_only"
+            " FROM"
+            "   v_bios_asset_ext_attributes v");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
+
+        tntdb::Result result = st.select ();
+        log_debug ("[v_bios_asset_ext_attributes]: were selected %" PRIu32 " rows", result.size ());
+        probe.rows (result.size ());
+
+        std::string keytag;
+        std::string value;
+        for (const auto &row : result) {
+            uint32_t element_id = 0;
+            int read_only = 0;
+            row[0].get (element_id);
+            row[1].get (keytag);
+            row[2].get (value);
+            row[3].get (read_only);
+            store->add (element_id, keytag, value, read_only != 0);
+        }
+        trans.commit ();
+        store->finish ();
+    }
+    catch (const std::exception &e) {
+        probe.error ();
+        LOG_END_ABNORMAL(e);
+        return -1;
+    }
+
+    log_debug ("%zu elements, %zu attributes, %zu keytags, %zu bytes of values",
+               store->elements (), store->attributes (), store->keytags (), store->arena_size ());
+    {
+        std::lock_guard <std::mutex> lock (s_mutex);
+        if (epoch != s_epoch) {
+            log_info ("end: store was dropped while loading, it is not used");
+            return -1;
+        }
+        s_install (store_ptr (store.release ()), generation);
+    }
+    LOG_END;
+    return 0;
+}
+
+int
+load (tntdb::Connection &conn)
+{
+    uint64_t epoch;
+    {
+        std::lock_guard <std::mutex> lock (s_mutex);
+        epoch = s_epoch;
+    }
+    return s_load (conn, epoch);
+}
+
+// s_start_load: load the store by DBAsync executor, on connection of the
+// pool which is not in a transaction of any caller; s_mutex must be held
+static void
+s_start_load ()
+{
+    if (s_loading.valid ()) {
+        if (s_loading.wait_for (std::chrono::seconds (0)) != std::future_status::ready)
+            return;
+        if (std::chrono::steady_clock::now () - s_load_started < std::chrono::milliseconds (RELOAD_INTERVAL_MS))
+            return;
+    }
+    s_load_started = std::chrono::steady_clock::now ();
+    uint64_t epoch = s_epoch;
+    s_loading = DBAsync::executor ().try_submit ([epoch] (tntdb::Connection &conn) {
+        s_load (conn, epoch);
+    });
+}
+
+store_ptr
+store (int64_t generation)
+{
+    if (!s_enabled || generation < 0)
+        return store_ptr ();
+
+    std::lock_guard <std::mutex> lock (s_mutex);
+    if (!s_store || s_generation != generation) {
+        // older generation is seen by a transaction started before the load
+        if (!s_store || s_generation < generation)
+            s_start_load ();
+        return store_ptr ();
+    }
+    return s_store;
+}
+
+store_ptr
+store (tntdb::Connection &conn)
+{
+    if (!s_enabled)
+        return store_ptr ();
+    return store (DBAssetGeneration::current (conn));
+}
+
+void
+invalidate ()
+{
+    store_ptr dropped;
+    std::lock_guard <std::mutex> lock (s_mutex);
+    s_epoch++;
+    dropped.swap (s_store);
+    s_generation = -1;
+}
+
+} // namespace
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+void
+fty_common_db_ext_store_test (bool verbose)
+{
+    printf (" * fty_common_db_ext_store: ");
+
+    // store is built by hand, so nothing is loaded
+    assert (!DBExtStore::store (7));
+
+    std::unique_ptr <DBExtStore::store_t> store (new DBExtStore::store_t ());
+    store->add (2, "serial_no", "SN-2", true);
+    store->add (1, "name", "ups-1", false);
+    store->add (2, "name", "epdu-2", false);
+    store->add (1, "serial_no", "SN-1", true);
+    store->add (2, "u_size", "", false);
+    // the last value of keytag wins
+    store->add (1, "name", "UPS 1", false);
+    store->finish ();
+    assert (store->elements () == 2);
+    assert (store->attributes () == 5);
+    assert (store->keytags () == 3);
+
+    DBExtStore::enable (true);
+    DBExtStore::build (std::move (store), 7);
+    DBExtStore::store_ptr s = DBExtStore::store (7);
+    assert (s);
+
+    DBExtStore::value_t v {nullptr, 0, false};
+    assert (s->get (1, "name", v) && v.str () == "UPS 1" && !v.read_only);
+    assert (s->get (1, "serial_no", v) && v.str () == "SN-1" && v.read_only);
+    assert (s->get (2, s->keytag_id ("serial_no"), v) && v.str () == "SN-2");
+    assert (s->get (2, "u_size", v) && v.size == 0);
+    assert (!s->get (1, "u_size", v));
+    assert (!s->get (1, "no_such_keytag", v));
+    assert (!s->get (3, "name", v));
+    assert (s->keytag_id ("no_such_keytag") == DBExtStore::NO_KEYTAG);
+
+    std::vector <std::string> keytags;
+    s->each (2, [&] (uint32_t keytag_id, const DBExtStore::value_t &) {
+        keytags.push_back (s->keytag (keytag_id));
+    });
+    assert ((keytags == std::vector <std::string> {"serial_no", "name", "u_size"}));
+
+    // store answers only at the generation it was loaded at; writes not
+    // committed or rolled back never get into it
+    assert (!DBExtStore::store (6));
+    assert (!DBExtStore::store (-1));
+
+    // holder keeps the dropped store
+    DBExtStore::enable (false);
+    assert (s->get (1, "name", v) && v.str () == "UPS 1");
+    assert (!DBExtStore::store (7));
+    printf ("OK\n");
+}
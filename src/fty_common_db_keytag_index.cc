@@ -0,0 +1,383 @@
+/*  =========================================================================
+    fty_common_db_keytag_index - In-memory inverted index of unique ext attributes
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    fty_common_db_keytag_index - In-memory inverted index of unique ext attributes
+@discuss
+    The inverted map is keyed by folded keytag and value: ASCII letters in
+    lower case and trailing spaces removed, the same as the case insensitive
+    collation of the database. Collation also matches accented letters with
+    plain ones, so a keytag having any value with other than ASCII
+    characters is not answered from the index.
+    Index is never changed by write functions: they run in the transaction
+    of the caller, which may be rolled back. The generation a caller sees
+    tells if the index holds what the caller would read, uncommitted writes
+    of the caller included.
+@end
+*/
+
+#include "fty_common_db_classes.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include <assert.h>
+
+namespace DBKeytagIndex {
+
+// RELOAD_INTERVAL_MS: the shortest time between starts of loads, a writer
+// in a long transaction sees generations the load can't read
+static const unsigned RELOAD_INTERVAL_MS = 1000;
+
+static std::mutex s_mutex;
+static std::atomic <bool> s_enabled {false};
+// increased by invalidate and set_keytags, s_mutex
+static uint64_t s_epoch = 0;
+static bool s_loaded = false;
+// generation of asset tables the index was loaded at
+static int64_t s_generation = -1;
+static std::future <void> s_loading;
+static std::chrono::steady_clock::time_point s_load_started;
+
+static std::set <std::string> s_keytags = default_keytags ();
+// folded keytag '\0' folded value -> element ids
+static std::unordered_map <std::string, std::vector <uint32_t>> s_values;
+// folded keytag -> number of values with other than ASCII characters
+static std::unordered_map <std::string, size_t> s_unsafe;
+
+std::set <std::string>
+default_keytags ()
+{
+    return {"name", "serial_no", "ip.1", "ip.2", "ip.3", "ip.4", "hostname.1", "fqdn.1"};
+}
+
+// s_key: key of s_values
+// returns false if value has other than ASCII characters
+static bool
+s_key (const std::string &keytag, const std::string &value, std::string &key)
+{
+    std::string folded;
+    if (!DBSql::fold (value, folded))
+        return false;
+    key = keytag;
+    key.push_back ('\0');
+    key += folded;
+    return true;
+}
+
+// s_clear: drop everything, s_mutex must be held
+static void
+s_clear ()
+{
+    s_values.clear ();
+    s_unsafe.clear ();
+    s_loaded = false;
+    s_generation = -1;
+}
+
+// s_indexed: fold keytag and check it is indexed, s_mutex must be held
+static bool
+s_indexed (const std::string &keytag, std::string &folded)
+{
+    return DBSql::fold (keytag, folded) && s_keytags.count (folded) != 0;
+}
+
+// s_install: replace the index, s_mutex must be held
+static void
+s_install (const std::vector <std::tuple <uint32_t, std::string, std::string, bool>> &attributes,
+           int64_t generation)
+{
+    s_clear ();
+    for (const auto &a : attributes) {
+        std::string keytag;
+        if (!s_indexed (std::get <1> (a), keytag))
+            continue;
+        std::string key;
+        if (s_key (keytag, std::get <2> (a), key))
+            s_values [key].push_back (std::get <0> (a));
+        else
+            s_unsafe [keytag]++;
+    }
+    s_loaded = true;
+    s_generation = generation;
+}
+
+void
+set_keytags (const std::set <std::string> &keytags)
+{
+    std::lock_guard <std::mutex> lock (s_mutex);
+    s_epoch++;
+    s_keytags.clear ();
+    for (const auto &keytag : keytags) {
+        std::string folded;
+        if (DBSql::fold (keytag, folded))
+            s_keytags.insert (folded);
+        else
+            log_warning ("keytag '%s' is not ASCII, it is not indexed", keytag.c_str ());
+    }
+    s_clear ();
+}
+
+std::set <std::string>
+keytags ()
+{
+    std::lock_guard <std::mutex> lock (s_mutex);
+    return s_keytags;
+}
+
+void
+enable (bool on)
+{
+    s_enabled = on;
+    if (!on)
+        invalidate ();
+}
+
+bool
+enabled ()
+{
+    return s_enabled;
+}
+
+void
+build (const std::vector <std::tuple <uint32_t, std::string, std::string, bool>> &attributes,
+       int64_t generation)
+{
+    std::lock_guard <std::mutex> lock (s_mutex);
+    s_install (attributes, generation);
+}
+
+// s_load: load the index and install it if nothing was invalidated since epoch
+// returns 0 on success, -1 if error occurs
+static int
+s_load (tntdb::Connection &conn, uint64_t epoch)
+{
+    DBMETRICS_PROBE_AS (probe, "load");
+    LOG_START;
+
+    std::vector <std::string> keytags;
+    {
+        std::lock_guard <std::mutex> lock (s_mutex);
+        keytags.assign (s_keytags.begin (), s_keytags.end ());
+    }
+    int64_t generation = -1;
+    std::vector <std::tuple <uint32_t, std::string, std::string, bool>> attributes;
+    try {
+        // generation and attributes from one snapshot
+        tntdb::Transaction trans (conn);
+        generation = DBAssetGeneration::current (conn);
+        if (generation < 0) {
+            log_info ("end: generation of asset tables is not known, index is not used");
+            return -1;
+        }
+        for (size_t first = 0; first < keytags.size (); first += DBSql::MAX_IN_LIST) {
+            size_t bucket = DBSql::in_list_bucket (keytags.size () - first);
+            tntdb::Statement st = DBStatementCache::prepare (conn,
+                " SELECT"
+                "   id_asset_element, keytag, value, read_only"
+                " FROM"
+                "   t_bios_asset_ext_attributes"
+                " WHERE"
+                "   keytag IN (" + DBSql::in_list ("keytag", bucket) + ")");
+            DBSql::bind_in_list (st, "keytag", keytags, first, bucket);
+
+            tntdb::Result result = st.select ();
+            log_debug ("[t_bios_asset_ext_attributes]: were selected %" PRIu32 " rows", result.size ());
+            probe.rows (result.size ());
+            for (const auto &row : result) {
+                uint32_t element_id = 0;
+                std::string keytag;
+                std::string value;
+                int read_only = 0;
+                row[0].get (element_id);
+                row[1].get (keytag);
+                row[2].get (value);
+                row[3].get (read_only);
+                // keytag matched by collation, but not by folding
+                std::string folded;
+                if (!DBSql::fold (keytag, folded) || std::find (keytags.begin (), keytags.end (), folded) == keytags.end ()) {
+                    log_info ("end: keytag '%s' can't be indexed, index is not used", keytag.c_str ());
+                    return -1;
+                }
+                attributes.emplace_back (element_id, keytag, value, read_only != 0);
+            }
+        }
+        trans.commit ();
+    }
+    catch (const std::exception &e) {
+        probe.error ();
+        LOG_END_ABNORMAL(e);
+        return -1;
+    }
+
+    {
+        std::lock_guard <std::mutex> lock (s_mutex);
+        // keytags were changed or index dropped in the meantime
+        if (epoch != s_epoch) {
+            log_info ("end: index was dropped while loading, it is not used");
+            return -1;
+        }
+        s_install (attributes, generation);
+    }
+    LOG_END;
+    return 0;
+}
+
+int
+load (tntdb::Connection &conn)
+{
+    uint64_t epoch;
+    {
+        std::lock_guard <std::mutex> lock (s_mutex);
+        epoch = s_epoch;
+    }
+    return s_load (conn, epoch);
+}
+
+// s_start_load: load the index by DBAsync executor, on connection of the
+// pool which is not in a transaction of any caller; s_mutex must be held
+static void
+s_start_load ()
+{
+    if (s_loading.valid ()) {
+        if (s_loading.wait_for (std::chrono::seconds (0)) != std::future_status::ready)
+            return;
+        if (std::chrono::steady_clock::now () - s_load_started < std::chrono::milliseconds (RELOAD_INTERVAL_MS))
+            return;
+    }
+    s_load_started = std::chrono::steady_clock::now ();
+    uint64_t epoch = s_epoch;
+    s_loading = DBAsync::executor ().try_submit ([epoch] (tntdb::Connection &conn) {
+        s_load (conn, epoch);
+    });
+}
+
+void
+invalidate ()
+{
+    std::lock_guard <std::mutex> lock (s_mutex);
+    s_epoch++;
+    s_clear ();
+}
+
+int
+find (int64_t generation,
+      const std::string &keytag,
+      const std::string &value,
+      std::vector <uint32_t> &out)
+{
+    if (!s_enabled || generation < 0)
+        return -1;
+
+    std::lock_guard <std::mutex> lock (s_mutex);
+    std::string folded;
+    std::string key;
+    if (!s_indexed (keytag, folded) || !s_key (folded, value, key))
+        return -1;
+    if (!s_loaded || s_generation != generation) {
+        // older generation is seen by a transaction started before the load
+        if (!s_loaded || s_generation < generation)
+            s_start_load ();
+        return -1;
+    }
+    if (s_unsafe.count (folded) != 0)
+        return -1;
+
+    auto it = s_values.find (key);
+    if (it == s_values.end ())
+        out.clear ();
+    else
+        out = it->second;
+    return 0;
+}
+
+int
+find (tntdb::Connection &conn,
+      const std::string &keytag,
+      const std::string &value,
+      std::vector <uint32_t> &out)
+{
+    if (!s_enabled)
+        return -1;
+    {
+        std::lock_guard <std::mutex> lock (s_mutex);
+        std::string folded;
+        if (!s_indexed (keytag, folded))
+            return -1;
+    }
+    return find (DBAssetGeneration::current (conn), keytag, value, out);
+}
+
+} // namespace
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+void
+fty_common_db_keytag_index_test (bool verbose)
+{
+    printf (" * fty_common_db_keytag_index: ");
+
+    // index is built by hand, so the connection is never used
+    tntdb::Connection conn;
+    std::vector <uint32_t> out;
+    assert (DBKeytagIndex::find (conn, "name", "ups-1", out) == -1);
+
+    DBKeytagIndex::enable (true);
+    DBKeytagIndex::build ({
+        std::make_tuple (1, "name", "UPS 1", false),
+        std::make_tuple (1, "serial_no", "SN-1", true),
+        std::make_tuple (2, "name", "ePDU 2", false),
+        std::make_tuple (2, "u_size", "1", false),
+        std::make_tuple (3, "name", "ups 1 ", false),
+        std::make_tuple (4, "serial_no", "caf\xc3\xa9", false),
+    }, 7);
+
+    // case and trailing spaces do not matter
+    assert (DBKeytagIndex::find (7, "name", "ups 1", out) == 0);
+    assert ((out == std::vector <uint32_t> {1, 3}));
+    assert (DBKeytagIndex::find (7, "Name", "EPDU 2", out) == 0);
+    assert ((out == std::vector <uint32_t> {2}));
+    assert (DBKeytagIndex::find (7, "name", "no such", out) == 0 && out.empty ());
+    // not indexed or not ASCII
+    assert (DBKeytagIndex::find (7, "u_size", "1", out) == -1);
+    assert (DBKeytagIndex::find (7, "name", "\xc3\xa9", out) == -1);
+    // value which is not ASCII makes keytag unsafe
+    assert (DBKeytagIndex::find (7, "serial_no", "sn-1", out) == -1);
+
+    // index answers only at the generation it was loaded at; writes not
+    // committed or rolled back never get into it
+    assert (DBKeytagIndex::find (6, "name", "ups 1", out) == -1);
+    assert (DBKeytagIndex::find (-1, "name", "ups 1", out) == -1);
+
+    DBKeytagIndex::set_keytags ({"asset_tag"});
+    assert (DBKeytagIndex::keytags () == std::set <std::string> {"asset_tag"});
+    assert (DBKeytagIndex::find (7, "name", "ups 1", out) == -1);
+    DBKeytagIndex::set_keytags (DBKeytagIndex::default_keytags ());
+
+    DBKeytagIndex::enable (false);
+    assert (DBKeytagIndex::find (7, "name", "ups 1", out) == -1);
+    printf ("OK\n");
+}
@@ -0,0 +1,221 @@
+/*  =========================================================================
+    fty_common_db_metrics - Per-function call metrics
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    fty_common_db_metrics - Per-function call metrics
+@discuss
+    Counters of functions form a singly linked list, new counters are
+    pushed to its head by compare-and-swap, so neither registration nor
+    recording takes a lock.
+@end
+*/
+
+#include "fty_common_db_classes.h"
+
+#include <cxxtools/jsonserializer.h>
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <assert.h>
+
+namespace DBMetrics {
+
+static std::atomic <bool> s_enabled {true};
+static std::atomic <counters_t*> s_head {nullptr};
+
+counters_t::counters_t (const char *name_) :
+    name (name_),
+    next (nullptr),
+    calls (0),
+    errors (0),
+    rows (0),
+    total_us (0)
+{
+    for (auto &l : latency)
+        l = 0;
+    next = s_head.load ();
+    while (!s_head.compare_exchange_weak (next, this))
+        ;
+}
+
+probe_t::probe_t (counters_t &counters) :
+    m_counters (counters),
+    m_on (s_enabled),
+    m_error (false),
+    m_rows (0)
+{
+    if (m_on)
+        m_start = std::chrono::steady_clock::now ();
+}
+
+probe_t::~probe_t ()
+{
+    if (!m_on)
+        return;
+    uint64_t us = std::chrono::duration_cast <std::chrono::microseconds>
+        (std::chrono::steady_clock::now () - m_start).count ();
+    m_counters.calls.fetch_add (1, std::memory_order_relaxed);
+    if (m_error)
+        m_counters.errors.fetch_add (1, std::memory_order_relaxed);
+    if (m_rows)
+        m_counters.rows.fetch_add (m_rows, std::memory_order_relaxed);
+    m_counters.total_us.fetch_add (us, std::memory_order_relaxed);
+    m_counters.latency [bucket (us)].fetch_add (1, std::memory_order_relaxed);
+}
+
+void
+enable (bool on)
+{
+    s_enabled = on;
+}
+
+bool
+enabled ()
+{
+    return s_enabled;
+}
+
+size_t
+bucket (uint64_t us)
+{
+    if (us == 0)
+        return 0;
+    size_t b = 64 - __builtin_clzll (us);
+    return b < BUCKETS ? b : BUCKETS - 1;
+}
+
+std::vector <function_stats_t>
+snapshot ()
+{
+    std::map <std::string, function_stats_t> by_name;
+    for (counters_t *c = s_head.load (); c; c = c->next) {
+        uint64_t calls = c->calls.load (std::memory_order_relaxed);
+        if (calls == 0)
+            continue;
+        auto it = by_name.find (c->name);
+        if (it == by_name.end ()) {
+            function_stats_t st;
+            st.name = c->name;
+            st.calls = st.errors = st.rows = st.total_us = 0;
+            std::fill (st.latency, st.latency + BUCKETS, 0);
+            it = by_name.emplace (c->name, st).first;
+        }
+        function_stats_t &st = it->second;
+        st.calls += calls;
+        st.errors += c->errors.load (std::memory_order_relaxed);
+        st.rows += c->rows.load (std::memory_order_relaxed);
+        st.total_us += c->total_us.load (std::memory_order_relaxed);
+        for (size_t i = 0; i != BUCKETS; i++)
+            st.latency [i] += c->latency [i].load (std::memory_order_relaxed);
+    }
+
+    std::vector <function_stats_t> ret;
+    ret.reserve (by_name.size ());
+    for (const auto &it : by_name)
+        ret.push_back (it.second);
+    return ret;
+}
+
+void
+operator<<= (cxxtools::SerializationInfo &si, const function_stats_t &st)
+{
+    si.addMember ("name") <<= st.name;
+    si.addMember ("calls") <<= st.calls;
+    si.addMember ("errors") <<= st.errors;
+    si.addMember ("rows") <<= st.rows;
+    si.addMember ("total_us") <<= st.total_us;
+    si.addMember ("latency") <<= std::vector <uint64_t> (st.latency, st.latency + BUCKETS);
+}
+
+std::string
+snapshot_json ()
+{
+    std::stringstream output;
+    cxxtools::JsonSerializer serializer (output);
+    serializer.serialize (snapshot ()).finish ();
+    return output.str ();
+}
+
+void
+reset ()
+{
+    for (counters_t *c = s_head.load (); c; c = c->next) {
+        c->calls = 0;
+        c->errors = 0;
+        c->rows = 0;
+        c->total_us = 0;
+        for (auto &l : c->latency)
+            l = 0;
+    }
+}
+
+} // namespace
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+static void
+s_metrics_test_call (bool fail)
+{
+    DBMETRICS_PROBE (probe);
+    probe.rows (3);
+    if (fail)
+        probe.error ();
+}
+
+void
+fty_common_db_metrics_test (bool verbose)
+{
+    printf (" * fty_common_db_metrics: ");
+
+    assert (DBMetrics::bucket (0) == 0);
+    assert (DBMetrics::bucket (1) == 1);
+    assert (DBMetrics::bucket (3) == 2);
+    assert (DBMetrics::bucket (1024) == 11);
+    assert (DBMetrics::bucket (UINT64_MAX) == DBMetrics::BUCKETS - 1);
+
+    DBMetrics::reset ();
+    s_metrics_test_call (false);
+    s_metrics_test_call (true);
+    DBMetrics::enable (false);
+    s_metrics_test_call (false);
+    DBMetrics::enable (true);
+
+    bool found = false;
+    for (const auto &st : DBMetrics::snapshot ()) {
+        if (st.name != "s_metrics_test_call")
+            continue;
+        found = true;
+        assert (st.calls == 2);
+        assert (st.errors == 1);
+        assert (st.rows == 6);
+        uint64_t sum = 0;
+        for (auto l : st.latency)
+            sum += l;
+        assert (sum == 2);
+    }
+    assert (found);
+
+    DBMetrics::reset ();
+    assert (DBMetrics::snapshot ().empty ());
+    printf ("OK\n");
+}
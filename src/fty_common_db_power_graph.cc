@@ -0,0 +1,504 @@
+/*  =========================================================================
+    fty_common_db_power_graph - In-memory graph of power links
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    fty_common_db_power_graph - In-memory graph of power links
+@discuss
+    Both adjacency arrays are computed from the list of links when the
+    graph is installed, in O(devices + links). Graph is never changed by
+    write functions: they run in the transaction of the caller, which may
+    be rolled back. The generation a caller sees tells if the graph holds
+    what the caller would read, uncommitted writes of the caller included.
+@end
+*/
+
+#include "fty_common_db_classes.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include <assert.h>
+
+namespace DBPowerGraph {
+
+// RELOAD_INTERVAL_MS: the shortest time between starts of loads, a writer
+// in a long transaction sees generations the load can't read
+static const unsigned RELOAD_INTERVAL_MS = 1000;
+
+static std::mutex s_mutex;
+static std::atomic <bool> s_enabled {false};
+// increased by invalidate, s_mutex
+static uint64_t s_epoch = 0;
+static bool s_loaded = false;
+// generation of asset tables the graph was loaded at
+static int64_t s_generation = -1;
+static std::future <void> s_loading;
+static std::chrono::steady_clock::time_point s_load_started;
+
+static std::vector <db_tmp_link_t> s_links;
+
+// device id -> node, node -> device id
+static std::unordered_map <uint32_t, uint32_t> s_nodes;
+static std::vector <uint32_t> s_ids;
+// links of node n are s_out_links [s_out_first [n] .. s_out_first [n + 1])
+static std::vector <uint32_t> s_out_first;
+static std::vector <uint32_t> s_out_links;
+static std::vector <uint32_t> s_in_first;
+static std::vector <uint32_t> s_in_links;
+// src and dest node of every link
+static std::vector <uint32_t> s_src;
+static std::vector <uint32_t> s_dest;
+
+// s_node: node of device id, added if not known yet
+static uint32_t
+s_node (uint32_t id)
+{
+    auto it = s_nodes.find (id);
+    if (it != s_nodes.end ())
+        return it->second;
+    uint32_t node = static_cast <uint32_t> (s_ids.size ());
+    s_nodes.emplace (id, node);
+    s_ids.push_back (id);
+    return node;
+}
+
+// s_fill: counting sort of links by key node into first/links arrays
+static void
+s_fill (const std::vector <uint32_t> &key,
+        std::vector <uint32_t> &first,
+        std::vector <uint32_t> &links)
+{
+    first.assign (s_ids.size () + 1, 0);
+    for (auto node : key)
+        first [node + 1]++;
+    for (size_t n = 0; n != s_ids.size (); n++)
+        first [n + 1] += first [n];
+
+    links.resize (key.size ());
+    std::vector <uint32_t> next (first.begin (), first.end () - 1);
+    for (uint32_t l = 0; l != key.size (); l++)
+        links [next [key [l]]++] = l;
+}
+
+// s_rebuild: recompute adjacency arrays from s_links, s_mutex must be held
+static void
+s_rebuild ()
+{
+    s_nodes.clear ();
+    s_ids.clear ();
+    s_src.resize (s_links.size ());
+    s_dest.resize (s_links.size ());
+    for (size_t l = 0; l != s_links.size (); l++) {
+        s_src [l] = s_node (s_links [l].src_id);
+        s_dest [l] = s_node (s_links [l].dest_id);
+    }
+    s_fill (s_src, s_out_first, s_out_links);
+    s_fill (s_dest, s_in_first, s_in_links);
+}
+
+// s_clear: drop everything, s_mutex must be held
+static void
+s_clear ()
+{
+    s_links.clear ();
+    s_nodes.clear ();
+    s_ids.clear ();
+    s_out_first.clear ();
+    s_out_links.clear ();
+    s_in_first.clear ();
+    s_in_links.clear ();
+    s_src.clear ();
+    s_dest.clear ();
+    s_loaded = false;
+    s_generation = -1;
+}
+
+// s_walk: breadth first search from device, s_mutex must be held
+static void
+s_walk (uint32_t device_id,
+        uint32_t depth,
+        bool up,
+        std::vector <uint32_t> &out)
+{
+    out.clear ();
+    auto it = s_nodes.find (device_id);
+    if (it == s_nodes.end ())
+        return;
+
+    const std::vector <uint32_t> &first = up ? s_in_first : s_out_first;
+    const std::vector <uint32_t> &links = up ? s_in_links : s_out_links;
+    const std::vector <uint32_t> &next = up ? s_src : s_dest;
+
+    std::vector <bool> seen (s_ids.size (), false);
+    std::vector <uint32_t> queue {it->second};
+    seen [it->second] = true;
+    // nodes of current hop are queue [begin, end)
+    size_t begin = 0;
+    for (uint32_t hop = 1; begin != queue.size () && (depth == 0 || hop <= depth); hop++) {
+        size_t end = queue.size ();
+        for (; begin != end; begin++) {
+            uint32_t node = queue [begin];
+            for (uint32_t i = first [node]; i != first [node + 1]; i++) {
+                uint32_t n = next [links [i]];
+                if (seen [n])
+                    continue;
+                seen [n] = true;
+                queue.push_back (n);
+                out.push_back (s_ids [n]);
+            }
+        }
+    }
+}
+
+void
+enable (bool on)
+{
+    s_enabled = on;
+    if (!on)
+        invalidate ();
+}
+
+bool
+enabled ()
+{
+    return s_enabled;
+}
+
+// s_install: replace the graph, s_mutex must be held
+static void
+s_install (std::vector <db_tmp_link_t> links, int64_t generation)
+{
+    s_clear ();
+    s_links = std::move (links);
+    s_rebuild ();
+    s_loaded = true;
+    s_generation = generation;
+}
+
+void
+build (const std::vector <db_tmp_link_t> &links,
+       int64_t generation)
+{
+    std::lock_guard <std::mutex> lock (s_mutex);
+    s_install (links, generation);
+}
+
+// s_load: load the graph and install it if nothing was invalidated since epoch
+// returns 0 on success, -1 if error occurs
+static int
+s_load (tntdb::Connection &conn, uint64_t epoch)
+{
+    DBMETRICS_PROBE_AS (probe, "load");
+    LOG_START;
+
+    int64_t generation = -1;
+    std::vector <db_tmp_link_t> links;
+    try {
+        // generation and links from one snapshot
+        tntdb::Transaction trans (conn);
+        generation = DBAssetGeneration::current (conn);
+        if (generation < 0) {
+            log_info ("end: generation of asset tables is not known, graph is not used");
+            return -1;
+        }
+        static const DBStatementCache::query_t st_query (
+            " SELECT"
+            "   v.id_asset_element_src, v.id_asset_element_dest,"
+            "   v.src_out, v.dest_in, v.src_name"
+            " FROM"
+            "   v_web_asset_link v"
+            " WHERE"
+            "   v.id_asset_link_type = :idlinktype");
+        tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
+
+        tntdb::Result result = st.set ("idlinktype", INPUT_POWER_CHAIN).
+                                  select ();
+        log_debug("[v_web_asset_link]: were selected %" PRIu32 " rows", result.size());
+        probe.rows (result.size ());
+        links.reserve (result.size ());
+        for (const auto &row : result) {
+            db_tmp_link_t link {0, 0, "", "", ""};
+            row[0].get(link.src_id);
+            row[1].get(link.dest_id);
+            row[2].get(link.src_socket);
+            row[3].get(link.dest_socket);
+            row[4].get(link.src_name);
+            links.push_back (link);
+        }
+        trans.commit ();
+    }
+    catch (const std::exception &e) {
+        probe.error ();
+        LOG_END_ABNORMAL(e);
+        return -1;
+    }
+
+    {
+        std::lock_guard <std::mutex> lock (s_mutex);
+        if (epoch != s_epoch) {
+            log_info ("end: graph was dropped while loading, it is not used");
+            return -1;
+        }
+        s_install (std::move (links), generation);
+    }
+    LOG_END;
+    return 0;
+}
+
+int
+load (tntdb::Connection &conn)
+{
+    uint64_t epoch;
+    {
+        std::lock_guard <std::mutex> lock (s_mutex);
+        epoch = s_epoch;
+    }
+    return s_load (conn, epoch);
+}
+
+// s_start_load: load the graph by DBAsync executor, on connection of the
+// pool which is not in a transaction of any caller; s_mutex must be held
+static void
+s_start_load ()
+{
+    if (s_loading.valid ()) {
+        if (s_loading.wait_for (std::chrono::seconds (0)) != std::future_status::ready)
+            return;
+        if (std::chrono::steady_clock::now () - s_load_started < std::chrono::milliseconds (RELOAD_INTERVAL_MS))
+            return;
+    }
+    s_load_started = std::chrono::steady_clock::now ();
+    uint64_t epoch = s_epoch;
+    s_loading = DBAsync::executor ().try_submit ([epoch] (tntdb::Connection &conn) {
+        s_load (conn, epoch);
+    });
+}
+
+// s_ready: lock the graph if it was loaded at generation, start loading
+// it in background if it is older
+// returns false if graph can't be used
+static bool
+s_ready (int64_t generation, std::unique_lock <std::mutex> &lock)
+{
+    if (!s_enabled || generation < 0)
+        return false;
+
+    lock = std::unique_lock <std::mutex> (s_mutex);
+    if (!s_loaded || s_generation != generation) {
+        // older generation is seen by a transaction started before the load
+        if (!s_loaded || s_generation < generation)
+            s_start_load ();
+        return false;
+    }
+    return true;
+}
+
+void
+invalidate ()
+{
+    std::lock_guard <std::mutex> lock (s_mutex);
+    s_epoch++;
+    s_clear ();
+}
+
+// s_generation_of: generation conn sees, the database is not asked if
+// the graph is disabled
+static int64_t
+s_generation_of (tntdb::Connection &conn)
+{
+    return s_enabled ? DBAssetGeneration::current (conn) : -1;
+}
+
+int
+upstream (int64_t generation,
+          uint32_t device_id,
+          uint32_t depth,
+          std::vector <uint32_t> &out)
+{
+    std::unique_lock <std::mutex> lock;
+    if (!s_ready (generation, lock))
+        return -1;
+    s_walk (device_id, depth, true, out);
+    return 0;
+}
+
+int
+upstream (tntdb::Connection &conn,
+          uint32_t device_id,
+          uint32_t depth,
+          std::vector <uint32_t> &out)
+{
+    return upstream (s_generation_of (conn), device_id, depth, out);
+}
+
+int
+downstream (int64_t generation,
+            uint32_t device_id,
+            uint32_t depth,
+            std::vector <uint32_t> &out)
+{
+    std::unique_lock <std::mutex> lock;
+    if (!s_ready (generation, lock))
+        return -1;
+    s_walk (device_id, depth, false, out);
+    return 0;
+}
+
+int
+downstream (tntdb::Connection &conn,
+            uint32_t device_id,
+            uint32_t depth,
+            std::vector <uint32_t> &out)
+{
+    return downstream (s_generation_of (conn), device_id, depth, out);
+}
+
+int
+feeds (int64_t generation,
+       uint32_t src_id,
+       uint32_t dest_id,
+       bool &result)
+{
+    std::vector <uint32_t> fed;
+    if (downstream (generation, src_id, 0, fed) != 0)
+        return -1;
+    result = std::find (fed.begin (), fed.end (), dest_id) != fed.end ();
+    return 0;
+}
+
+int
+feeds (tntdb::Connection &conn,
+       uint32_t src_id,
+       uint32_t dest_id,
+       bool &result)
+{
+    return feeds (s_generation_of (conn), src_id, dest_id, result);
+}
+
+// s_links_of: links of device in one direction
+static int
+s_links_of (int64_t generation,
+            uint32_t device_id,
+            bool to,
+            std::vector <db_tmp_link_t> &out)
+{
+    std::unique_lock <std::mutex> lock;
+    if (!s_ready (generation, lock))
+        return -1;
+
+    out.clear ();
+    auto it = s_nodes.find (device_id);
+    if (it == s_nodes.end ())
+        return 0;
+    const std::vector <uint32_t> &first = to ? s_in_first : s_out_first;
+    const std::vector <uint32_t> &links = to ? s_in_links : s_out_links;
+    for (uint32_t i = first [it->second]; i != first [it->second + 1]; i++)
+        out.push_back (s_links [links [i]]);
+    return 0;
+}
+
+int
+links_to (int64_t generation,
+          uint32_t device_id,
+          std::vector <db_tmp_link_t> &out)
+{
+    return s_links_of (generation, device_id, true, out);
+}
+
+int
+links_to (tntdb::Connection &conn,
+          uint32_t device_id,
+          std::vector <db_tmp_link_t> &out)
+{
+    return s_links_of (s_generation_of (conn), device_id, true, out);
+}
+
+int
+links_from (int64_t generation,
+            uint32_t device_id,
+            std::vector <db_tmp_link_t> &out)
+{
+    return s_links_of (generation, device_id, false, out);
+}
+
+int
+links_from (tntdb::Connection &conn,
+            uint32_t device_id,
+            std::vector <db_tmp_link_t> &out)
+{
+    return s_links_of (s_generation_of (conn), device_id, false, out);
+}
+
+} // namespace
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+void
+fty_common_db_power_graph_test (bool verbose)
+{
+    printf (" * fty_common_db_power_graph: ");
+
+    std::vector <uint32_t> out;
+    assert (DBPowerGraph::upstream (7, 1, 0, out) == -1);
+
+    //  feed 1 -> ups 2 -> pdu 3 -> server 5
+    //  feed 1 -> ups 2 -> pdu 4 -> server 5
+    DBPowerGraph::enable (true);
+    DBPowerGraph::build ({
+        {1, 2, "feed-1", "", ""},
+        {2, 3, "ups-2", "1", ""},
+        {2, 4, "ups-2", "2", ""},
+        {3, 5, "pdu-3", "A1", "PSU1"},
+        {4, 5, "pdu-4", "B1", "PSU2"},
+    }, 7);
+
+    assert (DBPowerGraph::upstream (7, 5, 1, out) == 0);
+    assert ((out == std::vector <uint32_t> {3, 4}));
+    assert (DBPowerGraph::upstream (7, 5, 0, out) == 0);
+    assert ((out == std::vector <uint32_t> {3, 4, 2, 1}));
+    assert (DBPowerGraph::downstream (7, 2, 0, out) == 0);
+    assert ((out == std::vector <uint32_t> {3, 4, 5}));
+    assert (DBPowerGraph::downstream (7, 5, 0, out) == 0 && out.empty ());
+    assert (DBPowerGraph::downstream (7, 99, 0, out) == 0 && out.empty ());
+
+    bool result = false;
+    assert (DBPowerGraph::feeds (7, 1, 5, result) == 0 && result);
+    assert (DBPowerGraph::feeds (7, 5, 1, result) == 0 && !result);
+
+    std::vector <db_tmp_link_t> links;
+    assert (DBPowerGraph::links_to (7, 5, links) == 0 && links.size () == 2);
+    assert (links [0].src_id == 3 && links [0].src_socket == "A1" && links [0].dest_socket == "PSU1");
+    assert (DBPowerGraph::links_from (7, 5, links) == 0 && links.empty ());
+
+    // graph answers only at the generation it was loaded at; writes not
+    // committed or rolled back never get into it
+    assert (DBPowerGraph::upstream (6, 5, 0, out) == -1);
+    assert (DBPowerGraph::upstream (-1, 5, 0, out) == -1);
+
+    DBPowerGraph::enable (false);
+    assert (DBPowerGraph::upstream (7, 5, 0, out) == -1);
+    printf ("OK\n");
+}
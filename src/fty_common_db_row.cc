@@ -0,0 +1,99 @@
+/*  =========================================================================
+    fty_common_db_row - Typed decoding of result rows
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    fty_common_db_row - Typed decoding of result rows
+@discuss
+    Header only, this file holds the self test.
+@end
+*/
+
+#include "fty_common_db_classes.h"
+
+#include <assert.h>
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+// row with tntdb::Row interface used by decode, NULL is empty string
+struct s_test_value_t {
+    const char *value;
+
+    bool
+    get (std::string &out) const
+    {
+        if (!*value)
+            return false;
+        out = value;
+        return true;
+    }
+
+    bool
+    get (uint32_t &out) const
+    {
+        if (!*value)
+            return false;
+        out = std::stoul (value);
+        return true;
+    }
+};
+
+struct s_test_row_t {
+    std::vector <const char *> values;
+
+    s_test_value_t
+    operator[] (size_t i) const
+    {
+        return s_test_value_t {values.at (i)};
+    }
+};
+
+struct s_test_view_t {
+    uint32_t    id;
+    std::string name;
+
+    typedef DBRow::fields <
+        DBROW_FIELD (2, s_test_view_t, id),
+        DBROW_FIELD (0, s_test_view_t, name)> fields;
+};
+
+void
+fty_common_db_row_test (bool verbose)
+{
+    printf (" * fty_common_db_row: ");
+
+    static_assert (s_test_view_t::fields::columns == 3, "highest bound column is 2");
+    static_assert (DBRow::fields <>::columns == 0, "no column bound");
+
+    s_test_view_t view = s_test_view_t ();
+    DBRow::decode (s_test_row_t {{"rack-1", "ignored", "42"}}, view);
+    assert (view.id == 42);
+    assert (view.name == "rack-1");
+
+    // NULL keeps the value
+    view = s_test_view_t ();
+    DBRow::decode (s_test_row_t {{"", "ignored", "7"}}, view);
+    assert (view.id == 7);
+    assert (view.name.empty ());
+
+    printf ("OK\n");
+}
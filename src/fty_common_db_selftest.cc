@@ -41,6 +41,17 @@ static test_item_t
 all_tests [] = {
 // Tests for stable public classes:
     { "fty_common_db_asset", fty_common_db_asset_test, true, true, NULL },
+    { "fty_common_db_asset_names", fty_common_db_asset_names_test, true, true, NULL },
+    { "fty_common_db_asset_tree", fty_common_db_asset_tree_test, true, true, NULL },
+    { "fty_common_db_power_graph", fty_common_db_power_graph_test, true, true, NULL },
+    { "fty_common_db_metrics", fty_common_db_metrics_test, true, true, NULL },
+    { "fty_common_db_row", fty_common_db_row_test, true, true, NULL },
+    { "fty_common_db_statement_cache", fty_common_db_statement_cache_test, true, true, NULL },
+    { "fty_common_db_ext_store", fty_common_db_ext_store_test, true, true, NULL },
+    { "fty_common_db_keytag_index", fty_common_db_keytag_index_test, true, true, NULL },
+    { "fty_common_db_change_notify", fty_common_db_change_notify_test, true, true, NULL },
+    { "fty_common_db_snapshot", fty_common_db_snapshot_test, true, true, NULL },
+    { "fty_common_db_async", fty_common_db_async_test, true, true, NULL },
     {NULL, NULL, 0, 0, NULL}          //  Sentinel
 };
 
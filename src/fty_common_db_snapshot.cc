@@ -0,0 +1,711 @@
+/*  =========================================================================
+    fty_common_db_snapshot - Memory mapped snapshot of asset tables
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    fty_common_db_snapshot - Memory mapped snapshot of asset tables
+@discuss
+    save collects rows in s_builder_t, which sorts them into sections and
+    writes the file next to the target, then renames it. open checks every
+    reference of the file once, so the lookups need no bounds checks.
+@end
+*/
+
+#include "fty_common_db_classes.h"
+
+#include <algorithm>
+#include <ctime>
+#include <unordered_map>
+#include <assert.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace DBSnapshot {
+
+static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+static_assert (sizeof (header_t) == 32 + SECTIONS * sizeof (section_t), "header_t is padded");
+static_assert (sizeof (element_t) == 60, "element_t is padded");
+static_assert (sizeof (attribute_t) == 12, "attribute_t is padded");
+static_assert (sizeof (link_t) == 16, "link_t is padded");
+
+// s_builder_t: rows of the snapshot before they are written
+class s_builder_t {
+    public:
+        s_builder_t () : m_strings (1, '\0') {}
+
+        uint32_t
+        intern (const std::string &s)
+        {
+            if (s.empty ())
+                return 0;
+            auto it = m_refs.emplace (s, static_cast <uint32_t> (m_strings.size ()));
+            if (it.second) {
+                m_strings.append (s);
+                m_strings.push_back ('\0');
+            }
+            return it.first->second;
+        }
+
+        void
+        add_element (uint32_t id,
+                     const std::string &name,
+                     uint16_t type_id,
+                     const std::string &type_name,
+                     uint16_t subtype_id,
+                     const std::string &subtype_name,
+                     uint32_t parent_id,
+                     const std::string &status,
+                     uint16_t priority,
+                     const std::string &asset_tag)
+        {
+            element_t e;
+            memset (&e, 0, sizeof (e));
+            e.id = id;
+            e.name = intern (name);
+            e.type_name = intern (type_name);
+            e.subtype_name = intern (subtype_name);
+            e.status = intern (status);
+            e.asset_tag = intern (asset_tag);
+            e.parent_id = parent_id;
+            e.type_id = type_id;
+            e.subtype_id = subtype_id;
+            e.priority = priority;
+            m_elements.push_back (e);
+        }
+
+        void
+        add_attribute (uint32_t element_id,
+                       const std::string &keytag,
+                       const std::string &value,
+                       bool read_only)
+        {
+            m_attributes.emplace_back (element_id, attribute_t {intern (keytag), intern (value), read_only ? 1u : 0u});
+        }
+
+        void
+        add_link (uint32_t dest_id,
+                  uint32_t src_id,
+                  const std::string &src_out,
+                  const std::string &dest_in,
+                  uint32_t type)
+        {
+            m_links.emplace_back (dest_id, link_t {src_id, intern (src_out), intern (dest_in), type});
+        }
+
+        void
+        add_group (uint32_t element_id, uint32_t group_id)
+        {
+            m_groups.emplace_back (element_id, group_id);
+        }
+
+        // write: sort rows into sections and write them to path
+        // returns 0 on success, -1 if error occurs
+        int
+        write (const std::string &path, int64_t generation);
+
+    private:
+        // sort_rows: order rows by element, set ranges of elements
+        template <typename T>
+        std::vector <T>
+        sort_rows (std::vector <std::pair <uint32_t, T>> &rows,
+                   uint32_t element_t::*first,
+                   uint32_t element_t::*count);
+
+        std::string m_strings;
+        std::unordered_map <std::string, uint32_t> m_refs;
+        std::vector <element_t> m_elements;
+        std::vector <std::pair <uint32_t, attribute_t>> m_attributes;
+        std::vector <std::pair <uint32_t, link_t>> m_links;
+        std::vector <std::pair <uint32_t, uint32_t>> m_groups;
+};
+
+template <typename T>
+std::vector <T>
+s_builder_t::sort_rows (std::vector <std::pair <uint32_t, T>> &rows,
+                        uint32_t element_t::*first,
+                        uint32_t element_t::*count)
+{
+    std::stable_sort (rows.begin (), rows.end (),
+        [] (const std::pair <uint32_t, T> &a, const std::pair <uint32_t, T> &b) {
+            return a.first < b.first;
+        });
+    std::vector <T> ret;
+    ret.reserve (rows.size ());
+    auto row = rows.begin ();
+    for (auto &e : m_elements) {
+        // rows of elements which are not in the snapshot are dropped
+        while (row != rows.end () && row->first < e.id)
+            ++row;
+        e.*first = static_cast <uint32_t> (ret.size ());
+        for (; row != rows.end () && row->first == e.id; ++row)
+            ret.push_back (row->second);
+        e.*count = static_cast <uint32_t> (ret.size ()) - e.*first;
+    }
+    return ret;
+}
+
+static bool
+s_write_section (FILE *f, const void *data, size_t size, section_t &section, uint64_t count)
+{
+    static const char padding [8] = {0};
+    long pos = ftell (f);
+    if (pos < 0)
+        return false;
+    size_t pad = (8 - pos % 8) % 8;
+    if (pad != 0 && fwrite (padding, 1, pad, f) != pad)
+        return false;
+    section.offset = static_cast <uint64_t> (pos) + pad;
+    section.count = count;
+    return size == 0 || fwrite (data, 1, size, f) == size;
+}
+
+int
+s_builder_t::write (const std::string &path, int64_t generation)
+{
+    // v_web_element may return more rows of one element, the first one is
+    // kept like select_web_element_full does
+    std::stable_sort (m_elements.begin (), m_elements.end (),
+        [] (const element_t &a, const element_t &b) { return a.id < b.id; });
+    m_elements.erase (std::unique (m_elements.begin (), m_elements.end (),
+        [] (const element_t &a, const element_t &b) { return a.id == b.id; }), m_elements.end ());
+    std::vector <attribute_t> attributes = sort_rows (m_attributes, &element_t::first_attribute, &element_t::attributes);
+    std::vector <link_t> links = sort_rows (m_links, &element_t::first_link, &element_t::links);
+    std::vector <uint32_t> groups = sort_rows (m_groups, &element_t::first_group, &element_t::groups);
+
+    std::vector <std::string> folded (m_elements.size ());
+    std::vector <uint32_t> names (m_elements.size ());
+    for (uint32_t i = 0; i != names.size (); i++) {
+        DBSql::fold (m_strings.c_str () + m_elements [i].name, folded [i]);
+        names [i] = i;
+    }
+    std::sort (names.begin (), names.end (), [&folded] (uint32_t a, uint32_t b) {
+        return folded [a] < folded [b];
+    });
+
+    header_t header;
+    memset (&header, 0, sizeof (header));
+    memcpy (header.magic, MAGIC, sizeof (MAGIC));
+    header.version = FORMAT_VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.generation = generation;
+    header.created = static_cast <uint64_t> (time (NULL));
+
+    std::string tmp = path + ".tmp";
+    FILE *f = fopen (tmp.c_str (), "wb");
+    if (!f) {
+        log_error ("can't create %s: %s", tmp.c_str (), strerror (errno));
+        return -1;
+    }
+    bool ok = fwrite (&header, sizeof (header), 1, f) == 1 &&
+        s_write_section (f, m_strings.data (), m_strings.size (), header.sections [STRINGS], m_strings.size ()) &&
+        s_write_section (f, m_elements.data (), m_elements.size () * sizeof (element_t), header.sections [ELEMENTS], m_elements.size ()) &&
+        s_write_section (f, attributes.data (), attributes.size () * sizeof (attribute_t), header.sections [ATTRIBUTES], attributes.size ()) &&
+        s_write_section (f, links.data (), links.size () * sizeof (link_t), header.sections [LINKS], links.size ()) &&
+        s_write_section (f, groups.data (), groups.size () * sizeof (uint32_t), header.sections [GROUPS], groups.size ()) &&
+        s_write_section (f, names.data (), names.size () * sizeof (uint32_t), header.sections [NAMES], names.size ()) &&
+        // header again, now with sections
+        fseek (f, 0, SEEK_SET) == 0 &&
+        fwrite (&header, sizeof (header), 1, f) == 1 &&
+        fflush (f) == 0 &&
+        fsync (fileno (f)) == 0;
+    if (fclose (f) != 0)
+        ok = false;
+    if (!ok || rename (tmp.c_str (), path.c_str ()) != 0) {
+        log_error ("can't write %s: %s", path.c_str (), strerror (errno));
+        unlink (tmp.c_str ());
+        return -1;
+    }
+    log_debug ("snapshot %s: %zu elements, %zu attributes, %zu links, %zu group relations, %zu bytes of strings",
+               path.c_str (), m_elements.size (), attributes.size (), links.size (), groups.size (), m_strings.size ());
+    return 0;
+}
+
+int
+save (tntdb::Connection &conn,
+      const std::string &path)
+{
+    DBMETRICS_PROBE (probe);
+    LOG_START;
+
+    s_builder_t builder;
+    int64_t generation = -1;
+    try {
+        // all reads see the same state of the database
+        tntdb::Transaction trans (conn);
+        generation = DBAssetGeneration::current (conn);
+
+        static const DBStatementCache::query_t st_elements_query (
+            " SELECT"
+            "   v.id, v.name, v.id_type, v.type_name, v.subtype_id, v.subtype_name,"
+            "   v.id_parent, v.status, v.priority, v.asset_tag"
+            " FROM"
+            "   v_web_element v");
+        tntdb::Result result = DBStatementCache::prepare (conn, st_elements_query).select ();
+        log_debug ("[v_web_element]: were selected %" PRIu32 " rows", result.size ());
+        probe.rows (result.size ());
+        for (const auto &row : result) {
+            uint32_t id = 0, parent_id = 0;
+            uint16_t type_id = 0, subtype_id = 0, priority = 0;
+            std::string name, type_name, subtype_name, status, asset_tag;
+            row[0].get (id);
+            row[1].get (name);
+            row[2].get (type_id);
+            row[3].get (type_name);
+            row[4].get (subtype_id);
+            row[5].get (subtype_name);
+            row[6].get (parent_id);
+            row[7].get (status);
+            row[8].get (priority);
+            row[9].get (asset_tag);
+            builder.add_element (id, name, type_id, type_name, subtype_id, subtype_name,
+                                 parent_id, status, priority, asset_tag);
+        }
+
+        static const DBStatementCache::query_t st_attributes_query (
+            " SELECT"
+            "   a.id_asset_element, a.keytag, a.value, a.read_only"
+            " FROM"
+            "   v_bios_asset_ext_attributes a");
+        result = DBStatementCache::prepare (conn, st_attributes_query).select ();
+        log_debug ("[v_bios_asset_ext_attributes]: were selected %" PRIu32 " rows", result.size ());
+        probe.rows (result.size ());
+        for (const auto &row : result) {
+            uint32_t element_id = 0;
+            int read_only = 0;
+            std::string keytag, value;
+            row[0].get (element_id);
+            row[1].get (keytag);
+            row[2].get (value);
+            row[3].get (read_only);
+            builder.add_attribute (element_id, keytag, value, read_only != 0);
+        }
+
+        static const DBStatementCache::query_t st_links_query (
+            " SELECT"
+            "   l.id_asset_element_dest, l.id_asset_element_src,"
+            "   l.src_out, l.dest_in, l.id_asset_link_type"
+            " FROM"
+            "   v_web_asset_link l");
+        result = DBStatementCache::prepare (conn, st_links_query).select ();
+        log_debug ("[v_web_asset_link]: were selected %" PRIu32 " rows", result.size ());
+        probe.rows (result.size ());
+        for (const auto &row : result) {
+            uint32_t dest_id = 0, src_id = 0, type = 0;
+            std::string src_out, dest_in;
+            row[0].get (dest_id);
+            row[1].get (src_id);
+            row[2].get (src_out);
+            row[3].get (dest_in);
+            row[4].get (type);
+            builder.add_link (dest_id, src_id, src_out, dest_in, type);
+        }
+
+        static const DBStatementCache::query_t st_groups_query (
+            " SELECT"
+            "   g.id_asset_element, g.id_asset_group"
+            " FROM"
+            "   v_bios_asset_group_relation g");
+        result = DBStatementCache::prepare (conn, st_groups_query).select ();
+        log_debug ("[v_bios_asset_group_relation]: were selected %" PRIu32 " rows", result.size ());
+        probe.rows (result.size ());
+        for (const auto &row : result) {
+            uint32_t element_id = 0, group_id = 0;
+            row[0].get (element_id);
+            row[1].get (group_id);
+            builder.add_group (element_id, group_id);
+        }
+        trans.commit ();
+    }
+    catch (const std::exception &e) {
+        probe.error ();
+        LOG_END_ABNORMAL(e);
+        return -1;
+    }
+
+    if (builder.write (path, generation) != 0) {
+        probe.error ();
+        log_error ("end: snapshot was not saved");
+        return -1;
+    }
+    LOG_END;
+    return 0;
+}
+
+snapshot_t::snapshot_t () :
+    m_map (nullptr),
+    m_size (0),
+    m_header (nullptr),
+    m_strings (nullptr),
+    m_elements (nullptr),
+    m_attributes (nullptr),
+    m_links (nullptr),
+    m_groups (nullptr),
+    m_names (nullptr)
+{
+}
+
+snapshot_t::~snapshot_t ()
+{
+    close ();
+}
+
+void
+snapshot_t::close ()
+{
+    if (m_map)
+        munmap (m_map, m_size);
+    m_map = nullptr;
+    m_size = 0;
+    m_header = nullptr;
+}
+
+// s_section_ok: section of count records of size lies in the file
+static bool
+s_section_ok (const section_t &section, size_t record, size_t size)
+{
+    return section.offset % 8 == 0 &&
+           section.offset <= size &&
+           section.count <= (size - section.offset) / record;
+}
+
+int
+snapshot_t::check (size_t size)
+{
+    const header_t *h = static_cast <const header_t*> (m_map);
+    if (size < sizeof (header_t) ||
+        memcmp (h->magic, MAGIC, sizeof (MAGIC)) != 0 ||
+        h->version != FORMAT_VERSION ||
+        h->byte_order != BYTE_ORDER_MARK)
+        return -1;
+    static const size_t records [SECTIONS] = {1, sizeof (element_t), sizeof (attribute_t),
+                                              sizeof (link_t), sizeof (uint32_t), sizeof (uint32_t)};
+    for (size_t s = 0; s != SECTIONS; s++) {
+        if (!s_section_ok (h->sections [s], records [s], size))
+            return -1;
+    }
+    const char *base = static_cast <const char*> (m_map);
+    const uint64_t strings = h->sections [STRINGS].count;
+    const uint64_t elements = h->sections [ELEMENTS].count;
+    m_strings = base + h->sections [STRINGS].offset;
+    m_elements = reinterpret_cast <const element_t*> (base + h->sections [ELEMENTS].offset);
+    m_attributes = reinterpret_cast <const attribute_t*> (base + h->sections [ATTRIBUTES].offset);
+    m_links = reinterpret_cast <const link_t*> (base + h->sections [LINKS].offset);
+    m_groups = reinterpret_cast <const uint32_t*> (base + h->sections [GROUPS].offset);
+    m_names = reinterpret_cast <const uint32_t*> (base + h->sections [NAMES].offset);
+
+    if (strings == 0 || m_strings [0] != '\0' || m_strings [strings - 1] != '\0')
+        return -1;
+    auto range_ok = [&] (uint32_t first, uint32_t count, section_id_t s) {
+        return static_cast <uint64_t> (first) + count <= h->sections [s].count;
+    };
+    for (uint64_t i = 0; i != elements; i++) {
+        const element_t &e = m_elements [i];
+        if ((i != 0 && m_elements [i - 1].id >= e.id) ||
+            e.name >= strings || e.type_name >= strings || e.subtype_name >= strings ||
+            e.status >= strings || e.asset_tag >= strings ||
+            !range_ok (e.first_attribute, e.attributes, ATTRIBUTES) ||
+            !range_ok (e.first_link, e.links, LINKS) ||
+            !range_ok (e.first_group, e.groups, GROUPS))
+            return -1;
+    }
+    for (uint64_t i = 0; i != h->sections [ATTRIBUTES].count; i++) {
+        if (m_attributes [i].keytag >= strings || m_attributes [i].value >= strings)
+            return -1;
+    }
+    for (uint64_t i = 0; i != h->sections [LINKS].count; i++) {
+        if (m_links [i].src_out >= strings || m_links [i].dest_in >= strings)
+            return -1;
+    }
+    if (h->sections [NAMES].count != elements)
+        return -1;
+    for (uint64_t i = 0; i != elements; i++) {
+        if (m_names [i] >= elements)
+            return -1;
+    }
+    m_header = h;
+    return 0;
+}
+
+int
+snapshot_t::open (const std::string &path)
+{
+    LOG_START;
+    close ();
+    int fd = ::open (path.c_str (), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        log_error ("end: can't open %s: %s", path.c_str (), strerror (errno));
+        return -1;
+    }
+    struct stat st;
+    if (fstat (fd, &st) != 0 || st.st_size == 0) {
+        log_error ("end: can't map empty %s", path.c_str ());
+        ::close (fd);
+        return -1;
+    }
+    void *map = mmap (nullptr, static_cast <size_t> (st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close (fd);
+    if (map == MAP_FAILED) {
+        log_error ("end: can't map %s: %s", path.c_str (), strerror (errno));
+        return -1;
+    }
+    m_map = map;
+    m_size = static_cast <size_t> (st.st_size);
+    if (check (m_size) != 0) {
+        log_error ("end: %s is not a valid snapshot", path.c_str ());
+        close ();
+        return -1;
+    }
+    log_debug ("snapshot %s of generation %" PRIi64 ": %zu elements", path.c_str (), generation (), elements ());
+    LOG_END;
+    return 0;
+}
+
+const element_t *
+snapshot_t::element (uint32_t id) const
+{
+    const element_t *end = m_elements + elements ();
+    const element_t *e = std::lower_bound (m_elements, end, id,
+        [] (const element_t &a, uint32_t b) { return a.id < b; });
+    return e != end && e->id == id ? e : nullptr;
+}
+
+// s_compare: compare name folded by DBSql::fold with folded key, without
+// copying the name
+static int
+s_compare (const char *name, const std::string &key)
+{
+    size_t n = strlen (name);
+    while (n != 0 && name [n - 1] == ' ')
+        n--;
+    for (size_t i = 0; i != n && i != key.size (); i++) {
+        unsigned char c = name [i] >= 'A' && name [i] <= 'Z' ? name [i] - 'A' + 'a' : name [i];
+        unsigned char k = key [i];
+        if (c != k)
+            return c < k ? -1 : 1;
+    }
+    return n < key.size () ? -1 : (n > key.size () ? 1 : 0);
+}
+
+const element_t *
+snapshot_t::element_by_name (const std::string &name) const
+{
+    std::string key;
+    DBSql::fold (name, key);
+    const uint32_t *end = m_names + elements ();
+    const uint32_t *n = std::lower_bound (m_names, end, key,
+        [this] (uint32_t a, const std::string &key) { return s_compare (str (m_elements [a].name), key) < 0; });
+    return n != end && s_compare (str (m_elements [*n].name), key) == 0 ? &m_elements [*n] : nullptr;
+}
+
+int64_t
+snapshot_t::name_to_asset_id (const std::string &asset_name) const
+{
+    const element_t *e = element_by_name (asset_name);
+    return e ? static_cast <int64_t> (e->id) : -1;
+}
+
+std::pair <std::string, std::string>
+snapshot_t::id_to_name_ext_name (uint32_t asset_id) const
+{
+    const element_t *e = element (asset_id);
+    if (e) {
+        for (uint32_t a = e->first_attribute; a != e->first_attribute + e->attributes; a++) {
+            if (streq (str (m_attributes [a].keytag), "name"))
+                return std::make_pair (std::string (str (e->name)), std::string (str (m_attributes [a].value)));
+        }
+    }
+    return std::make_pair (std::string (), std::string ());
+}
+
+db_reply <db_web_basic_element_t>
+snapshot_t::select_asset_element_web_byId (uint32_t element_id) const
+{
+    db_web_basic_element_t item {0, "", "", 0, 0, "", 0, 0, 0, "", "", ""};
+    db_reply <db_web_basic_element_t> ret = db_reply_new(item);
+
+    const element_t *e = element (element_id);
+    if (!e) {
+        ret.status        = 0;
+        ret.errtype       = DB_ERR;
+        ret.errsubtype    = DB_ERROR_NOTFOUND;
+        ret.msg           = TRANSLATE_ME ("element with specified id was not found");
+        return ret;
+    }
+    ret.item.id = e->id;
+    ret.item.name = str (e->name);
+    ret.item.status = str (e->status);
+    ret.item.priority = e->priority;
+    ret.item.type_id = e->type_id;
+    ret.item.type_name = str (e->type_name);
+    ret.item.parent_id = e->parent_id;
+    ret.item.subtype_id = e->subtype_id;
+    ret.item.subtype_name = str (e->subtype_name);
+    ret.item.asset_tag = str (e->asset_tag);
+    const element_t *parent = e->parent_id ? element (e->parent_id) : nullptr;
+    if (parent) {
+        ret.item.parent_type_id = parent->type_id;
+        ret.item.parent_name = str (parent->name);
+    }
+    return ret;
+}
+
+db_reply <std::map <std::string, std::pair<std::string, bool>>>
+snapshot_t::select_ext_attributes (uint32_t element_id) const
+{
+    std::map <std::string, std::pair<std::string, bool> > item{};
+    db_reply <std::map <std::string, std::pair<std::string, bool> > > ret = db_reply_new(item);
+
+    const element_t *e = element (element_id);
+    if (e) {
+        for (uint32_t a = e->first_attribute; a != e->first_attribute + e->attributes; a++) {
+            const attribute_t &attribute = m_attributes [a];
+            ret.item [str (attribute.keytag)] = std::make_pair (std::string (str (attribute.value)),
+                                                                attribute.read_only != 0);
+        }
+    }
+    return ret;
+}
+
+db_reply <std::vector <db_tmp_link_t>>
+snapshot_t::select_asset_device_links_to (uint32_t element_id,
+                                          uint8_t link_type_id) const
+{
+    std::vector <db_tmp_link_t> item{};
+    db_reply <std::vector <db_tmp_link_t>> ret = db_reply_new(item);
+
+    const element_t *e = element (element_id);
+    if (e) {
+        for (uint32_t l = e->first_link; l != e->first_link + e->links; l++) {
+            const link_t &link = m_links [l];
+            if (link.type != link_type_id)
+                continue;
+            const element_t *src = element (link.src);
+            ret.item.push_back (db_tmp_link_t {link.src, element_id,
+                                               src ? str (src->name) : "",
+                                               str (link.src_out), str (link.dest_in)});
+        }
+    }
+    return ret;
+}
+
+db_reply <std::map <uint32_t, std::string> >
+snapshot_t::select_asset_element_groups (uint32_t element_id) const
+{
+    std::map <uint32_t, std::string> item{};
+    db_reply <std::map <uint32_t, std::string> > ret = db_reply_new(item);
+
+    const element_t *e = element (element_id);
+    if (e) {
+        for (uint32_t g = e->first_group; g != e->first_group + e->groups; g++) {
+            const element_t *group = element (m_groups [g]);
+            if (group)
+                ret.item [group->id] = str (group->name);
+        }
+    }
+    return ret;
+}
+
+} // namespace
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+void
+fty_common_db_snapshot_test (bool verbose)
+{
+    printf (" * fty_common_db_snapshot: ");
+
+    using namespace DBSnapshot;
+
+    char path [] = "/tmp/fty-common-db-snapshot-XXXXXX";
+    int fd = mkstemp (path);
+    assert (fd >= 0);
+    ::close (fd);
+
+    s_builder_t builder;
+    builder.add_element (3, "ups-3", 3, "device", 1, "ups", 1, "active", 1, "");
+    builder.add_element (1, "datacenter-1", 2, "datacenter", 0, "", 0, "active", 5, "DC");
+    builder.add_element (2, "group-2", 1, "group", 0, "", 0, "nonactive", 5, "");
+    builder.add_element (4, "epdu-4", 3, "device", 3, "epdu", 1, "active", 2, "");
+    // the view returns more rows of one element, the first one is kept
+    builder.add_element (4, "epdu-4", 3, "device", 3, "epdu", 1, "nonactive", 2, "");
+    builder.add_attribute (3, "serial_no", "SN-3", true);
+    builder.add_attribute (3, "name", "UPS 3", false);
+    builder.add_attribute (4, "name", "ePDU 4", false);
+    // attribute of element which is not in the snapshot
+    builder.add_attribute (9, "name", "lost", false);
+    builder.add_link (4, 3, "1", "", INPUT_POWER_CHAIN);
+    builder.add_group (3, 2);
+    builder.add_group (4, 2);
+    assert (builder.write (path, 42) == 0);
+
+    snapshot_t snapshot;
+    assert (!snapshot.is_open ());
+    assert (snapshot.open (path) == 0);
+    assert (snapshot.generation () == 42);
+    assert (snapshot.elements () == 4);
+
+    assert (snapshot.name_to_asset_id ("epdu-4") == 4);
+    assert (snapshot.name_to_asset_id ("datacenter-1") == 1);
+    assert (snapshot.name_to_asset_id ("no-such-asset") == -1);
+    // names match like in the database, case and trailing spaces ignored
+    assert (snapshot.name_to_asset_id ("UPS-3") == 3);
+    assert (snapshot.name_to_asset_id ("Group-2  ") == 2);
+    assert (snapshot.name_to_asset_id ("ups-") == -1);
+    assert (snapshot.name_to_asset_id (" ups-3") == -1);
+    assert (snapshot.select_asset_element_web_byId (4).item.status == "active");
+    assert (snapshot.id_to_name_ext_name (3) == std::make_pair (std::string ("ups-3"), std::string ("UPS 3")));
+    assert (snapshot.id_to_name_ext_name (1).first.empty ());
+
+    auto web = snapshot.select_asset_element_web_byId (3);
+    assert (web.status == 1);
+    assert (web.item.subtype_name == "ups" && web.item.parent_name == "datacenter-1" && web.item.parent_type_id == 2);
+    assert (snapshot.select_asset_element_web_byId (9).errsubtype == DB_ERROR_NOTFOUND);
+
+    auto ext = snapshot.select_ext_attributes (3);
+    assert (ext.status == 1 && ext.item.size () == 2);
+    assert (ext.item ["serial_no"] == std::make_pair (std::string ("SN-3"), true));
+    assert (snapshot.select_ext_attributes (1).item.empty ());
+
+    auto links = snapshot.select_asset_device_links_to (4, INPUT_POWER_CHAIN);
+    assert (links.item.size () == 1);
+    assert (links.item [0].src_id == 3 && links.item [0].src_name == "ups-3" && links.item [0].src_socket == "1");
+    assert (snapshot.select_asset_device_links_to (3, INPUT_POWER_CHAIN).item.empty ());
+
+    auto groups = snapshot.select_asset_element_groups (4);
+    assert (groups.item.size () == 1 && groups.item [2] == "group-2");
+
+    size_t count = 0;
+    snapshot.each_element ([&] (const element_t &) { count++; });
+    assert (count == 4);
+    snapshot.close ();
+
+    // truncated file is refused
+    assert (truncate (path, sizeof (header_t) + 8) == 0);
+    assert (snapshot.open (path) == -1);
+    assert (!snapshot.is_open ());
+
+    unlink (path);
+    printf ("OK\n");
+}
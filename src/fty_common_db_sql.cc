@@ -0,0 +1,183 @@
+/*  =========================================================================
+    fty_common_db_sql - Helpers for building SQL statements
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    fty_common_db_sql - Helpers for building SQL statements
+@discuss
+@end
+*/
+
+#include "fty_common_db_classes.h"
+
+#include <chrono>
+#include <sstream>
+#include <thread>
+#include <time.h>
+
+namespace DBSql {
+
+std::string
+sql_plac (size_t i, size_t j)
+{
+    return "item" + std::to_string(i) + "_" + std::to_string(j);
+}
+
+std::string
+multi_insert_string (const std::string& sql_header,
+                     size_t tuple_len,
+                     size_t items_len,
+                     const std::string& sql_postfix)
+{
+    std::stringstream s{};
+
+    s << sql_header;
+    s << "\nVALUES ";
+    for (size_t i = 0; i != items_len; i++) {
+        s << "(";
+        for (size_t j = 0; j != tuple_len; j++) {
+            s << ":" << sql_plac(i, j);
+            if (j < tuple_len -1)
+                s << ", ";
+        }
+        if (i < items_len -1)
+            s << "),\n";
+        else
+            s << ")\n";
+    }
+    s << sql_postfix;
+    return s.str();
+}
+
+size_t
+insert_chunk (size_t n)
+{
+    size_t chunk = 1;
+    while (chunk * 2 <= n && chunk * 2 <= MAX_INSERT_ROWS)
+        chunk *= 2;
+    return chunk;
+}
+
+std::string
+placeholder (const std::string &prefix, size_t i)
+{
+    return prefix + std::to_string (i);
+}
+
+size_t
+in_list_bucket (size_t n)
+{
+    size_t bucket = 1;
+    while (bucket < n && bucket < MAX_IN_LIST)
+        bucket *= 2;
+    return bucket;
+}
+
+std::string
+in_list (const std::string &prefix, size_t count)
+{
+    std::string ret;
+    for (size_t i = 0; i != count; i++) {
+        if (i != 0)
+            ret += ", ";
+        ret += ":" + placeholder (prefix, i);
+    }
+    return ret;
+}
+
+std::string
+filter_t::value (const std::string &value)
+{
+    std::string name = "s" + std::to_string (m_strings.size ());
+    m_strings.emplace_back (name, value);
+    return ":" + name;
+}
+
+void
+filter_t::bind (tntdb::Statement &st) const
+{
+    for (const auto &it : m_numbers)
+        st.set (it.first, it.second);
+    for (const auto &it : m_strings)
+        st.set (it.first, it.second);
+}
+
+bool
+fold (const std::string &text, std::string &out)
+{
+    bool ascii = true;
+    out.clear ();
+    for (char c : text) {
+        if (static_cast <unsigned char> (c) >= 0x80)
+            ascii = false;
+        out.push_back (c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c);
+    }
+    size_t end = out.find_last_not_of (' ');
+    out.resize (end == std::string::npos ? 0 : end + 1);
+    return ascii;
+}
+
+bool
+optional_table_t::exists (tntdb::Connection &conn)
+{
+    int state = m_state;
+    if (state == 1)
+        return true;
+    int64_t now = static_cast <int64_t> (time (NULL));
+    if (state == 0 && now - m_checked_s < RECHECK_S)
+        return false;
+
+    static const DBStatementCache::query_t st_query (
+        " SELECT COUNT(*)"
+        " FROM"
+        "   information_schema.tables"
+        " WHERE"
+        "   table_schema = DATABASE() AND"
+        "   table_name = :name");
+    tntdb::Statement st = DBStatementCache::prepare (conn, st_query);
+    uint32_t count = 0;
+    st.set ("name", m_name).selectValue ().get (count);
+    if (count != 0 || state == -1)
+        log_debug ("%s is %savailable", m_name, count != 0 ? "" : "not ");
+    m_checked_s = now;
+    m_state = count != 0 ? 1 : 0;
+    return count != 0;
+}
+
+void
+wait_for_writers (tntdb::Connection &conn)
+{
+    // writers remember that a table does not exist for RECHECK_S seconds,
+    // then they see it; read lock of a table waits for transactions which
+    // wrote to it before, they hold its metadata lock until they end
+    std::this_thread::sleep_for (std::chrono::seconds (optional_table_t::RECHECK_S + 1));
+    conn.execute (
+        " LOCK TABLES"
+        "   t_bios_asset_element READ,"
+        "   t_bios_asset_ext_attributes READ,"
+        "   t_bios_asset_link READ,"
+        "   t_bios_asset_group_relation READ,"
+        "   t_bios_monitor_asset_relation READ"
+    );
+    conn.execute ("UNLOCK TABLES");
+}
+
+} // namespace
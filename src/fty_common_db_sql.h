@@ -0,0 +1,185 @@
+/*  =========================================================================
+    fty_common_db_sql - Helpers for building SQL statements
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+#ifndef FTY_COMMON_DB_SQL_H_INCLUDED
+#define FTY_COMMON_DB_SQL_H_INCLUDED
+
+#include <inttypes.h>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <tntdb/connection.h>
+#include <tntdb/statement.h>
+
+// IN-lists are generated with a number of placeholders rounded up to
+// a power of two (in_list_bucket) and unused placeholders are bound to
+// the last value, so there is only a handful of statement shapes for
+// prepareCached and values are always bound, never pasted into SQL.
+namespace DBSql {
+
+// maximal number of placeholders in one IN-list, longer lists must be chunked
+static const size_t MAX_IN_LIST = 256;
+
+// maximal number of rows in one multi-row INSERT, longer lists must be chunked
+static const size_t MAX_INSERT_ROWS = 128;
+
+// sql_plac: generate the placeholder name
+// example: sql_plac(2, 3) -> "item2_3";
+    std::string
+    sql_plac (size_t i, size_t j);
+
+//multi_insert_string: generate the SQL string for multivalue insert
+// Example:
+// multi_insert_string("INSERT INTO t_bios_foo", 2, 3, "ON DUPLICATE KEY ....") ->
+// 'INSERT INTO t_bios_foo (foo, bar)
+// VALUES(:item0_0, :item0_1),
+// (:item1_0, :item1_1),
+// (:item2_0, :item2_1)
+//  ON DUPLICATE KEY UPDATE ...'
+    std::string
+    multi_insert_string (const std::string& sql_header,
+                         size_t tuple_len,
+                         size_t items_len,
+                         const std::string& sql_postfix);
+
+// insert_chunk: number of rows to insert by next multi-row INSERT if n rows remain
+// returns the largest power of two <= n, at most MAX_INSERT_ROWS
+    size_t
+    insert_chunk (size_t n);
+
+// placeholder: generate the placeholder name
+// example: placeholder("id", 3) -> "id3"
+    std::string
+    placeholder (const std::string &prefix, size_t i);
+
+// in_list_bucket: number of placeholders used for a list of n values
+// returns the smallest power of two >= n, at most MAX_IN_LIST
+    size_t
+    in_list_bucket (size_t n);
+
+// in_list: generate comma separated list of placeholders
+// example: in_list("id", 3) -> ":id0, :id1, :id2"
+    std::string
+    in_list (const std::string &prefix, size_t count);
+
+// bind_in_list: bind values [first, first + bucket) to placeholders of
+// the IN-list, positions past the end of values repeat the last value
+// which does not change the result of IN
+template <typename T>
+void
+bind_in_list (tntdb::Statement &st,
+              const std::string &prefix,
+              const std::vector <T> &values,
+              size_t first,
+              size_t bucket)
+{
+    for (size_t i = 0; i != bucket; i++) {
+        size_t j = first + i < values.size () ? first + i : values.size () - 1;
+        st.set (placeholder (prefix, i), values [j]);
+    }
+}
+
+// filter_t: conditions of WHERE clause with values bound to placeholders,
+// lists use bucketed IN-lists, so the number of distinct statements stays
+// small whatever the values are
+class filter_t {
+    public:
+        filter_t () : m_lists (0) {}
+
+        // in: returns "column IN (...)" with placeholders for values
+        // throws std::invalid_argument if there are more than MAX_IN_LIST values
+        template <typename T>
+        std::string
+        in (const std::string &column, const std::vector <T> &values)
+        {
+            if (values.empty () || values.size () > MAX_IN_LIST)
+                throw std::invalid_argument ("wrong number of values for " + column);
+            std::string prefix = "f" + std::to_string (m_lists++) + "_";
+            size_t bucket = in_list_bucket (values.size ());
+            for (size_t i = 0; i != bucket; i++) {
+                const T &v = values [i < values.size () ? i : values.size () - 1];
+                m_numbers.emplace_back (placeholder (prefix, i), v);
+            }
+            return " " + column + " IN (" + in_list (prefix, bucket) + ") ";
+        }
+
+        // value: returns placeholder for value
+        std::string
+        value (const std::string &value);
+
+        // bind: bind all values to st
+        void
+        bind (tntdb::Statement &st) const;
+
+    private:
+        size_t m_lists;
+        std::vector <std::pair <std::string, uint32_t>> m_numbers;
+        std::vector <std::pair <std::string, std::string>> m_strings;
+};
+
+// fold: fold text like the case insensitive collation of the database,
+// ASCII letters in lower case and trailing spaces removed
+// returns false if text has other than ASCII characters, which collation
+// also matches with accented letters; out is then folded only in ASCII
+    bool
+    fold (const std::string &text, std::string &out);
+
+// optional_table_t: existence of table created by some process at run
+// time; once it exists, it is remembered, "does not exist" only for
+// RECHECK_S seconds, creator of the table waits that long for all
+// processes to see it (see wait_for_writers)
+class optional_table_t {
+    public:
+        static const unsigned RECHECK_S = 10;
+
+        explicit optional_table_t (const char *name) : m_name (name), m_state (-1), m_checked_s (0) {}
+
+        // exists: returns true if table exists
+        // throws on database error
+        bool
+        exists (tntdb::Connection &conn);
+
+        // created: the table was created by this process
+        void
+        created () { m_state = 1; }
+
+        const char *
+        name () const { return m_name; }
+
+    private:
+        const char *m_name;
+        // -1 not known yet, 0 table does not exist, 1 table exists
+        std::atomic <int> m_state;
+        std::atomic <int64_t> m_checked_s;
+};
+
+// wait_for_writers: wait until writers which did not see a new optional
+// table see it (RECHECK_S seconds) and transactions which wrote to asset
+// tables before end, so writers which did not see the table are done; conn
+// must not be in a transaction
+// throws on database error
+    void
+    wait_for_writers (tntdb::Connection &conn);
+
+} // namespace
+
+#endif // FTY_COMMON_DB_SQL_H_INCLUDED
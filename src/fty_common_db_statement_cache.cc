@@ -0,0 +1,256 @@
+/*  =========================================================================
+    fty_common_db_statement_cache - Bounded cache of prepared statements
+
+    Copyright (C) 2014 - 2020 Eaton
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+    =========================================================================
+*/
+
+/*
+@header
+    fty_common_db_statement_cache - Bounded cache of prepared statements
+@discuss
+    tntdb keeps statements of prepareCached in the connection and never
+    drops them. This class only decides which keys stay there: it tracks
+    use of keys per connection and calls clearStatementCache (key) on the
+    least recently used one.
+
+    Queries with constant text use key "q<id>". Queries built at runtime
+    use their text as key, like plain prepareCached.
+
+    Connections are told apart by their tntdb implementation. The pool (see
+    DBConn) calls track when it opens a connection and forget before it
+    closes it. Connections owned by callers get bookkeeping on first
+    prepare and keep it while they are among MAX_CALLER_CONNECTIONS most
+    recently used ones, or until forget. Every statement in tntdb cache was
+    prepared here and counted, so a closed connection whose address is
+    reused by a new one only has fewer statements than counted. Connection
+    which gets bookkeeping again after it was dropped may have statements
+    nobody counts, its tntdb cache is cleared first.
+@end
+*/
+
+#include "fty_common_db_classes.h"
+
+#include <assert.h>
+#include <atomic>
+#include <mutex>
+
+namespace DBStatementCache {
+
+static std::atomic <uint32_t> s_next_id {0};
+
+static std::mutex s_mutex;
+static size_t s_capacity = DEFAULT_CAPACITY;
+// connection_t: bookkeeping of one connection
+struct connection_t {
+    lru_t lru;
+    bool pooled;
+    // position in s_callers, for connections not owned by the pool
+    std::list <const tntdb::IConnection*>::iterator use;
+};
+
+static std::unordered_map <const tntdb::IConnection*, connection_t> s_connections;
+// connections owned by callers, most recently used first
+static std::list <const tntdb::IConnection*> s_callers;
+static stats_t s_stats {0, 0, 0, 0, 0, 0};
+
+query_t::query_t (const char *sql) :
+    m_sql (sql),
+    m_id (s_next_id++),
+    m_key ("q" + std::to_string (m_id))
+{
+}
+
+bool
+lru_t::touch (const std::string &key,
+              size_t capacity,
+              std::vector <std::string> &evicted)
+{
+    auto it = m_index.find (key);
+    bool known = it != m_index.end ();
+    if (known)
+        m_keys.splice (m_keys.begin (), m_keys, it->second);
+    else {
+        m_keys.push_front (key);
+        m_index.emplace (key, m_keys.begin ());
+    }
+    while (m_keys.size () > capacity && m_keys.size () > 1) {
+        evicted.push_back (m_keys.back ());
+        m_index.erase (m_keys.back ());
+        m_keys.pop_back ();
+    }
+    return known;
+}
+
+void
+set_capacity (size_t capacity)
+{
+    std::lock_guard <std::mutex> lock (s_mutex);
+    s_capacity = capacity;
+}
+
+size_t
+capacity ()
+{
+    std::lock_guard <std::mutex> lock (s_mutex);
+    return s_capacity;
+}
+
+// s_drop: drop bookkeeping of connection, s_mutex must be held
+static void
+s_drop (std::unordered_map <const tntdb::IConnection*, connection_t>::iterator it)
+{
+    s_stats.statements -= it->second.lru.size ();
+    if (!it->second.pooled)
+        s_callers.erase (it->second.use);
+    s_connections.erase (it);
+}
+
+// s_caller: returns bookkeeping of connection owned by caller, created if
+// there is none; s_mutex must be held
+static connection_t &
+s_caller (const tntdb::IConnection *impl, bool &created)
+{
+    auto it = s_connections.find (impl);
+    created = it == s_connections.end ();
+    if (!created) {
+        if (!it->second.pooled)
+            s_callers.splice (s_callers.begin (), s_callers, it->second.use);
+        return it->second;
+    }
+
+    s_callers.push_front (impl);
+    connection_t &c = s_connections [impl];
+    c.pooled = false;
+    c.use = s_callers.begin ();
+    while (s_callers.size () > MAX_CALLER_CONNECTIONS) {
+        s_drop (s_connections.find (s_callers.back ()));
+        s_stats.dropped++;
+    }
+    return c;
+}
+
+// s_prepare: prepare statement under key and evict statements over capacity
+static tntdb::Statement
+s_prepare (tntdb::Connection &conn, const char *sql, const std::string &key)
+{
+    std::vector <std::string> evicted;
+    bool created = false;
+    {
+        std::lock_guard <std::mutex> lock (s_mutex);
+        lru_t &lru = s_caller (conn.getImpl (), created).lru;
+        size_t before = lru.size ();
+        if (lru.touch (key, s_capacity, evicted))
+            s_stats.hits++;
+        else
+            s_stats.misses++;
+        s_stats.evictions += evicted.size ();
+        s_stats.statements += lru.size ();
+        s_stats.statements -= before;
+    }
+    if (created)
+        conn.clearStatementCache ();
+    for (const auto &k : evicted)
+        conn.clearStatementCache (k);
+    return conn.prepareCached (sql, key);
+}
+
+tntdb::Statement
+prepare (tntdb::Connection &conn, const query_t &query)
+{
+    return s_prepare (conn, query.sql (), query.key ());
+}
+
+tntdb::Statement
+prepare (tntdb::Connection &conn, const std::string &sql)
+{
+    return s_prepare (conn, sql.c_str (), sql);
+}
+
+void
+track (const tntdb::Connection &conn)
+{
+    std::lock_guard <std::mutex> lock (s_mutex);
+    auto it = s_connections.find (conn.getImpl ());
+    if (it != s_connections.end ())
+        s_drop (it);
+    s_connections [conn.getImpl ()].pooled = true;
+}
+
+void
+forget (const tntdb::Connection &conn)
+{
+    std::lock_guard <std::mutex> lock (s_mutex);
+    auto it = s_connections.find (conn.getImpl ());
+    if (it != s_connections.end ())
+        s_drop (it);
+}
+
+stats_t
+stats ()
+{
+    std::lock_guard <std::mutex> lock (s_mutex);
+    stats_t stats = s_stats;
+    stats.connections = s_connections.size ();
+    return stats;
+}
+
+void
+reset_stats ()
+{
+    std::lock_guard <std::mutex> lock (s_mutex);
+    s_stats.hits = s_stats.misses = s_stats.evictions = s_stats.dropped = 0;
+}
+
+} // namespace
+
+//  --------------------------------------------------------------------------
+//  Self test of this class
+
+void
+fty_common_db_statement_cache_test (bool verbose)
+{
+    printf (" * fty_common_db_statement_cache: ");
+
+    DBStatementCache::query_t q1 ("SELECT 1");
+    DBStatementCache::query_t q2 ("SELECT 2");
+    assert (q1.id () != q2.id ());
+    assert (q1.key () != q2.key ());
+    assert (std::string (q2.sql ()) == "SELECT 2");
+
+    DBStatementCache::lru_t lru;
+    std::vector <std::string> evicted;
+    assert (!lru.touch ("a", 2, evicted));
+    assert (!lru.touch ("b", 2, evicted));
+    assert (lru.touch ("a", 2, evicted));
+    assert (evicted.empty ());
+
+    // b is the least recently used
+    assert (!lru.touch ("c", 2, evicted));
+    assert (evicted.size () == 1 && evicted [0] == "b");
+    assert (lru.size () == 2);
+    assert (lru.touch ("a", 2, evicted));
+    assert (lru.touch ("c", 2, evicted));
+
+    // lower capacity evicts on next use
+    evicted.clear ();
+    assert (lru.touch ("c", 1, evicted));
+    assert (evicted.size () == 1 && evicted [0] == "a");
+    assert (lru.size () == 1);
+
+    printf ("OK\n");
+}
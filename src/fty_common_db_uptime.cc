@@ -26,7 +26,7 @@
 @end
 */
 
-#include <fty_common_db_uptime.h>
+#include "fty_common_db_classes.h"
 
 namespace DBUptime {
 bool
@@ -52,7 +52,8 @@ get_dc_upses (const char *asset_name, zhash_t *hash)
     if (dc_id < 0) {
         return false;
     }
-    tntdb::Connection conn = tntdb::connectCached (DBConn::url);
+    DBConn::connection_t pooled;
+    tntdb::Connection &conn = pooled.get ();
 
     int rv = DBAssets::select_assets_by_container (conn,
                                          dc_id,
@@ -63,7 +64,6 @@ get_dc_upses (const char *asset_name, zhash_t *hash)
                                          cb);
 
     if (rv != 0) {
-        conn.close ();
         return false;
     }
 
@@ -77,7 +77,6 @@ get_dc_upses (const char *asset_name, zhash_t *hash)
 
     }
 
-    conn.close ();
     return true;
 }
 